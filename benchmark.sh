@@ -1,3 +1,10 @@
 #!/bin/bash
 
-deno run --allow-read --allow-net ./test/benchmark.js
\ No newline at end of file
+# ./benchmark.sh [--iterations n] [--warmup n] [--filter text] > results.json
+# ./benchmark.sh --compare base.json head.json [--threshold 0.1]
+if [ "$1" = "--compare" ]; then
+    shift
+    deno run --allow-read ./test/benchmark_compare.js "$@"
+else
+    deno run --allow-read ./test/benchmark.js "$@"
+fi
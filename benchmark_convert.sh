@@ -0,0 +1,16 @@
+#!/bin/bash
+
+set -e
+
+if [ -z ${EMSDK+x} ]; then
+    source "./emsdk/emsdk_env.sh"
+fi
+
+mkdir -p build
+
+emcc test/convert_bench.cpp src/convert.cpp \
+    -iwithsysroot/include/freetype2 \
+    -O3 -msimd128 \
+    -o build/convert_bench.js
+
+node build/convert_bench.js "$@"
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+node ./test/benchmark_threads.js "$@"
@@ -10,17 +10,68 @@ if [ ! -d "./dist" ]; then
     mkdir dist
 fi
 
+SYSROOT="$EMSDK/upstream/emscripten/cache/sysroot"
+LIB_DIR="$SYSROOT/lib"
+INCLUDE_FLAGS=(-iwithsysroot/include/freetype2)
+THREAD_FLAGS=()
+STATS_FLAGS=()
+HARFBUZZ_FLAGS=()
+OUTPUT=dist/freetype.js
+
+# STATS=1 collects the hot path counters and timers of `GetStats`
+if [ "$STATS" = "1" ]; then
+    STATS_FLAGS=(-D FT_WASM_STATS=1)
+fi
+
+# HARFBUZZ=1 compiles in HarfBuzz for `ShapeText`, from the amalgamated
+# source of the harfbuzz checkout, see deps.sh
+if [ "$HARFBUZZ" = "1" ]; then
+    HARFBUZZ_FLAGS=(harfbuzz/src/harfbuzz.cc -I harfbuzz/src -D FT_WASM_HARFBUZZ=1)
+fi
+
+# THREADS=<n> builds dist/freetype-threads.js with a pool of n pthreads, the
+# libraries come from `THREADS=<n> ./build_brotli.sh` and `./build_freetype.sh`
+if [ -n "$THREADS" ]; then
+    LIB_DIR="$(pwd)/build/threads/lib"
+    INCLUDE_FLAGS=(-I"$(pwd)/build/threads/include/freetype2")
+    THREAD_FLAGS=(
+        -pthread
+        -s PTHREAD_POOL_SIZE="$THREADS"
+        -D FT_WASM_MAX_THREADS="$THREADS"
+    )
+    OUTPUT=dist/freetype-threads.js
+fi
+
 emcc src/ft.cpp \
-    "$EMSDK/upstream/emscripten/cache/sysroot/lib/libfreetype.a" \
-    "$EMSDK/upstream/emscripten/cache/sysroot/lib/libbrotlidec.a" \
-    "$EMSDK/upstream/emscripten/cache/sysroot/lib/libbrotlicommon.a" \
-    -iwithsysroot/include/freetype2 \
+    src/atlas.cpp \
+    src/char_coverage.cpp \
+    src/convert.cpp \
+    src/core.cpp \
+    src/face_scan.cpp \
+    src/ft_memory.cpp \
+    src/glyph_cache.cpp \
+    src/glyph_snapshot.cpp \
+    src/layout.cpp \
+    src/outline.cpp \
+    src/parallel_raster.cpp \
+    src/sdf.cpp \
+    src/shaper.cpp \
+    src/webfont.cpp \
+    src/worker_pool.cpp \
+    "$LIB_DIR/libfreetype.a" \
+    "$LIB_DIR/libbrotlidec.a" \
+    "$LIB_DIR/libbrotlicommon.a" \
+    "${INCLUDE_FLAGS[@]}" \
+    "${THREAD_FLAGS[@]}" \
+    "${STATS_FLAGS[@]}" \
+    "${HARFBUZZ_FLAGS[@]}" \
     -O3 -msimd128 \
     -lembind \
+    -s ALLOW_MEMORY_GROWTH=1 \
     -s EXPORT_ES6=1 \
     -s MODULARIZE=1 \
     -s EXPORT_NAME=FreeType \
-    -o dist/freetype.js
+    -o "$OUTPUT"
 
 # Prepend texts to the built file
 printf '%s\n/*!\n%s\n%s\n\n%s\n%s\n\n%s\n%s\n*/\n%s\n' \
@@ -31,14 +82,18 @@ printf '%s\n/*!\n%s\n%s\n\n%s\n%s\n\n%s\n%s\n*/\n%s\n' \
     "https://github.com/freetype/freetype/blob/master/LICENSE.TXT" \
     "Uses Brotli for WOFF2 fonts, MIT license:" \
     "https://github.com/google/brotli/blob/master/LICENSE" \
-    "$(cat dist/freetype.js)" \
-    > dist/freetype.js
+    "$(cat "$OUTPUT")" \
+    > "$OUTPUT"
 
 # Deno does not like XMLHttpRequest, and emscripten uses old school XHR
 # Following trick replaces the required one with `fetch`
-sed -i 's|\(readAsync\s*=\s*(url,\s*onload,\s*onerror)\s*=>\s*{\)|\1fetch(url).then(async response => { onload(await response.arrayBuffer());}).catch(onerror); return;|g' dist/freetype.js
+sed -i 's|\(readAsync\s*=\s*(url,\s*onload,\s*onerror)\s*=>\s*{\)|\1fetch(url).then(async response => { onload(await response.arrayBuffer());}).catch(onerror); return;|g' "$OUTPUT"
 
 echo "✅ Build finished"
 
-./test.sh
+if [ -n "$THREADS" ]; then
+    ./test_threads.sh
+else
+    ./test.sh
+fi
 
@@ -4,10 +4,19 @@ if [ -z ${EMSDK+x} ]; then
     source "./emsdk/emsdk_env.sh" || exit
 fi
 
-mkdir -p brotli/buildc
+BUILD_DIR=brotli/buildc
+CMAKE_ARGS=()
+if [ -n "$THREADS" ]; then
+    # Shared memory needs every object compiled with atomics, the pthreads
+    # build is installed to its own prefix
+    BUILD_DIR=brotli/buildc-threads
+    CMAKE_ARGS=(-D CMAKE_C_FLAGS=-pthread -D CMAKE_INSTALL_PREFIX="$(pwd)/build/threads")
+fi
+
+mkdir -p "$BUILD_DIR"
 (
-    cd brotli/buildc || exit
-    emcmake cmake ..
+    cd "$BUILD_DIR" || exit
+    emcmake cmake "${CMAKE_ARGS[@]}" ..
     emmake make
     emmake make install
 )
\ No newline at end of file
@@ -4,11 +4,26 @@ if [ -z ${EMSDK+x} ]; then
     source "./emsdk/emsdk_env.sh" || exit
 fi
 
-mkdir -p freetype2/build
+BUILD_DIR=freetype2/build
+BROTLIDEC_LIBRARIES="$EMSDK/upstream/emscripten/cache/sysroot/lib/libbrotlidec-static.a"
+CMAKE_ARGS=()
+if [ -n "$THREADS" ]; then
+    # Links the pthreads build of Brotli, see build_brotli.sh
+    BUILD_DIR=freetype2/build-threads
+    BROTLIDEC_LIBRARIES="$(pwd)/build/threads/lib/libbrotlidec-static.a"
+    CMAKE_ARGS=(
+        -D CMAKE_C_FLAGS=-pthread
+        -D CMAKE_INSTALL_PREFIX="$(pwd)/build/threads"
+        -D BROTLIDEC_INCLUDE_DIRS="$(pwd)/build/threads/include"
+    )
+fi
+
+mkdir -p "$BUILD_DIR"
 (
-    cd freetype2/build || exit
+    cd "$BUILD_DIR" || exit
     emcmake cmake \
-        -D BROTLIDEC_LIBRARIES="$EMSDK/upstream/emscripten/cache/sysroot/lib/libbrotlidec-static.a" \
+        "${CMAKE_ARGS[@]}" \
+        -D BROTLIDEC_LIBRARIES="$BROTLIDEC_LIBRARIES" \
         -D FT_DISABLE_ZLIB=TRUE \
         -D FT_DISABLE_BZIP2=TRUE \
         -D FT_DISABLE_PNG=TRUE \
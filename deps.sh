@@ -2,4 +2,5 @@
 
 git clone https://github.com/emscripten-core/emsdk
 git clone https://github.com/Google/brotli
-git clone https://github.com/freetype/freetype freetype2
\ No newline at end of file
+git clone https://github.com/freetype/freetype freetype2
+git clone https://github.com/harfbuzz/harfbuzz
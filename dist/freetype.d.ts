@@ -8,8 +8,96 @@ export default function Freetype(initial?: {
 }): Promise<FreetypeModule>;
 
 interface FreetypeModule {
+  /**
+   * Copies the font to the wasm memory and opens its faces. Identical fonts
+   * are stored once, loading a font again returns its open faces.
+   */
   LoadFontFromBytes: (bytes: Uint8Array | number[]) => FT_FaceRec[];
 
+  /**
+   * Allocates `size` bytes for a font in the wasm memory and returns their
+   * address, 0 if it fails. Write the font to the view of
+   * `GetFontBufferView` and load it with `LoadFontFromBuffer`.
+   */
+  AllocateFontBuffer: (size: number) => number;
+
+  /**
+   * View of an `AllocateFontBuffer` address. It detaches when the memory
+   * grows, fetch it again after other calls into the module.
+   */
+  GetFontBufferView: (address: number) => Uint8Array | null;
+
+  /** Loads the font of an `AllocateFontBuffer` address without copying it */
+  LoadFontFromBuffer: (address: number) => FT_FaceRec[];
+
+  /** Frees an `AllocateFontBuffer` address that is not loaded */
+  FreeFontBuffer: (address: number) => void;
+
+  GetFontStorageStats: () => FontStorageStats;
+
+  /**
+   * Counters and cumulative timers of the hot paths. Only collected when the
+   * module is built with `STATS=1`, see `STATS_ENABLED`.
+   */
+  GetStats: () => HotPathStats;
+
+  ResetStats: () => void;
+
+  /**
+   * Loads a font or collection without opening its faces, names and style
+   * flags are read from the font tables. A face is opened when it's set with
+   * `SetFont` or a size is created with its handle.
+   */
+  LoadFontCollection: (bytes: Uint8Array | number[]) => FaceInfo[];
+
+  /** Like `LoadFontCollection` for an `AllocateFontBuffer` address */
+  LoadFontCollectionFromBuffer: (address: number) => FaceInfo[];
+
+  /**
+   * Faces of `LoadFontCollection` idle longer than this are closed. Faces
+   * that are current, or have sizes or atlases stay open. 0 keeps faces
+   * open, which is the default.
+   */
+  SetFaceIdleTimeout: (timeout_ms: number) => void;
+
+  /**
+   * Closes idle faces, returns the number of faces closed. Also done on
+   * `SetFont` and `LoadFontCollection`.
+   */
+  EvictIdleFaces: () => number;
+
+  IsFaceOpen: (face_handle: number) => boolean;
+
+  /**
+   * Format of the font the face was loaded from. WOFF and WOFF2 fonts are
+   * decoded once when loaded, faces are opened from the decoded sfnt.
+   */
+  GetFontSourceInfo: (face_handle: number) => FontSourceInfo | null;
+
+  /**
+   * Unicode coverage table of the face, built once when the face is first
+   * opened. Faces of `LoadFontCollection` are opened to build it.
+   */
+  GetFaceCoverage: (face_handle: number) => CoverageInfo | null;
+
+  /** FreeType heap usage of the library and all faces */
+  GetMemoryStats: () => MemoryStats;
+
+  /**
+   * FreeType heap usage of the face, including its sizes and glyph loading.
+   * Font bytes and cached glyphs are not FreeType allocations, see
+   * `GetFontStorageStats` and `GetGlyphCacheStats`.
+   */
+  GetFaceMemoryStats: (face_handle: number) => MemoryStats | null;
+
+  ResetMemoryPeaks: () => void;
+
+  /** FreeType allocations that would go over the limit fail, 0 is no limit */
+  SetMemoryLimit: (bytes: number) => void;
+
+  /** Bytes reserved by the pools of small FreeType allocations */
+  GetMemoryPoolBytes: () => number;
+
   UnloadFont: (familyName: string) => void;
 
   SetFont: (familyName: string, styleName: string) => FT_FaceRec;
@@ -36,17 +124,557 @@ interface FreetypeModule {
     use_sdf: boolean
   ) => Map<number, FT_GlyphSlotRec>;
 
+  /**
+   * Like `LoadGlyphsFromCharmap`, but returns after `max_glyphs` glyphs or
+   * `time_budget_ms` milliseconds, 0 is no limit. Continue with
+   * `next_charcode` as the first charcode until `done`.
+   */
+  LoadGlyphsFromCharmapSliced: (
+    first_charcode: number,
+    last_charcode: number,
+    load_flags: number,
+    use_sdf: boolean,
+    max_glyphs: number,
+    time_budget_ms: number
+  ) => GlyphSlice<FT_GlyphSlotRec>;
+
+  /**
+   * Like `LoadGlyphs`, but bitmaps are not converted to `ImageData`. Coverage
+   * bytes are appended to the glyph buffer, see `GetGlyphBuffer`.
+   */
+  LoadGlyphViews: (
+    charcodes: number[],
+    load_flags: number,
+    use_sdf: boolean
+  ) => Map<number, GlyphView>;
+
+  LoadGlyphViewsFromCharmap: (
+    first_charcode: number,
+    last_charcode: number,
+    load_flags: number,
+    use_sdf: boolean
+  ) => Map<number, GlyphView>;
+
+  LoadGlyphViewsFromCharmapSliced: (
+    first_charcode: number,
+    last_charcode: number,
+    load_flags: number,
+    use_sdf: boolean,
+    max_glyphs: number,
+    time_budget_ms: number
+  ) => GlyphSlice<GlyphView>;
+
+  /**
+   * View to the glyph buffer in the wasm memory. The view is invalidated by
+   * the next load call, so get a new one after loading.
+   */
+  GetGlyphBuffer: () => Uint8Array;
+
+  ClearGlyphBuffer: () => void;
+
+  /**
+   * Measures the text with the size handle, without loading or rendering
+   * glyphs. Lines are broken at spaces and after hyphens to `max_width` in
+   * 26.6 pixels, 0 doesn't break lines. `flags` are `TEXT_LAYOUT_*` bits.
+   */
+  MeasureText: (size_handle: number, text: string, max_width: number, flags: number) => TextMetrics;
+
+  /**
+   * Same as `MeasureText`, and stores the glyph and line rows for
+   * `GetLayoutGlyphs` and `GetLayoutLines`.
+   */
+  LayoutText: (size_handle: number, text: string, max_width: number, flags: number) => TextMetrics;
+
+  /**
+   * `TEXT_GLYPH_SIZE` ints per glyph of the last `LayoutText` call: glyph
+   * index, pen x, baseline y and the index of the glyph's character in the
+   * text. Valid until the next call.
+   */
+  GetLayoutGlyphs: () => Int32Array;
+
+  /**
+   * `TEXT_LINE_SIZE` ints per line of the last `LayoutText` call: first glyph,
+   * glyph count, width without trailing spaces and baseline y.
+   */
+  GetLayoutLines: () => Int32Array;
+
+  /**
+   * Lays out the text like `LayoutText` and renders every glyph into one
+   * `width` x `height` buffer, baselines at the layout's rows and clipped to
+   * the buffer. `TEXT_LAYOUT_WRAP` breaks lines at `width`. `format` is a
+   * `BITMAP_FORMAT_*`, `color` 0xRRGGBB for the RGBA formats. Returns a view
+   * valid until the next call, or null.
+   */
+  RenderText: (
+    size_handle: number,
+    text: string,
+    width: number,
+    height: number,
+    flags: number,
+    format: number,
+    color: number
+  ) => Uint8Array | null;
+
+  /**
+   * Picks the first face of `face_handles` that covers each character of the
+   * text, with lookups in the coverage tables only. Returns the number of
+   * rows for `GetFallbackGlyphs`, or -1 if no face handle is known.
+   */
+  ResolveFallback: (face_handles: Int32Array | number[], text: string) => number;
+
+  /**
+   * `FALLBACK_GLYPH_SIZE` ints per character of the last `ResolveFallback`
+   * call: face handle, glyph index and the index of the character in the
+   * text. Characters no face covers get the first face and glyph index 0.
+   * Valid until the next call.
+   */
+  GetFallbackGlyphs: () => Int32Array;
+
+  /**
+   * Loads the outlines of the glyph indices with the current font and size,
+   * without loading bitmaps or rendering, and returns the number of glyphs.
+   * Outlines are cached per glyph. `FT_LOAD_NO_SCALE` gives font units to
+   * draw at any scale.
+   */
+  LoadOutlines: (glyph_indices: Uint32Array | number[], load_flags: number) => number;
+
+  LoadOutlinesWithSize: (
+    size_handle: number,
+    glyph_indices: Uint32Array | number[],
+    load_flags: number
+  ) => number;
+
+  /**
+   * `OUTLINE_GLYPH_SIZE` ints per glyph of the last `LoadOutlines` call:
+   * glyph index, first command, command count, first point, point count and
+   * x advance. Valid until the next call.
+   */
+  GetOutlineGlyphs: () => Int32Array;
+
+  /**
+   * `OUTLINE_*` commands. Move and line take one point, conic two, cubic
+   * three and close none.
+   */
+  GetOutlineCommands: () => Uint8Array;
+
+  /**
+   * x, y pairs in 26.6 pixels, or font units with `FT_LOAD_NO_SCALE`. The y
+   * axis points up.
+   */
+  GetOutlinePoints: () => Int32Array;
+
+  SetOutlineCacheBudget: (bytes: number) => void;
+  GetOutlineCacheStats: () => LruCacheStats;
+  ResetOutlineCacheStats: () => void;
+  ClearOutlineCache: () => void;
+
+  /**
+   * Renders signed distance fields of the charcodes once at the canonical
+   * `pixel_size`. For another display size, scale the metrics and the
+   * spread by display size / `pixel_size`. `spread` is 2 to 32 pixels.
+   * `renderer` is one of `SDF_RENDERER_*`. The auto renderer measures both
+   * renderers on the first glyphs and picks the faster one per glyph.
+   * Characters the face doesn't have are left out.
+   */
+  RenderSdf: (
+    face_handle: number,
+    charcodes: Uint32Array | number[],
+    pixel_size: number,
+    spread: number,
+    renderer: number,
+    load_flags: number
+  ) => SdfBatchInfo;
+
+  /**
+   * `SDF_GLYPH_SIZE` ints per glyph of the last `RenderSdf` call: charcode,
+   * glyph index, renderer, width, rows, bitmap left, bitmap top, x advance
+   * in 26.6 pixels and the offset in `GetSdfPixels`. Valid until the next
+   * call.
+   */
+  GetSdfGlyphs: () => Int32Array;
+
+  /** Fields of the last `RenderSdf` call, rows are `width` bytes */
+  GetSdfPixels: () => Uint8Array;
+
+  /**
+   * Shapes the text with HarfBuzz with the size handle, returns the number of
+   * glyphs or -1. `features` is a comma separated list of OpenType features,
+   * e.g. "liga=0,+smcp". Needs a build with `HARFBUZZ=1`, see
+   * `SHAPING_ENABLED`. Runs are cached by face, size, features and text.
+   */
+  ShapeText: (size_handle: number, text: string, features: string) => number;
+
+  /**
+   * `SHAPED_GLYPH_SIZE` ints per glyph of the last `ShapeText` call: glyph
+   * index, cluster, x advance, y advance, x offset and y offset in 26.6
+   * pixels. Valid until the next call.
+   */
+  GetShapedGlyphs: () => Int32Array;
+
+  /** Byte budget of the shaped run cache, 0 disables it */
+  SetShapeCacheBudget: (bytes: number) => void;
+  GetShapeCacheStats: () => LruCacheStats;
+  ResetShapeCacheStats: () => void;
+  ClearShapeCache: () => void;
+
+  /**
+   * Loads the glyphs of the current font and size, and writes their metrics
+   * to int columns instead of objects, see `GetGlyphMetricsColumn`. Returns
+   * the number of glyphs loaded. Bitmaps are appended to the glyph buffer.
+   */
+  LoadGlyphMetrics: (
+    charcodes: Uint32Array | number[],
+    load_flags: number,
+    use_sdf: boolean
+  ) => number;
+
+  LoadGlyphMetricsWithSize: (
+    size_handle: number,
+    charcodes: Uint32Array | number[],
+    load_flags: number,
+    use_sdf: boolean
+  ) => number;
+
+  /**
+   * Column `GLYPH_METRICS_*` of the last `LoadGlyphMetrics` call, one value
+   * per loaded glyph. Lengths are in 26.6 pixels, bitmap values in pixels.
+   * The view is valid until the next call.
+   */
+  GetGlyphMetricsColumn: (column: number) => Int32Array | null;
+
+  /** Converts the bitmap of a glyph view to RGBA `ImageData` */
+  GetGlyphImageData: (bitmap: BitmapView) => ImageData | null;
+
+  /**
+   * Creates a glyph atlas for the current font and size, returns the atlas id
+   * or -1. Glyphs are rendered to 8-bit (or SDF) pages of `width` x `height`
+   * pixels with `padding` pixels between glyphs.
+   */
+  CreateAtlas: (
+    width: number,
+    height: number,
+    padding: number,
+    load_flags: number,
+    use_sdf: boolean
+  ) => number;
+
+  DestroyAtlas: (atlas_id: number) => void;
+
+  /**
+   * Adds glyphs to the atlas, glyphs already in the atlas are not rendered
+   * again. Returns the entry index of each charcode, or -1 if the glyph is
+   * missing or doesn't fit. The view is valid until the next call.
+   */
+  AtlasAddGlyphs: (atlas_id: number, charcodes: number[]) => Int32Array | null;
+
+  /**
+   * Metrics table with `ATLAS_ENTRY_SIZE` floats per entry: glyph_index, page,
+   * x, y, width, height, u0, v0, u1, v1, bitmap_left, bitmap_top, advance_x,
+   * advance_y. Advances are in pixels.
+   */
+  AtlasGetEntries: (atlas_id: number) => Float32Array | null;
+
+  AtlasGetPageCount: (atlas_id: number) => number;
+
+  /** 8-bit pixels of the atlas page, view to the wasm memory */
+  AtlasGetPage: (atlas_id: number, page: number) => Uint8Array | null;
+
+  /**
+   * Rectangles changed after the last `AtlasClearDirtyRects` as
+   * `[page, x, y, width, height, ...]`, at most one per page
+   */
+  AtlasGetDirtyRects: (atlas_id: number) => Int32Array | null;
+
+  AtlasClearDirtyRects: (atlas_id: number) => void;
+
+  /**
+   * Converts the bitmap of a glyph view to one of `BITMAP_FORMAT_*`, coverage
+   * is drawn with `color` (0xRRGGBB). The view to the converted pixels is
+   * valid until the next call.
+   */
+  ConvertGlyphBitmap: (
+    bitmap: BitmapView,
+    format: number,
+    color: number
+  ) => Uint8Array | null;
+
+  /**
+   * Sets the byte budget of the glyph cache, least recently used glyphs are
+   * evicted when the cache goes over it. Budget of 0 disables the cache.
+   */
+  SetGlyphCacheBudget: (bytes: number) => void;
+
+  GetGlyphCacheStats: () => LruCacheStats;
+  ResetGlyphCacheStats: () => void;
+  ClearGlyphCache: () => void;
+
+  /**
+   * Snapshot of the rendered glyphs in the glyph cache with their metrics,
+   * to be stored and imported by a later run. The view is valid until the
+   * next call.
+   */
+  ExportGlyphSnapshot: () => Uint8Array;
+
+  /**
+   * Imports a snapshot of `ExportGlyphSnapshot`, glyphs that are not cached
+   * are then taken from it instead of rendering them. Only the header is
+   * read, entries of fonts whose bytes changed are never used. Clears the
+   * glyph cache. Returns the number of entries, or -1 if the snapshot is
+   * from another version.
+   */
+  ImportGlyphSnapshot: (snapshot: Uint8Array) => number;
+
+  /**
+   * Allocates `size` bytes for a snapshot in the wasm memory and returns
+   * their address, 0 if it's too small. Write the snapshot to the view of
+   * `GetGlyphSnapshotBufferView` and import it in place with
+   * `ImportGlyphSnapshotFromBuffer`.
+   */
+  AllocateGlyphSnapshotBuffer: (size: number) => number;
+
+  /**
+   * View of an `AllocateGlyphSnapshotBuffer` address. It detaches when the
+   * memory grows, fetch it again after other calls into the module.
+   */
+  GetGlyphSnapshotBufferView: (address: number) => Uint8Array | null;
+
+  /** `ImportGlyphSnapshot` of an `AllocateGlyphSnapshotBuffer` address, used in place */
+  ImportGlyphSnapshotFromBuffer: (address: number) => number;
+
+  /** Frees an `AllocateGlyphSnapshotBuffer` address that is not imported */
+  FreeGlyphSnapshotBuffer: (address: number) => void;
+
+  /**
+   * `GLYPH_SNAPSHOT_ENTRY_SIZE` ints per glyph of the imported snapshot:
+   * font hash low and high, font size, face index, x and y scale, load
+   * flags, x offset, glyph index, linear advances, advance, the 8 glyph
+   * metrics, format, bitmap left and top, rows, width, pitch, pixel mode,
+   * gray levels, and the offset and length of the pixels.
+   */
+  GetGlyphSnapshotEntries: () => Int32Array;
+  GetGlyphSnapshotPixels: () => Uint8Array;
+  ClearGlyphSnapshot: () => void;
+
   GetKerning: (
     left_glyph_index: number,
     right_glyph_index: number,
     kern_mode: number
   ) => FT_Vector;
 
+  /**
+   * Kerning of every pair of the glyphs in one call, `KERNING_PAIR_SIZE` ints
+   * per pair: left glyph index, right glyph index and horizontal kerning.
+   * Pairs are sorted by left and then right glyph index, pairs without
+   * kerning are left out. `FT_KERNING_UNSCALED` gives font units to scale on
+   * the client. The view is valid until the next call.
+   */
+  GetKerningPairs: (glyph_indices: Uint32Array | number[], kern_mode: number) => Int32Array | null;
+
   SetCharmap: (encoding: number) => FT_CharMapRec;
   SetCharmapByIndex: (index: number) => FT_CharMapRec;
 
+  /**
+   * Handle of a loaded face, or -1. Handles let several faces and sizes be
+   * used without `SetFont` and `SetPixelSize`, they are invalidated by
+   * `UnloadFont`.
+   */
+  GetFaceHandle: (familyName: string, styleName: string) => number;
+
+  /**
+   * Creates a size of the face, returns the size handle or -1. The same
+   * request returns the same handle. Each size keeps its own metrics and
+   * hinting state.
+   */
+  CreatePixelSize: (
+    face_handle: number,
+    pixel_width: number,
+    pixel_height: number
+  ) => number;
+
+  CreateCharSize: (
+    face_handle: number,
+    char_width: number,
+    char_height: number,
+    horz_resolution: number,
+    vert_resolution: number
+  ) => number;
+
+  /** Frees the size, atlases created with it are destroyed */
+  DestroySize: (size_handle: number) => void;
+
+  GetSizeMetrics: (size_handle: number) => FT_Size_Metrics | null;
+
+  /** Selects the charmap of the face, used by the `*WithSize` calls */
+  SetFaceCharmap: (face_handle: number, encoding: number) => FT_CharMapRec | null;
+
+  /** Axes of a variable face and the coordinates of the handle, or null */
+  GetVariationInfo: (face_handle: number) => VariationInfo | null;
+
+  /**
+   * Face handle of the instance at the design coordinates, one per axis, or
+   * -1. Coordinates are snapped to `VARIATION_AXIS_STEPS` steps of each axis
+   * range and each snapped instance is created once. It has its own sizes
+   * and cached glyphs, so switching back to it renders nothing again. The
+   * default coordinates return the face itself.
+   */
+  GetVariationInstance: (face_handle: number, coords: number[]) => number;
+
+  /** Face handle of the named instance, counted from 0, or -1 */
+  GetNamedInstance: (face_handle: number, instance_index: number) => number;
+
+  /**
+   * Closes the instances of the face, their handles and sizes are
+   * invalidated. Returns the number of instances.
+   */
+  ClearVariationInstances: (face_handle: number) => number;
+
+  LoadGlyphsWithSize: (
+    size_handle: number,
+    charcodes: number[],
+    load_flags: number,
+    use_sdf: boolean
+  ) => Map<number, FT_GlyphSlotRec>;
+
+  LoadGlyphsFromCharmapWithSize: (
+    size_handle: number,
+    first_charcode: number,
+    last_charcode: number,
+    load_flags: number,
+    use_sdf: boolean
+  ) => Map<number, FT_GlyphSlotRec>;
+
+  LoadGlyphViewsWithSize: (
+    size_handle: number,
+    charcodes: number[],
+    load_flags: number,
+    use_sdf: boolean
+  ) => Map<number, GlyphView>;
+
+  /**
+   * Glyph views of the charcodes at `bins` subpixel x offsets, the view at
+   * index `i` is rendered moved right by i / bins pixels. Each bin is cached
+   * apart. Draw a glyph at the 26.6 pen position `x` with the view of bin
+   * `Math.round((x & 63) * bins / 64)` at pixel `x >> 6`, where bin `bins`
+   * is bin 0 of the next pixel. Works best without horizontal hinting, e.g.
+   * `FT_LOAD_TARGET_LIGHT`.
+   */
+  LoadSubpixelGlyphViewsWithSize: (
+    size_handle: number,
+    charcodes: number[],
+    bins: number,
+    load_flags: number
+  ) => Map<number, GlyphView[]> | null;
+
+  GetKerningWithSize: (
+    size_handle: number,
+    left_glyph_index: number,
+    right_glyph_index: number,
+    kern_mode: number
+  ) => FT_Vector;
+
+  GetKerningPairsWithSize: (
+    size_handle: number,
+    glyph_indices: Uint32Array | number[],
+    kern_mode: number
+  ) => Int32Array | null;
+
+  /** Like `CreateAtlas`, for the face and size of the size handle */
+  CreateAtlasWithSize: (
+    size_handle: number,
+    width: number,
+    height: number,
+    padding: number,
+    load_flags: number,
+    use_sdf: boolean
+  ) => number;
+
+  /**
+   * Sets the number of threads of the `*Parallel` calls, returns the number
+   * used. More than one thread needs the pthreads build
+   * `freetype-threads.js`, which is limited to its pool size.
+   */
+  SetWorkerCount: (num_workers: number) => number;
+
+  GetWorkerCount: () => number;
+
+  /**
+   * Like `LoadGlyphViewsWithSize`, glyphs that are not in the glyph cache are
+   * rendered on the worker threads
+   */
+  LoadGlyphViewsParallel: (
+    size_handle: number,
+    charcodes: number[],
+    load_flags: number,
+    use_sdf: boolean
+  ) => Map<number, GlyphView>;
+
+  LoadGlyphViewsFromCharmapParallel: (
+    size_handle: number,
+    first_charcode: number,
+    last_charcode: number,
+    load_flags: number,
+    use_sdf: boolean
+  ) => Map<number, GlyphView>;
+
   Cleanup: () => void;
 
+  ATLAS_ENTRY_SIZE: number;
+
+  GLYPH_METRICS_CHARCODE: number;
+  GLYPH_METRICS_GLYPH_INDEX: number;
+  GLYPH_METRICS_ADVANCE_X: number;
+  GLYPH_METRICS_ADVANCE_Y: number;
+  GLYPH_METRICS_BEARING_X: number;
+  GLYPH_METRICS_BEARING_Y: number;
+  GLYPH_METRICS_WIDTH: number;
+  GLYPH_METRICS_HEIGHT: number;
+  GLYPH_METRICS_BITMAP_WIDTH: number;
+  GLYPH_METRICS_BITMAP_ROWS: number;
+  GLYPH_METRICS_BITMAP_PITCH: number;
+  GLYPH_METRICS_BITMAP_LEFT: number;
+  GLYPH_METRICS_BITMAP_TOP: number;
+  GLYPH_METRICS_BITMAP_OFFSET: number;
+  GLYPH_METRICS_COLUMNS: number;
+
+  KERNING_PAIR_SIZE: number;
+  GLYPH_SNAPSHOT_ENTRY_SIZE: number;
+  MAX_SUBPIXEL_BINS: number;
+  VARIATION_AXIS_STEPS: number;
+  SHAPED_GLYPH_SIZE: number;
+  SDF_GLYPH_SIZE: number;
+  SDF_RENDERER_AUTO: number;
+  SDF_RENDERER_OUTLINE: number;
+  SDF_RENDERER_BITMAP: number;
+
+  OUTLINE_GLYPH_SIZE: number;
+  OUTLINE_MOVE: number;
+  OUTLINE_LINE: number;
+  OUTLINE_CONIC: number;
+  OUTLINE_CUBIC: number;
+  OUTLINE_CLOSE: number;
+
+  TEXT_GLYPH_SIZE: number;
+  TEXT_LINE_SIZE: number;
+  TEXT_LAYOUT_KERNING: number;
+  TEXT_LAYOUT_HINTED: number;
+  TEXT_LAYOUT_WRAP: number;
+  TEXT_SUBPIXEL_BINS: number;
+  FALLBACK_GLYPH_SIZE: number;
+
+  /** True if the module collects `GetStats` */
+  STATS_ENABLED: boolean;
+
+  /** True if the module is built with HarfBuzz for `ShapeText` */
+  SHAPING_ENABLED: boolean;
+
+  FONT_FORMAT_SFNT: number;
+  FONT_FORMAT_WOFF: number;
+  FONT_FORMAT_WOFF2: number;
+
+  BITMAP_FORMAT_ALPHA: number;
+  BITMAP_FORMAT_RGBA: number;
+  BITMAP_FORMAT_RGBA_PREMULTIPLIED: number;
+
   FT_GLYPH_FORMAT_NONE: number;
   FT_GLYPH_FORMAT_COMPOSITE: number;
   FT_GLYPH_FORMAT_BITMAP: number;
@@ -151,6 +779,150 @@ export interface FT_GlyphSlotRec {
   bitmap_top: number;
 }
 
+export interface FontStorageStats {
+  /** Distinct font blobs in the memory */
+  fonts: number;
+  bytes: number;
+  /** Bytes of decoded WOFF and WOFF2 fonts */
+  decoded_bytes: number;
+  /** Bytes allocated with `AllocateFontBuffer` and not yet loaded */
+  pending_bytes: number;
+  /** Loads that reused an identical stored font */
+  shared_loads: number;
+}
+
+export interface MemoryStats {
+  live_bytes: number;
+  peak_bytes: number;
+  /** Live allocations */
+  allocations: number;
+}
+
+export interface HotPathStats {
+  /** Fonts stored, loads of the same bytes are not counted */
+  font_loads: number;
+  font_bytes: number;
+  /** Time of the font load calls, including decoding and opening faces */
+  font_load_ms: number;
+  /** WOFF and WOFF2 fonts decoded */
+  webfont_decodes: number;
+  webfont_decode_ms: number;
+  /** FT_Load_Glyph calls, the time includes hinting */
+  glyph_loads: number;
+  hinted_glyph_loads: number;
+  glyph_load_ms: number;
+  /** Outlines rendered to bitmaps */
+  glyph_renders: number;
+  glyph_render_ms: number;
+  /** Glyphs taken from the glyph snapshot instead of loading them */
+  snapshot_glyphs: number;
+  /** Glyphs loaded by the worker threads, and the time waited for them */
+  parallel_glyph_loads: number;
+  parallel_load_ms: number;
+  kerning_lookups: number;
+  /** Bitmaps converted to another pixel format, and the converted bytes */
+  bitmap_conversions: number;
+  converted_bytes: number;
+  /** Calls to the exported functions, except `GetStats` and `ResetStats` */
+  api_calls: number;
+}
+
+export interface FaceInfo {
+  face_handle: number;
+  face_index: number;
+  family_name: string;
+  style_name: string;
+  style_flags: number;
+}
+
+export interface FontSourceInfo {
+  /** One of `FONT_FORMAT_*` */
+  format: number;
+  size: number;
+  /** Size of the decoded font, same as `size` for SFNT fonts */
+  sfnt_size: number;
+  decode_ms: number;
+}
+
+export interface CoverageInfo {
+  codepoints: number;
+  /** Runs of consecutive code points */
+  ranges: number;
+  bytes: number;
+}
+
+export interface VariationAxis {
+  /** Four letters, e.g. "wght" */
+  tag: string;
+  minimum: number;
+  default_value: number;
+  maximum: number;
+}
+
+export interface VariationInfo {
+  axes: VariationAxis[];
+  named_instances: number;
+  /** Design coordinates of the face handle */
+  coords: number[];
+  /** Instances of the face created so far */
+  instances: number;
+}
+
+export interface SdfBatchInfo {
+  /** -1 if the spread is out of range */
+  glyph_count: number;
+  outline_glyphs: number;
+  bitmap_glyphs: number;
+  ms: number;
+}
+
+export interface TextMetrics {
+  /** Width of the widest line in 26.6 pixels */
+  width: number;
+  height: number;
+  line_count: number;
+  glyph_count: number;
+}
+
+export interface LruCacheStats {
+  hits: number;
+  misses: number;
+  evictions: number;
+  entries: number;
+  bytes: number;
+  budget: number;
+}
+
+export interface GlyphSlice<T> {
+  glyphs: Map<number, T>;
+  next_charcode: number;
+  done: boolean;
+}
+
+export interface BitmapView {
+  rows: number;
+  width: number;
+  /** Rows are stored top-down, pitch is never negative */
+  pitch: number;
+  pixel_mode: number;
+  num_grays: number;
+  /** Offset to the glyph buffer */
+  offset: number;
+  length: number;
+}
+
+export interface GlyphView {
+  linearHoriAdvance: number;
+  linearVertAdvance: number;
+  glyph_index: number;
+  advance: FT_Vector;
+  metrics: FT_Glyph_Metrics;
+  format: number;
+  bitmap: BitmapView;
+  bitmap_left: number;
+  bitmap_top: number;
+}
+
 export interface FT_Vector {
   x: number;
   y: number;
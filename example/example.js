@@ -87,6 +87,14 @@ export async function write(ctx, str, offsetx_, offsety_, cache, use_sdf) {
     let offsety = offsety_
     let prev = null;
 
+    // Kerning of the glyph pairs of the text in one call, by left * 65536 + right
+    const glyph_indices = [...new Set(str)].map((char) => cache.get(char)?.glyph.glyph_index ?? 0);
+    const pairs = Freetype.GetKerningPairs(glyph_indices, 0) ?? new Int32Array(0);
+    const kernings = new Map();
+    for (let i = 0; i < pairs.length; i += Freetype.KERNING_PAIR_SIZE) {
+        kernings.set(pairs[i] * 65536 + pairs[i + 1], pairs[i + 2]);
+    }
+
     for (const char of str) {
         const { glyph, bitmap } = cache.get(char) || {};
 
@@ -99,12 +107,8 @@ export async function write(ctx, str, offsetx_, offsety_, cache, use_sdf) {
         if (glyph) {
             // Kerning
             if (prev) {
-                const kerning = Freetype.GetKerning(
-                    prev.glyph_index,
-                    glyph.glyph_index,
-                    0
-                );
-                offsetx += kerning.x >> 6;
+                const kerning = kernings.get(prev.glyph_index * 65536 + glyph.glyph_index) ?? 0;
+                offsetx += kerning >> 6;
             }
 
             
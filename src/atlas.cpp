@@ -0,0 +1,228 @@
+#include <string.h>
+
+#include <algorithm>
+
+#include "atlas.h"
+
+SkylinePacker::SkylinePacker(int width, int height) : width(width), height(height)
+{
+    skyline.push_back({0, 0, width});
+}
+
+int SkylinePacker::Fit(size_t index, int rect_width, int rect_height) const
+{
+    const int x = skyline[index].x;
+    if (x + rect_width > width)
+    {
+        return -1;
+    }
+
+    int y = skyline[index].y;
+    int width_left = rect_width;
+    for (size_t i = index; width_left > 0; i++)
+    {
+        if (i >= skyline.size())
+        {
+            return -1;
+        }
+        y = std::max(y, skyline[i].y);
+        if (y + rect_height > height)
+        {
+            return -1;
+        }
+        width_left -= skyline[i].width;
+    }
+    return y;
+}
+
+bool SkylinePacker::Pack(int rect_width, int rect_height, int &x, int &y)
+{
+    int best_index = -1;
+    int best_top = height + 1;
+    int best_width = width + 1;
+
+    for (size_t i = 0; i < skyline.size(); i++)
+    {
+        const int fit_y = Fit(i, rect_width, rect_height);
+        if (fit_y < 0)
+        {
+            continue;
+        }
+
+        // Lowest top edge wins, ties go to the narrowest segment
+        const int top = fit_y + rect_height;
+        if (top < best_top || (top == best_top && skyline[i].width < best_width))
+        {
+            best_index = i;
+            best_top = top;
+            best_width = skyline[i].width;
+            x = skyline[i].x;
+            y = fit_y;
+        }
+    }
+
+    if (best_index < 0)
+    {
+        return false;
+    }
+
+    skyline.insert(skyline.begin() + best_index, {x, y + rect_height, rect_width});
+
+    // Shrink or remove the segments covered by the new one
+    for (size_t i = best_index + 1; i < skyline.size(); i++)
+    {
+        const Node &prev = skyline[i - 1];
+        const int prev_end = prev.x + prev.width;
+        if (skyline[i].x >= prev_end)
+        {
+            break;
+        }
+
+        const int shrink = prev_end - skyline[i].x;
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if (skyline[i].width > 0)
+        {
+            break;
+        }
+        skyline.erase(skyline.begin() + i);
+        i--;
+    }
+
+    // Merge neighbouring segments of the same height
+    for (size_t i = 0; i + 1 < skyline.size(); i++)
+    {
+        if (skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+            i--;
+        }
+    }
+    return true;
+}
+
+GlyphAtlas::GlyphAtlas(int width, int height, int padding) : width(width), height(height), padding(padding)
+{
+}
+
+int GlyphAtlas::Find(unsigned int glyph_index) const
+{
+    auto it = index.find(glyph_index);
+    return it == index.end() ? -1 : it->second;
+}
+
+bool GlyphAtlas::Allocate(int rect_width, int rect_height, AtlasRect &rect)
+{
+    // Padding is kept on the right and bottom, so neighbouring glyphs never
+    // bleed into each other when the texture is sampled with filtering
+    const int padded_width = rect_width + padding;
+    const int padded_height = rect_height + padding;
+    if (padded_width > width || padded_height > height)
+    {
+        return false;
+    }
+
+    rect.width = rect_width;
+    rect.height = rect_height;
+
+    // Earlier pages may still have room for small glyphs
+    for (size_t i = 0; i < packers.size(); i++)
+    {
+        if (packers[i].Pack(padded_width, padded_height, rect.x, rect.y))
+        {
+            rect.page = i;
+            return true;
+        }
+    }
+
+    packers.emplace_back(width, height);
+    pages.emplace_back(width * height, 0);
+    dirty.push_back({(int)pages.size() - 1, 0, 0, 0, 0});
+    rect.page = pages.size() - 1;
+    return packers.back().Pack(padded_width, padded_height, rect.x, rect.y);
+}
+
+void GlyphAtlas::MarkDirty(const AtlasRect &rect)
+{
+    AtlasRect &d = dirty[rect.page];
+    if (d.width == 0 || d.height == 0)
+    {
+        d = rect;
+        return;
+    }
+
+    const int x1 = std::max(d.x + d.width, rect.x + rect.width);
+    const int y1 = std::max(d.y + d.height, rect.y + rect.height);
+    d.x = std::min(d.x, rect.x);
+    d.y = std::min(d.y, rect.y);
+    d.width = x1 - d.x;
+    d.height = y1 - d.y;
+}
+
+int GlyphAtlas::Add(unsigned int glyph_index, int glyph_width, int rows, const unsigned char *buffer, int pitch,
+                    int bitmap_left, int bitmap_top, float advance_x, float advance_y)
+{
+    AtlasRect rect = {0, 0, 0, 0, 0};
+
+    // Whitespace glyphs only need metrics
+    if (glyph_width > 0 && rows > 0)
+    {
+        if (!Allocate(glyph_width, rows, rect))
+        {
+            return -1;
+        }
+
+        unsigned char *page = pages[rect.page].data();
+        for (int y = 0; y < rows; y++)
+        {
+            // Negative pitch means the bottom row is first in the buffer
+            const unsigned char *src = pitch >= 0 ? buffer + y * pitch : buffer + (rows - 1 - y) * -pitch;
+            ::memcpy(page + (rect.y + y) * width + rect.x, src, glyph_width);
+        }
+        MarkDirty(rect);
+    }
+
+    const int entry = entries.size() / ATLAS_ENTRY_SIZE;
+    const float values[ATLAS_ENTRY_SIZE] = {
+        (float)glyph_index,
+        (float)rect.page,
+        (float)rect.x,
+        (float)rect.y,
+        (float)rect.width,
+        (float)rect.height,
+        (float)rect.x / width,
+        (float)rect.y / height,
+        (float)(rect.x + rect.width) / width,
+        (float)(rect.y + rect.height) / height,
+        (float)bitmap_left,
+        (float)bitmap_top,
+        advance_x,
+        advance_y,
+    };
+    entries.insert(entries.end(), values, values + ATLAS_ENTRY_SIZE);
+    index[glyph_index] = entry;
+    return entry;
+}
+
+std::vector<int> GlyphAtlas::DirtyRects() const
+{
+    std::vector<int> rects;
+    for (auto &d : dirty)
+    {
+        if (d.width > 0 && d.height > 0)
+        {
+            rects.insert(rects.end(), {d.page, d.x, d.y, d.width, d.height});
+        }
+    }
+    return rects;
+}
+
+void GlyphAtlas::ClearDirty()
+{
+    for (auto &d : dirty)
+    {
+        d.width = 0;
+        d.height = 0;
+    }
+}
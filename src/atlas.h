@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <map>
+#include <vector>
+
+// Skyline bottom-left rectangle packer
+//
+// The skyline is a list of horizontal segments covering the page width, each
+// new rectangle is placed on top of the segments where its top edge is the
+// lowest. Rectangles are never moved, so glyphs can be added one by one.
+class SkylinePacker
+{
+public:
+    SkylinePacker(int width, int height);
+
+    // Finds a place for a rectangle, returns false if the page is full
+    bool Pack(int width, int height, int &x, int &y);
+
+private:
+    struct Node
+    {
+        int x;
+        int y;
+        int width;
+    };
+
+    // Returns the y where the rectangle fits on top of the node, or -1
+    int Fit(size_t index, int width, int height) const;
+
+    int width;
+    int height;
+    std::vector<Node> skyline;
+};
+
+struct AtlasRect
+{
+    int page;
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// Floats per entry in the metrics table:
+//
+// glyph_index, page, x, y, width, height, u0, v0, u1, v1, bitmap_left,
+// bitmap_top, advance_x, advance_y
+//
+// Advances are in pixels, UVs are normalized to the page size.
+const int ATLAS_ENTRY_SIZE = 14;
+
+// 8-bit glyph atlas with one or more pages of the same size
+//
+// Pages are added when the previous ones are full. Each page tracks the
+// bounding rectangle of the pixels written after the last `ClearDirty`, so
+// only the changed part of the texture needs to be uploaded.
+class GlyphAtlas
+{
+public:
+    GlyphAtlas(int width, int height, int padding);
+
+    // Returns the entry index of the glyph, or -1 if it's not in the atlas
+    int Find(unsigned int glyph_index) const;
+
+    // Copies the 8-bit coverage to the atlas and adds an entry to the metrics
+    // table, returns the entry index or -1 if the glyph doesn't fit
+    int Add(unsigned int glyph_index, int width, int rows, const unsigned char *buffer, int pitch,
+            int bitmap_left, int bitmap_top, float advance_x, float advance_y);
+
+    // Dirty rectangles as page, x, y, width, height
+    std::vector<int> DirtyRects() const;
+    void ClearDirty();
+
+    int width;
+    int height;
+    int padding;
+    std::vector<float> entries;
+    std::vector<std::vector<unsigned char>> pages;
+
+private:
+    bool Allocate(int width, int height, AtlasRect &rect);
+    void MarkDirty(const AtlasRect &rect);
+
+    std::vector<SkylinePacker> packers;
+    // Dirty rectangle per page, width 0 when clean
+    std::vector<AtlasRect> dirty;
+    std::map<unsigned int, int> index;
+};
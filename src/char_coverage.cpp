@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "char_coverage.h"
+
+void CharCoverage::Build(FT_Face face)
+{
+    ranges.clear();
+    glyphs.clear();
+    built = true;
+
+    FT_CharMap previous = face->charmap;
+    if (FT_Select_Charmap(face, FT_ENCODING_UNICODE) != 0)
+    {
+        return;
+    }
+
+    FT_UInt gindex;
+    FT_ULong charcode = FT_Get_First_Char(face, &gindex);
+    while (gindex != 0)
+    {
+        // Glyph ids of sfnt fonts are 16-bit, larger indices can't be stored
+        if (gindex <= 0xffff)
+        {
+            if (ranges.empty() || charcode != (FT_ULong)ranges.back().last + 1)
+            {
+                ranges.push_back({(uint32_t)charcode, (uint32_t)charcode, (uint32_t)glyphs.size()});
+            }
+            else
+            {
+                ranges.back().last = (uint32_t)charcode;
+            }
+            glyphs.push_back((uint16_t)gindex);
+        }
+        charcode = FT_Get_Next_Char(face, charcode, &gindex);
+    }
+    ranges.shrink_to_fit();
+    glyphs.shrink_to_fit();
+
+    if (previous != nullptr)
+    {
+        FT_Set_Charmap(face, previous);
+    }
+}
+
+FT_UInt CharCoverage::Find(FT_ULong codepoint) const
+{
+    // First range that ends at or after the code point
+    auto it = std::lower_bound(ranges.begin(), ranges.end(), codepoint,
+                               [](const Range &range, FT_ULong c)
+                               { return range.last < c; });
+    if (it == ranges.end() || codepoint < it->first)
+    {
+        return 0;
+    }
+    return glyphs[it->offset + (codepoint - it->first)];
+}
+
+size_t CharCoverage::Bytes() const
+{
+    return ranges.capacity() * sizeof(Range) + glyphs.capacity() * sizeof(uint16_t);
+}
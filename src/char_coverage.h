@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <freetype/freetype.h>
+
+// Unicode coverage of a face
+//
+// The Unicode charmap is walked once into a range table, so checking whether
+// a face has a code point is a binary search instead of a cmap lookup. Each
+// range of consecutive code points points at its glyph indices, which are
+// 16-bit like the glyph ids of sfnt fonts.
+class CharCoverage
+{
+public:
+    // Walks the Unicode charmap of the face, the face keeps its charmap.
+    // Faces without a Unicode charmap cover nothing.
+    void Build(FT_Face face);
+
+    // Glyph index of the code point, 0 if not covered
+    FT_UInt Find(FT_ULong codepoint) const;
+
+    bool IsBuilt() const { return built; }
+    size_t CodepointCount() const { return glyphs.size(); }
+    size_t RangeCount() const { return ranges.size(); }
+    size_t Bytes() const;
+
+private:
+    struct Range
+    {
+        uint32_t first;
+        uint32_t last;
+        // Index of the first code point's glyph in `glyphs`
+        uint32_t offset;
+    };
+
+    std::vector<Range> ranges;
+    std::vector<uint16_t> glyphs;
+    bool built = false;
+};
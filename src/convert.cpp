@@ -0,0 +1,489 @@
+#include <stdlib.h>
+
+#include <algorithm>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "convert.h"
+
+namespace
+{
+    struct RowSource
+    {
+        // LCD_V bitmaps read the red, green and blue rows, others only the first
+        const unsigned char *rows[3];
+        unsigned int num_grays;
+    };
+
+    struct Output
+    {
+        BitmapFormat format;
+        unsigned int r;
+        unsigned int g;
+        unsigned int b;
+    };
+
+    // Rounded x / 255 for x between 0 and 255 * 255
+    inline unsigned int Div255(unsigned int x)
+    {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    // Row `y` counted from the top. Negative pitch means the bitmap flows up,
+    // so the top row is the last one in the buffer.
+    inline const unsigned char *Row(const FT_Bitmap &bitmap, unsigned int y)
+    {
+        if (bitmap.pitch >= 0)
+        {
+            return bitmap.buffer + y * bitmap.pitch;
+        }
+        return bitmap.buffer + (bitmap.rows - 1 - y) * -bitmap.pitch;
+    }
+
+    inline unsigned int BytesPerPixel(BitmapFormat format)
+    {
+        return format == BITMAP_FORMAT_ALPHA ? 1 : 4;
+    }
+
+    // Writes a pixel of per channel coverage
+    inline void WriteCoverage(const Output &out, unsigned int r, unsigned int g, unsigned int b, unsigned int a,
+                              unsigned char *dst)
+    {
+        switch (out.format)
+        {
+        case BITMAP_FORMAT_ALPHA:
+            dst[0] = a;
+            break;
+        case BITMAP_FORMAT_RGBA:
+            dst[0] = out.r;
+            dst[1] = out.g;
+            dst[2] = out.b;
+            dst[3] = a;
+            break;
+        case BITMAP_FORMAT_RGBA_PREMULTIPLIED:
+            dst[0] = Div255(out.r * r);
+            dst[1] = Div255(out.g * g);
+            dst[2] = Div255(out.b * b);
+            dst[3] = a;
+            break;
+        }
+    }
+
+    inline unsigned int Unpremultiply(unsigned int c, unsigned int a)
+    {
+        return a == 0 ? 0 : std::min(255u, (c * 255 + a / 2) / a);
+    }
+
+    // Writes a pixel of premultiplied color
+    inline void WriteColor(const Output &out, unsigned int r, unsigned int g, unsigned int b, unsigned int a,
+                           unsigned char *dst)
+    {
+        switch (out.format)
+        {
+        case BITMAP_FORMAT_ALPHA:
+            dst[0] = a;
+            break;
+        case BITMAP_FORMAT_RGBA:
+            dst[0] = Unpremultiply(r, a);
+            dst[1] = Unpremultiply(g, a);
+            dst[2] = Unpremultiply(b, a);
+            dst[3] = a;
+            break;
+        case BITMAP_FORMAT_RGBA_PREMULTIPLIED:
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+            dst[3] = a;
+            break;
+        }
+    }
+
+    // Converts pixels from x0 to x1 of one row
+    void ScalarSpan(unsigned char pixel_mode, const RowSource &src, unsigned int x0, unsigned int x1,
+                    const Output &out, unsigned char *dst)
+    {
+        const unsigned int bpp = BytesPerPixel(out.format);
+        const unsigned char *row = src.rows[0];
+        dst += x0 * bpp;
+
+        switch (pixel_mode)
+        {
+        case FT_PIXEL_MODE_MONO:
+            for (unsigned int x = x0; x < x1; x++, dst += bpp)
+            {
+                const unsigned int c = ((row[x >> 3] >> (7 - (x & 7))) & 1) * 255;
+                WriteCoverage(out, c, c, c, c, dst);
+            }
+            break;
+        case FT_PIXEL_MODE_GRAY2:
+            for (unsigned int x = x0; x < x1; x++, dst += bpp)
+            {
+                const unsigned int c = ((row[x >> 2] >> (6 - 2 * (x & 3))) & 3) * 85;
+                WriteCoverage(out, c, c, c, c, dst);
+            }
+            break;
+        case FT_PIXEL_MODE_GRAY4:
+            for (unsigned int x = x0; x < x1; x++, dst += bpp)
+            {
+                const unsigned int c = ((row[x >> 1] >> (4 - 4 * (x & 1))) & 15) * 17;
+                WriteCoverage(out, c, c, c, c, dst);
+            }
+            break;
+        case FT_PIXEL_MODE_GRAY:
+            for (unsigned int x = x0; x < x1; x++, dst += bpp)
+            {
+                unsigned int c = row[x];
+                if (src.num_grays != 256 && src.num_grays > 1)
+                {
+                    c = std::min(255u, c * 255 / (src.num_grays - 1));
+                }
+                WriteCoverage(out, c, c, c, c, dst);
+            }
+            break;
+        case FT_PIXEL_MODE_LCD:
+            for (unsigned int x = x0; x < x1; x++, dst += bpp)
+            {
+                const unsigned char *p = row + x * 3;
+                WriteCoverage(out, p[0], p[1], p[2], std::max({p[0], p[1], p[2]}), dst);
+            }
+            break;
+        case FT_PIXEL_MODE_LCD_V:
+            for (unsigned int x = x0; x < x1; x++, dst += bpp)
+            {
+                const unsigned int r = src.rows[0][x];
+                const unsigned int g = src.rows[1][x];
+                const unsigned int b = src.rows[2][x];
+                WriteCoverage(out, r, g, b, std::max({r, g, b}), dst);
+            }
+            break;
+        case FT_PIXEL_MODE_BGRA:
+            for (unsigned int x = x0; x < x1; x++, dst += bpp)
+            {
+                const unsigned char *p = row + x * 4;
+                WriteColor(out, p[2], p[1], p[0], p[3], dst);
+            }
+            break;
+        }
+    }
+
+#ifdef __wasm_simd128__
+
+    // Interleaves 16 pixels of separate channels to RGBA
+    inline void StoreRGBA(v128_t r, v128_t g, v128_t b, v128_t a, unsigned char *dst)
+    {
+        const v128_t rg_lo = wasm_i8x16_shuffle(r, g, 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+        const v128_t rg_hi = wasm_i8x16_shuffle(r, g, 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+        const v128_t ba_lo = wasm_i8x16_shuffle(b, a, 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+        const v128_t ba_hi = wasm_i8x16_shuffle(b, a, 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+        wasm_v128_store(dst, wasm_i8x16_shuffle(rg_lo, ba_lo, 0, 1, 16, 17, 2, 3, 18, 19, 4, 5, 20, 21, 6, 7, 22, 23));
+        wasm_v128_store(dst + 16, wasm_i8x16_shuffle(rg_lo, ba_lo, 8, 9, 24, 25, 10, 11, 26, 27, 12, 13, 28, 29, 14, 15, 30, 31));
+        wasm_v128_store(dst + 32, wasm_i8x16_shuffle(rg_hi, ba_hi, 0, 1, 16, 17, 2, 3, 18, 19, 4, 5, 20, 21, 6, 7, 22, 23));
+        wasm_v128_store(dst + 48, wasm_i8x16_shuffle(rg_hi, ba_hi, 8, 9, 24, 25, 10, 11, 26, 27, 12, 13, 28, 29, 14, 15, 30, 31));
+    }
+
+    // Rounded a * b / 255 for 16 lanes
+    inline v128_t MulDiv255(v128_t a, v128_t b)
+    {
+        const v128_t round = wasm_i16x8_splat(128);
+        v128_t lo = wasm_i16x8_add(wasm_u16x8_extmul_low_u8x16(a, b), round);
+        v128_t hi = wasm_i16x8_add(wasm_u16x8_extmul_high_u8x16(a, b), round);
+        lo = wasm_u16x8_shr(wasm_i16x8_add(lo, wasm_u16x8_shr(lo, 8)), 8);
+        hi = wasm_u16x8_shr(wasm_i16x8_add(hi, wasm_u16x8_shr(hi, 8)), 8);
+        return wasm_u8x16_narrow_i16x8(lo, hi);
+    }
+
+    // Rounded min(255, c * 255 / a) of 4 lanes, 0 where alpha is 0
+    inline v128_t Unpremultiply4(v128_t c, v128_t a)
+    {
+        const v128_t af = wasm_f32x4_convert_u32x4(a);
+        const v128_t q = wasm_f32x4_add(wasm_f32x4_div(wasm_f32x4_mul(wasm_f32x4_convert_u32x4(c), wasm_f32x4_splat(255.0f)), af),
+                                        wasm_f32x4_splat(0.5f));
+        // Division by zero gives NaN or infinity, they are masked out
+        return wasm_v128_andnot(wasm_i32x4_trunc_sat_f32x4(q), wasm_i32x4_eq(a, wasm_i32x4_splat(0)));
+    }
+
+    inline v128_t Unpremultiply(v128_t c, v128_t a)
+    {
+        const v128_t c_lo = wasm_u16x8_extend_low_u8x16(c);
+        const v128_t c_hi = wasm_u16x8_extend_high_u8x16(c);
+        const v128_t a_lo = wasm_u16x8_extend_low_u8x16(a);
+        const v128_t a_hi = wasm_u16x8_extend_high_u8x16(a);
+        const v128_t lo = wasm_i16x8_narrow_i32x4(
+            Unpremultiply4(wasm_u32x4_extend_low_u16x8(c_lo), wasm_u32x4_extend_low_u16x8(a_lo)),
+            Unpremultiply4(wasm_u32x4_extend_high_u16x8(c_lo), wasm_u32x4_extend_high_u16x8(a_lo)));
+        const v128_t hi = wasm_i16x8_narrow_i32x4(
+            Unpremultiply4(wasm_u32x4_extend_low_u16x8(c_hi), wasm_u32x4_extend_low_u16x8(a_hi)),
+            Unpremultiply4(wasm_u32x4_extend_high_u16x8(c_hi), wasm_u32x4_extend_high_u16x8(a_hi)));
+        return wasm_u8x16_narrow_i16x8(lo, hi);
+    }
+
+    inline void StoreCoverage(const Output &out, v128_t r, v128_t g, v128_t b, v128_t a, unsigned char *dst)
+    {
+        switch (out.format)
+        {
+        case BITMAP_FORMAT_ALPHA:
+            wasm_v128_store(dst, a);
+            break;
+        case BITMAP_FORMAT_RGBA:
+            StoreRGBA(wasm_i8x16_splat(out.r), wasm_i8x16_splat(out.g), wasm_i8x16_splat(out.b), a, dst);
+            break;
+        case BITMAP_FORMAT_RGBA_PREMULTIPLIED:
+            StoreRGBA(MulDiv255(r, wasm_i8x16_splat(out.r)),
+                      MulDiv255(g, wasm_i8x16_splat(out.g)),
+                      MulDiv255(b, wasm_i8x16_splat(out.b)), a, dst);
+            break;
+        }
+    }
+
+    alignas(16) const unsigned char gray2_high[16] = {0, 0, 0, 0, 85, 85, 85, 85, 170, 170, 170, 170, 255, 255, 255, 255};
+    alignas(16) const unsigned char gray2_low[16] = {0, 85, 170, 255, 0, 85, 170, 255, 0, 85, 170, 255, 0, 85, 170, 255};
+    alignas(16) const unsigned char gray4_scale[16] = {0, 17, 34, 51, 68, 85, 102, 119, 136, 153, 170, 187, 204, 221, 238, 255};
+    alignas(16) const unsigned char mono_bits[16] = {128, 64, 32, 16, 8, 4, 2, 1, 128, 64, 32, 16, 8, 4, 2, 1};
+
+    // Swizzle indices to pick one channel of 16 LCD pixels from three
+    // vectors, out of range indices give zero
+    struct LcdIndices
+    {
+        alignas(16) unsigned char index[3][3][16];
+
+        LcdIndices()
+        {
+            for (int channel = 0; channel < 3; channel++)
+            {
+                for (int v = 0; v < 3; v++)
+                {
+                    for (int i = 0; i < 16; i++)
+                    {
+                        const int byte = i * 3 + channel - v * 16;
+                        index[channel][v][i] = byte >= 0 && byte < 16 ? byte : 0x80;
+                    }
+                }
+            }
+        }
+    };
+    const LcdIndices lcd_indices;
+
+    inline v128_t LcdChannel(int channel, v128_t v0, v128_t v1, v128_t v2)
+    {
+        const unsigned char(*index)[16] = lcd_indices.index[channel];
+        return wasm_v128_or(wasm_v128_or(wasm_i8x16_swizzle(v0, wasm_v128_load(index[0])),
+                                         wasm_i8x16_swizzle(v1, wasm_v128_load(index[1]))),
+                            wasm_i8x16_swizzle(v2, wasm_v128_load(index[2])));
+    }
+
+    // Converts 16 pixels at a time from the start of the row, returns the
+    // number of converted pixels
+    unsigned int SimdSpan(unsigned char pixel_mode, const RowSource &src, unsigned int width,
+                          const Output &out, unsigned char *dst)
+    {
+        const unsigned int bpp = BytesPerPixel(out.format);
+        const unsigned char *row = src.rows[0];
+        const unsigned int end = width & ~15u;
+        const v128_t low_nibble = wasm_i8x16_splat(0x0f);
+        unsigned int x = 0;
+
+        switch (pixel_mode)
+        {
+        case FT_PIXEL_MODE_MONO:
+        {
+            const v128_t bits = wasm_v128_load(mono_bits);
+            const v128_t zero = wasm_i8x16_splat(0);
+            for (; x < end; x += 16, dst += 16 * bpp)
+            {
+                v128_t v = wasm_v128_load16_splat(row + (x >> 3));
+                v = wasm_i8x16_shuffle(v, v, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+                const v128_t c = wasm_i8x16_ne(wasm_v128_and(v, bits), zero);
+                StoreCoverage(out, c, c, c, c, dst);
+            }
+            break;
+        }
+        case FT_PIXEL_MODE_GRAY2:
+        {
+            // Pixels 0 and 1 of each byte are in the high nibble
+            const v128_t high = wasm_v128_load(gray2_high);
+            const v128_t low = wasm_v128_load(gray2_low);
+            const v128_t use_high_nibble = wasm_i32x4_splat(0x0000ffff);
+            const v128_t use_high_bits = wasm_i16x8_splat(0x00ff);
+            for (; x < end; x += 16, dst += 16 * bpp)
+            {
+                v128_t v = wasm_v128_load32_splat(row + (x >> 2));
+                v = wasm_i8x16_shuffle(v, v, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+                const v128_t nibble = wasm_v128_bitselect(wasm_u8x16_shr(v, 4), wasm_v128_and(v, low_nibble), use_high_nibble);
+                const v128_t c = wasm_v128_bitselect(wasm_i8x16_swizzle(high, nibble), wasm_i8x16_swizzle(low, nibble), use_high_bits);
+                StoreCoverage(out, c, c, c, c, dst);
+            }
+            break;
+        }
+        case FT_PIXEL_MODE_GRAY4:
+        {
+            const v128_t scale = wasm_v128_load(gray4_scale);
+            const v128_t use_high_nibble = wasm_i16x8_splat(0x00ff);
+            for (; x < end; x += 16, dst += 16 * bpp)
+            {
+                v128_t v = wasm_v128_load64_zero(row + (x >> 1));
+                v = wasm_i8x16_shuffle(v, v, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+                const v128_t nibble = wasm_v128_bitselect(wasm_u8x16_shr(v, 4), wasm_v128_and(v, low_nibble), use_high_nibble);
+                const v128_t c = wasm_i8x16_swizzle(scale, nibble);
+                StoreCoverage(out, c, c, c, c, dst);
+            }
+            break;
+        }
+        case FT_PIXEL_MODE_GRAY:
+            // Uncommon gray levels are left to the scalar code
+            if (src.num_grays != 256)
+            {
+                break;
+            }
+            for (; x < end; x += 16, dst += 16 * bpp)
+            {
+                const v128_t c = wasm_v128_load(row + x);
+                StoreCoverage(out, c, c, c, c, dst);
+            }
+            break;
+        case FT_PIXEL_MODE_LCD:
+            for (; x < end; x += 16, dst += 16 * bpp)
+            {
+                const unsigned char *p = row + x * 3;
+                const v128_t v0 = wasm_v128_load(p);
+                const v128_t v1 = wasm_v128_load(p + 16);
+                const v128_t v2 = wasm_v128_load(p + 32);
+                const v128_t r = LcdChannel(0, v0, v1, v2);
+                const v128_t g = LcdChannel(1, v0, v1, v2);
+                const v128_t b = LcdChannel(2, v0, v1, v2);
+                StoreCoverage(out, r, g, b, wasm_u8x16_max(wasm_u8x16_max(r, g), b), dst);
+            }
+            break;
+        case FT_PIXEL_MODE_LCD_V:
+            for (; x < end; x += 16, dst += 16 * bpp)
+            {
+                const v128_t r = wasm_v128_load(src.rows[0] + x);
+                const v128_t g = wasm_v128_load(src.rows[1] + x);
+                const v128_t b = wasm_v128_load(src.rows[2] + x);
+                StoreCoverage(out, r, g, b, wasm_u8x16_max(wasm_u8x16_max(r, g), b), dst);
+            }
+            break;
+        case FT_PIXEL_MODE_BGRA:
+            for (; x < end; x += 16, dst += 16 * bpp)
+            {
+                const unsigned char *p = row + x * 4;
+                const v128_t v0 = wasm_v128_load(p);
+                const v128_t v1 = wasm_v128_load(p + 16);
+                const v128_t v2 = wasm_v128_load(p + 32);
+                const v128_t v3 = wasm_v128_load(p + 48);
+
+                // Deinterleave to blue and green of pixels 0-7 / 8-15 ...
+                const v128_t bg0 = wasm_i8x16_shuffle(v0, v1, 0, 4, 8, 12, 16, 20, 24, 28, 1, 5, 9, 13, 17, 21, 25, 29);
+                const v128_t ra0 = wasm_i8x16_shuffle(v0, v1, 2, 6, 10, 14, 18, 22, 26, 30, 3, 7, 11, 15, 19, 23, 27, 31);
+                const v128_t bg1 = wasm_i8x16_shuffle(v2, v3, 0, 4, 8, 12, 16, 20, 24, 28, 1, 5, 9, 13, 17, 21, 25, 29);
+                const v128_t ra1 = wasm_i8x16_shuffle(v2, v3, 2, 6, 10, 14, 18, 22, 26, 30, 3, 7, 11, 15, 19, 23, 27, 31);
+
+                // ... and then to whole channels
+                const v128_t b = wasm_i8x16_shuffle(bg0, bg1, 0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19, 20, 21, 22, 23);
+                const v128_t g = wasm_i8x16_shuffle(bg0, bg1, 8, 9, 10, 11, 12, 13, 14, 15, 24, 25, 26, 27, 28, 29, 30, 31);
+                const v128_t r = wasm_i8x16_shuffle(ra0, ra1, 0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19, 20, 21, 22, 23);
+                const v128_t a = wasm_i8x16_shuffle(ra0, ra1, 8, 9, 10, 11, 12, 13, 14, 15, 24, 25, 26, 27, 28, 29, 30, 31);
+
+                switch (out.format)
+                {
+                case BITMAP_FORMAT_ALPHA:
+                    wasm_v128_store(dst, a);
+                    break;
+                case BITMAP_FORMAT_RGBA:
+                    StoreRGBA(Unpremultiply(r, a), Unpremultiply(g, a), Unpremultiply(b, a), a, dst);
+                    break;
+                case BITMAP_FORMAT_RGBA_PREMULTIPLIED:
+                    StoreRGBA(r, g, b, a, dst);
+                    break;
+                }
+            }
+            break;
+        }
+        return x;
+    }
+
+#endif
+
+    template <bool UseSimd>
+    bool Convert(const FT_Bitmap &bitmap, BitmapFormat format, unsigned int color, unsigned char *dst)
+    {
+        unsigned int width, rows;
+        if (!GetConvertedSize(bitmap, width, rows))
+        {
+            return false;
+        }
+
+        const Output out = {format, (color >> 16) & 0xff, (color >> 8) & 0xff, color & 0xff};
+        const size_t stride = width * BytesPerPixel(format);
+
+        for (unsigned int y = 0; y < rows; y++, dst += stride)
+        {
+            RowSource src;
+            src.num_grays = bitmap.num_grays;
+            if (bitmap.pixel_mode == FT_PIXEL_MODE_LCD_V)
+            {
+                src.rows[0] = Row(bitmap, y * 3);
+                src.rows[1] = Row(bitmap, y * 3 + 1);
+                src.rows[2] = Row(bitmap, y * 3 + 2);
+            }
+            else
+            {
+                src.rows[0] = src.rows[1] = src.rows[2] = Row(bitmap, y);
+            }
+
+            unsigned int x = 0;
+#ifdef __wasm_simd128__
+            if (UseSimd)
+            {
+                x = SimdSpan(bitmap.pixel_mode, src, width, out, dst);
+            }
+#endif
+            ScalarSpan(bitmap.pixel_mode, src, x, width, out, dst);
+        }
+        return true;
+    }
+}
+
+bool GetConvertedSize(const FT_Bitmap &bitmap, unsigned int &width, unsigned int &rows)
+{
+    width = bitmap.width;
+    rows = bitmap.rows;
+
+    switch (bitmap.pixel_mode)
+    {
+    case FT_PIXEL_MODE_MONO:
+    case FT_PIXEL_MODE_GRAY:
+    case FT_PIXEL_MODE_GRAY2:
+    case FT_PIXEL_MODE_GRAY4:
+    case FT_PIXEL_MODE_BGRA:
+        return true;
+    case FT_PIXEL_MODE_LCD:
+        width /= 3;
+        return true;
+    case FT_PIXEL_MODE_LCD_V:
+        rows /= 3;
+        return true;
+    default:
+        width = rows = 0;
+        return false;
+    }
+}
+
+size_t GetConvertedBytes(const FT_Bitmap &bitmap, BitmapFormat format)
+{
+    unsigned int width, rows;
+    GetConvertedSize(bitmap, width, rows);
+    return (size_t)width * rows * BytesPerPixel(format);
+}
+
+bool ConvertBitmap(const FT_Bitmap &bitmap, BitmapFormat format, unsigned int color, unsigned char *dst)
+{
+    return Convert<true>(bitmap, format, color, dst);
+}
+
+bool ConvertBitmapScalar(const FT_Bitmap &bitmap, BitmapFormat format, unsigned int color, unsigned char *dst)
+{
+    return Convert<false>(bitmap, format, color, dst);
+}
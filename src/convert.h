@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <freetype/freetype.h>
+
+// Bitmap conversion for every FT_PIXEL_MODE
+//
+// Bitmaps are converted to tightly packed top-down rows, whatever the pitch
+// of the source is. LCD bitmaps are three times wider and LCD_V bitmaps three
+// times taller than the converted image.
+//
+// Coverage modes (MONO, GRAY, GRAY2, GRAY4, LCD, LCD_V) are drawn with
+// `color` (0xRRGGBB) in the RGBA formats. LCD coverage is per channel, its
+// alpha is the maximum of the channels. BGRA bitmaps are premultiplied color
+// and ignore `color`.
+
+enum BitmapFormat
+{
+    // One byte of alpha per pixel
+    BITMAP_FORMAT_ALPHA = 0,
+    // Color with straight alpha, same as ImageData
+    BITMAP_FORMAT_RGBA = 1,
+    // Color multiplied by alpha, same as WebGL with premultipliedAlpha
+    BITMAP_FORMAT_RGBA_PREMULTIPLIED = 2,
+};
+
+// Returns false if the pixel mode is not supported
+bool GetConvertedSize(const FT_Bitmap &bitmap, unsigned int &width, unsigned int &rows);
+
+size_t GetConvertedBytes(const FT_Bitmap &bitmap, BitmapFormat format);
+
+// Writes GetConvertedBytes bytes to `dst`, uses wasm SIMD128 kernels when
+// built with -msimd128
+bool ConvertBitmap(const FT_Bitmap &bitmap, BitmapFormat format, unsigned int color, unsigned char *dst);
+
+// Scalar reference implementation of ConvertBitmap
+bool ConvertBitmapScalar(const FT_Bitmap &bitmap, BitmapFormat format, unsigned int color, unsigned char *dst);
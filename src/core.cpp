@@ -0,0 +1,1734 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <freetype/freetype.h>
+#include <freetype/ftmm.h>
+#include <freetype/ftmodapi.h>
+#include <freetype/ftoutln.h>
+#include <freetype/ftsizes.h>
+#include <freetype/tttables.h>
+#include <freetype/tttags.h>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#endif
+
+#include "core.h"
+
+FT_Face current_face;
+
+TrackedMemory ft_memory;
+
+HotPathStats hot_path_stats;
+
+double NowMs()
+{
+#ifdef __EMSCRIPTEN__
+    return emscripten_get_now();
+#else
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Content hash -> stored fonts, identical fonts share one FontPtr
+std::map<uint64_t, std::vector<std::weak_ptr<FontPtr>>> font_store;
+
+// Storage of `AllocatePendingFont`, address -> storage
+std::map<uintptr_t, std::unique_ptr<FontPtr>> pending_fonts;
+
+size_t font_shared_loads = 0;
+
+std::vector<unsigned char> glyph_buffer;
+
+std::vector<int32_t> glyph_metrics;
+size_t glyph_metrics_count = 0;
+
+std::vector<unsigned char> convert_buffer;
+
+GlyphCache glyph_cache(4 * 1024 * 1024);
+
+GlyphSnapshot glyph_snapshot;
+
+// Slot of a snapshot glyph that is not cached
+FT_GlyphSlotRec snapshot_slot;
+
+std::unique_ptr<ParallelRasterizer> rasterizer;
+
+std::map<int, std::unique_ptr<FontAtlas>> atlases;
+int next_atlas_id = 1;
+
+std::map<int, Font *> face_handles;
+std::map<int, SizeHandle> size_handles;
+int next_handle = 1;
+
+// Faces of `LoadFaceInfos` are opened on first use, and closed again when
+// idle longer than this. 0 keeps them open.
+double face_idle_timeout_ms = 0;
+
+Font::Font(std::shared_ptr<FontPtr> ptr, FT_Long index)
+{
+    face = nullptr;
+    bytes = ptr;
+    face_index = index;
+    style_flags = 0;
+    lazy = false;
+    Register();
+}
+
+Font::Font(const FaceScanInfo &info, std::shared_ptr<FontPtr> ptr)
+{
+    face = nullptr;
+    bytes = ptr;
+    face_index = info.face_index;
+    style_flags = info.style_flags;
+    lazy = true;
+    Register();
+}
+
+Font::Font(Font *instance_of, const std::vector<FT_Fixed> &instance_coords)
+{
+    face = nullptr;
+    bytes = instance_of->bytes;
+    face_index = instance_of->face_index;
+    style_flags = instance_of->style_flags;
+    lazy = true;
+    encoding = instance_of->encoding;
+    coverage = instance_of->coverage;
+    base = instance_of;
+    coords = instance_coords;
+    Register();
+}
+
+Font::~Font()
+{
+    // printf("free font?\n");
+    Close();
+    face_handles.erase(handle);
+    ft_memory.EraseTag(handle);
+}
+
+FT_Face Font::Open()
+{
+    last_used = NowMs();
+    if (face != nullptr)
+    {
+        return face;
+    }
+
+    FT_Library library = GetOrDeleteLibrary();
+    MemoryTagScope memory_tag(handle);
+    FT_Error error = FT_New_Memory_Face(library, bytes->sfnt, bytes->sfnt_size, face_index, &face);
+    if (error)
+    {
+        fprintf(stderr, "FreeType: FT_New_Memory_Face (face index %ld) failed.\n", face_index);
+        face = nullptr;
+        return nullptr;
+    }
+    face->generic.data = (void *)(intptr_t)handle;
+    if (!coords.empty() && FT_Set_Var_Design_Coordinates(face, coords.size(), coords.data()))
+    {
+        fprintf(stderr, "FreeType: Error setting variation coordinates.\n");
+        FT_Done_Face(face);
+        face = nullptr;
+        return nullptr;
+    }
+    style_flags = face->style_flags;
+    if (!coverage.IsBuilt())
+    {
+        coverage.Build(face);
+    }
+
+    // Restore the charmap and size set before the face was closed
+    if (encoding != FT_ENCODING_NONE)
+    {
+        FT_Select_Charmap(face, encoding);
+    }
+    if (has_size_request)
+    {
+        ApplySizeRequest(face, size_request);
+    }
+    return face;
+}
+
+void Font::Close()
+{
+    if (face == nullptr)
+    {
+        return;
+    }
+    if (current_face == face)
+    {
+        current_face = NULL;
+    }
+
+    // Atlases of the face can't add glyphs anymore
+    for (auto it = atlases.begin(); it != atlases.end();)
+    {
+        if (it->second->face == face)
+        {
+            it = atlases.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    // Cached glyphs must go before the face, as face pointers can be reused
+    FT_Face ft_face = face;
+    glyph_cache.EraseIf([ft_face](const GlyphCacheKey &key)
+                        { return key.face == ft_face; });
+    ReleaseShaperFace(ft_face);
+    ReleaseOutlines(ft_face);
+
+    // Size objects are freed by FT_Done_Face
+    for (auto &size : sizes)
+    {
+        size_handles.erase(size.second);
+    }
+    sizes.clear();
+
+    FT_Done_Face(face);
+    face = nullptr;
+}
+
+bool Font::IsIdle(double now) const
+{
+    if (!lazy || face == nullptr || face == current_face || !sizes.empty() ||
+        now - last_used < face_idle_timeout_ms)
+    {
+        return false;
+    }
+    for (auto &atlas : atlases)
+    {
+        if (atlas.second->face == face)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Font::Register()
+{
+    handle = next_handle++;
+    face_handles[handle] = this;
+}
+
+Font *FindFont(FT_Face face)
+{
+    if (face == nullptr)
+    {
+        return nullptr;
+    }
+    for (auto &it : face_handles)
+    {
+        if (it.second->face == face)
+        {
+            return it.second;
+        }
+    }
+    return nullptr;
+}
+
+// Memory tag of the face, FreeType allocations for the face are accounted
+// to its handle
+int FaceMemoryTag(FT_Face face)
+{
+    return (int)(intptr_t)face->generic.data;
+}
+
+// Closes lazy faces that have been idle longer than the timeout
+int EvictIdleFaces()
+{
+    if (face_idle_timeout_ms <= 0)
+    {
+        return 0;
+    }
+    const double now = NowMs();
+    int evicted = 0;
+    for (auto &it : face_handles)
+    {
+        if (it.second->IsIdle(now))
+        {
+            it.second->Close();
+            evicted++;
+        }
+    }
+    return evicted;
+}
+
+void SetFaceIdleTimeout(double timeout_ms)
+{
+    face_idle_timeout_ms = timeout_ms;
+}
+
+// FamilyName -> StyleName -> (FT_Bytes, FT_Face)
+std::map<std::string, std::map<std::string, std::unique_ptr<Font>>>
+    face_map;
+
+FT_Library GetOrDeleteLibrary(bool deleteLibrary)
+{
+    static bool inited = false;
+    static FT_Library library;
+    if (deleteLibrary)
+    {
+        if (inited)
+        {
+            FT_Done_Library(library);
+            inited = false;
+            library = nullptr;
+        }
+    }
+    else
+    {
+        if (!inited)
+        {
+            FT_New_Library(ft_memory.Get(), &library);
+            FT_Add_Default_Modules(library);
+            FT_Set_Default_Properties(library);
+            inited = true;
+        }
+    }
+    return library;
+}
+
+void Cleanup()
+{
+    rasterizer.reset();
+    atlases.clear();
+    glyph_cache.Clear();
+    glyph_snapshot.Clear();
+    CleanupShaper();
+    CleanupOutlines();
+    face_map.clear();
+    font_store.clear();
+    pending_fonts.clear();
+    font_shared_loads = 0;
+    glyph_buffer.clear();
+    glyph_buffer.shrink_to_fit();
+    glyph_metrics.clear();
+    glyph_metrics.shrink_to_fit();
+    glyph_metrics_count = 0;
+    convert_buffer.clear();
+    convert_buffer.shrink_to_fit();
+    GetOrDeleteLibrary(true);
+}
+
+// Hashes 8 bytes at a time, collisions are resolved by comparing the bytes
+uint64_t HashFontBytes(FT_Bytes bytes, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        ::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Returns the stored font with the same bytes, or stores the new font
+std::shared_ptr<FontPtr> StoreFont(std::unique_ptr<FontPtr> font)
+{
+    font->hash = HashFontBytes(font->bytes, font->size);
+    auto &candidates = font_store[font->hash];
+    for (auto it = candidates.begin(); it != candidates.end();)
+    {
+        auto stored = it->lock();
+        if (!stored)
+        {
+            it = candidates.erase(it);
+            continue;
+        }
+        if (stored->size == font->size && ::memcmp(stored->bytes, font->bytes, font->size) == 0)
+        {
+            font_shared_loads++;
+            return stored;
+        }
+        it++;
+    }
+
+    FT_STATS_ADD(font_loads, 1);
+    FT_STATS_ADD(font_bytes, font->size);
+    font->format = GetFontFormat(font->bytes, font->size);
+    if (font->format != FONT_FORMAT_SFNT)
+    {
+        FT_STATS_ADD(webfont_decodes, 1);
+        FT_STATS_TIMER(webfont_decode_ms);
+        const double start = NowMs();
+        FT_Error error = DecodeWebFont(GetOrDeleteLibrary(), font->bytes, font->size, font->decoded);
+        if (error)
+        {
+            // Faces are opened from the original bytes, FreeType reports the error
+            fprintf(stderr, "FreeType: Unable to decode WOFF font (error %d).\n", error);
+            font->decoded.clear();
+        }
+        else
+        {
+            font->sfnt = font->decoded.data();
+            font->sfnt_size = font->decoded.size();
+        }
+        font->decode_ms = NowMs() - start;
+    }
+
+    std::shared_ptr<FontPtr> stored = std::move(font);
+    candidates.push_back(stored);
+    return stored;
+}
+
+// Opens the faces of the stored font, faces already opened from the same
+// bytes are reused
+std::vector<FT_FaceRec> LoadFaces(std::shared_ptr<FontPtr> fns)
+{
+    FT_Library library = GetOrDeleteLibrary();
+    FT_Error error;
+    std::vector<FT_FaceRec> rtn;
+    FT_Face face_temp;
+
+    // Get num of faces
+    error = FT_New_Memory_Face(library, fns->sfnt, fns->sfnt_size, -1, &face_temp);
+    if (error)
+    {
+        fprintf(stderr, "FreeType: FT_New_Memory_Face (face index -1) failed.\n");
+        return rtn;
+    }
+    int num_faces = face_temp->num_faces;
+    FT_Done_Face(face_temp);
+
+    // Faces still open from the same bytes
+    std::map<FT_Long, Font *> opened;
+    for (auto &it : face_handles)
+    {
+        if (it.second->bytes == fns && it.second->base == nullptr)
+        {
+            opened[it.second->face_index] = it.second;
+        }
+    }
+
+    // Iterate faces stored in the font
+    for (int i = 0; i < num_faces; i++)
+    {
+        auto existing = opened.find(i);
+        if (existing != opened.end())
+        {
+            FT_Face opened_face = existing->second->Open();
+            if (opened_face != nullptr)
+            {
+                rtn.push_back(*opened_face);
+            }
+            continue;
+        }
+
+        auto font = std::make_unique<Font>(fns, i);
+        FT_Face ft_face = font->Open();
+        if (ft_face == nullptr)
+        {
+            return rtn;
+        }
+
+        face_map[ft_face->family_name][ft_face->style_name] = std::move(font);
+        rtn.push_back(*ft_face);
+    }
+
+    return rtn;
+}
+
+std::unique_ptr<FontPtr> CopyFontBytes(const unsigned char *bytes, size_t size)
+{
+    auto fns = std::make_unique<FontPtr>(size);
+    if (fns->bytes == nullptr)
+    {
+        fprintf(stderr, "FreeType: Unable to allocate %zu bytes for the font.\n", size);
+        return nullptr;
+    }
+    ::memcpy((void *)fns->bytes, bytes, size);
+    return fns;
+}
+
+unsigned char *AllocatePendingFont(size_t size)
+{
+    auto fns = std::make_unique<FontPtr>(size);
+    if (fns->bytes == nullptr)
+    {
+        fprintf(stderr, "FreeType: Unable to allocate %zu bytes for the font.\n", size);
+        return nullptr;
+    }
+    unsigned char *data = (unsigned char *)fns->bytes;
+    pending_fonts[(uintptr_t)data] = std::move(fns);
+    return data;
+}
+
+FontPtr *GetPendingFont(uintptr_t address)
+{
+    auto it = pending_fonts.find(address);
+    if (it == pending_fonts.end())
+    {
+        fprintf(stderr, "FreeType: Buffer was not allocated with `AllocateFontBuffer`.\n");
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+std::unique_ptr<FontPtr> TakePendingFont(uintptr_t address)
+{
+    auto it = pending_fonts.find(address);
+    if (it == pending_fonts.end())
+    {
+        fprintf(stderr, "FreeType: Buffer was not allocated with `AllocateFontBuffer`.\n");
+        return nullptr;
+    }
+    auto fns = std::move(it->second);
+    pending_fonts.erase(it);
+    return fns;
+}
+
+// Registers the faces of the stored font without opening them, the names
+// are read from the font tables. Faces are opened by `SetFont` or when a
+// size is created with the face handle.
+std::vector<FaceInfo> LoadFaceInfos(std::shared_ptr<FontPtr> fns)
+{
+    std::vector<FaceInfo> rtn;
+    std::vector<FaceScanInfo> scanned;
+    FT_Error error = ScanFaces(GetOrDeleteLibrary(), fns->sfnt, fns->sfnt_size, scanned);
+    if (error)
+    {
+        fprintf(stderr, "FreeType: Unable to read the faces of the font.\n");
+        return rtn;
+    }
+
+    // Faces already loaded from the same bytes
+    std::map<FT_Long, Font *> loaded;
+    for (auto &it : face_handles)
+    {
+        if (it.second->bytes == fns && it.second->base == nullptr)
+        {
+            loaded[it.second->face_index] = it.second;
+        }
+    }
+
+    for (auto &info : scanned)
+    {
+        Font *font;
+        auto existing = loaded.find(info.face_index);
+        if (existing != loaded.end())
+        {
+            font = existing->second;
+        }
+        else
+        {
+            auto &entry = face_map[info.family_name][info.style_name];
+            entry = std::make_unique<Font>(info, fns);
+            font = entry.get();
+        }
+        rtn.push_back({font->handle, info.face_index, info.family_name, info.style_name, info.style_flags});
+    }
+
+    EvictIdleFaces();
+    return rtn;
+}
+
+// Whether the face is open, faces of `LoadFaceInfos` are opened on first use
+// and closed when idle
+bool IsFaceOpen(int face_handle)
+{
+    auto it = face_handles.find(face_handle);
+    return it != face_handles.end() && it->second->face != nullptr;
+}
+
+// FreeType heap usage of all fonts, the library itself included
+MemoryStats GetMemoryStats()
+{
+    return ft_memory.Stats();
+}
+
+// FreeType heap usage of the face, its sizes and glyph loading
+bool ReadFaceMemoryStats(int face_handle, MemoryStats &stats)
+{
+    return face_handles.count(face_handle) != 0 && ft_memory.TagStats(face_handle, stats);
+}
+
+void ResetMemoryPeaks()
+{
+    ft_memory.ResetPeaks();
+}
+
+// FreeType allocations over the limit fail, 0 is no limit
+void SetMemoryLimit(size_t bytes)
+{
+    ft_memory.SetLimit(bytes);
+}
+
+// Bytes reserved for the small allocation pools
+size_t GetMemoryPoolBytes()
+{
+    return ft_memory.PoolBytes();
+}
+
+// Format and decoded size of the font the face was loaded from
+bool ReadFontSourceInfo(int face_handle, FontSourceInfo &info)
+{
+    auto it = face_handles.find(face_handle);
+    if (it == face_handles.end())
+    {
+        return false;
+    }
+    const FontPtr &font = *it->second->bytes;
+    info = {font.format, (size_t)font.size, (size_t)font.sfnt_size, font.decode_ms};
+    return true;
+}
+
+bool ReadFaceCoverage(int face_handle, CoverageInfo &info)
+{
+    auto it = face_handles.find(face_handle);
+    if (it == face_handles.end())
+    {
+        return false;
+    }
+    Font *font = it->second;
+    if (!font->coverage.IsBuilt() && font->Open() == nullptr)
+    {
+        return false;
+    }
+    info = {font->coverage.CodepointCount(), font->coverage.RangeCount(), font->coverage.Bytes()};
+    return true;
+}
+
+FontStorageStats GetFontStorageStats()
+{
+    FontStorageStats stats = {0, 0, 0, 0, font_shared_loads};
+    for (auto &candidates : font_store)
+    {
+        for (auto &weak : candidates.second)
+        {
+            if (auto stored = weak.lock())
+            {
+                stats.fonts++;
+                stats.bytes += stored->size;
+                stats.decoded_bytes += stored->decoded.size();
+            }
+        }
+    }
+    for (auto &pending : pending_fonts)
+    {
+        stats.pending_bytes += pending.second->size;
+    }
+    return stats;
+}
+
+// Hot path counters and timers, zeros unless built with FT_WASM_STATS
+HotPathStats GetStats()
+{
+    return hot_path_stats;
+}
+
+void ResetStats()
+{
+    hot_path_stats = HotPathStats();
+}
+
+void UnloadFont(std::string familyName)
+{
+    // Unload faces, the fonts unset the current face and drop their cached
+    // glyphs, atlases and sizes
+    face_map.erase(familyName);
+}
+
+FT_Face SelectFont(const std::string &faceName, const std::string &styleName)
+{
+    auto ptr = face_map[faceName][styleName].get();
+    if (ptr == nullptr)
+    {
+        return nullptr;
+    }
+
+    // The face that was current becomes idle from now on
+    Font *previous = FindFont(current_face);
+    if (previous != nullptr)
+    {
+        previous->last_used = NowMs();
+    }
+
+    FT_Face face = ptr->Open();
+    if (face == nullptr)
+    {
+        return nullptr;
+    }
+    current_face = face;
+    EvictIdleFaces();
+    return current_face;
+}
+
+// Size and charmap of the current face are set again if it's reopened
+void RememberSize(const SizeRequest &request)
+{
+    Font *font = FindFont(current_face);
+    if (font != nullptr)
+    {
+        font->size_request = request;
+        font->has_size_request = true;
+    }
+}
+
+void RememberCharmap()
+{
+    Font *font = FindFont(current_face);
+    if (font != nullptr && current_face->charmap != nullptr)
+    {
+        font->encoding = current_face->charmap->encoding;
+    }
+}
+
+FT_Error SetCurrentSize(const SizeRequest &request)
+{
+    if (current_face == NULL)
+    {
+        fprintf(stderr, "FreeType: Unable to set size, font is not set. Use `SetFont` first.");
+        return FT_Err_Invalid_Face_Handle;
+    }
+
+    MemoryTagScope memory_tag(FaceMemoryTag(current_face));
+    FT_Error error = ApplySizeRequest(current_face, request);
+    if (error)
+    {
+        fprintf(stderr, "FreeType: Error setting size.\n");
+        return error;
+    }
+    RememberSize(request);
+    return FT_Err_Ok;
+}
+
+FT_Error SelectCurrentCharmap(FT_Encoding encoding)
+{
+    if (current_face == NULL)
+    {
+        fprintf(stderr, "FreeType: Current font is not set. Unable to set charmap.");
+        return FT_Err_Invalid_Face_Handle;
+    }
+
+    FT_Error error = FT_Select_Charmap(current_face, encoding);
+    if (error)
+    {
+        fprintf(stderr, "FreeType: Error selecting charmap.\n");
+        return error;
+    }
+    RememberCharmap();
+    return FT_Err_Ok;
+}
+
+FT_Error SetCurrentCharmapByIndex(int index)
+{
+    if (current_face == NULL)
+    {
+        fprintf(stderr, "FreeType: Current font is not set. Unable to set charmap.\n");
+        return FT_Err_Invalid_Face_Handle;
+    }
+
+    for (int k = 0; k < current_face->num_charmaps; k++)
+    {
+        if (k == index)
+        {
+            FT_Error error = FT_Set_Charmap(current_face, current_face->charmaps[k]);
+            if (error)
+            {
+                fprintf(stderr, "FreeType: Error setting charmap.\n");
+                return error;
+            }
+            RememberCharmap();
+            return FT_Err_Ok;
+        }
+    }
+
+    fprintf(stderr, "Charmap not found with index '%d'.\n", index);
+    return FT_Err_Invalid_CharMap_Handle;
+}
+
+// https://freetype.org/freetype2/docs/reference/ft2-base_interface.html#ft_load_xxx
+
+// FT_Load_Glyph, with stats enabled the rendering is done with a separate
+// FT_Render_Glyph call so it's timed apart from the loading and hinting. The
+// outline is moved right by `x_offset` before rendering, bitmap glyphs can't
+// be moved.
+FT_Error LoadGlyphSlot(FT_Face face, FT_UInt glyph_index, FT_Int32 load_flags, FT_Pos x_offset)
+{
+    if (!FT_WASM_STATS && x_offset == 0)
+    {
+        return FT_Load_Glyph(face, glyph_index, load_flags);
+    }
+
+    FT_Error error;
+    {
+        FT_STATS_ADD(glyph_loads, 1);
+        FT_STATS_ADD(hinted_glyph_loads, FT_IS_SCALABLE(face) && !(load_flags & FT_LOAD_NO_HINTING) ? 1 : 0);
+        FT_STATS_TIMER(glyph_load_ms);
+        error = FT_Load_Glyph(face, glyph_index, load_flags & ~FT_LOAD_RENDER);
+    }
+    if (error)
+    {
+        return error;
+    }
+    if (x_offset != 0 && face->glyph->format == FT_GLYPH_FORMAT_OUTLINE)
+    {
+        FT_Outline_Translate(&face->glyph->outline, x_offset, 0);
+    }
+    if (!(load_flags & FT_LOAD_RENDER) || face->glyph->format == FT_GLYPH_FORMAT_BITMAP)
+    {
+        return 0;
+    }
+
+    // Same render mode as FT_Load_Glyph picks for FT_LOAD_RENDER
+    FT_Render_Mode mode = FT_LOAD_TARGET_MODE(load_flags);
+    if (mode == FT_RENDER_MODE_NORMAL && (load_flags & FT_LOAD_MONOCHROME))
+    {
+        mode = FT_RENDER_MODE_MONO;
+    }
+    FT_STATS_ADD(glyph_renders, 1);
+    FT_STATS_TIMER(glyph_render_ms);
+    return FT_Render_Glyph(face->glyph, mode);
+}
+
+// Font of the face's snapshot entries
+bool ReadSnapshotFont(FT_Face face, SnapshotFont &font)
+{
+    auto it = face_handles.find(FaceMemoryTag(face));
+    if (it == face_handles.end())
+    {
+        return false;
+    }
+    const Font *owner = it->second;
+    font = {owner->bytes->hash, (uint32_t)owner->bytes->size, (int32_t)owner->face_index};
+    // Instances are told apart by their coordinates
+    if (!owner->coords.empty())
+    {
+        font.hash ^= HashFontBytes((FT_Bytes)owner->coords.data(), owner->coords.size() * sizeof(FT_Fixed));
+    }
+    return true;
+}
+
+// Loads a glyph through the glyph cache, returns NULL if the glyph can't be
+// loaded. The slot is valid until the next load.
+const FT_GlyphSlotRec *LoadCachedGlyph(FT_Face face, FT_UInt glyph_index, FT_Int32 load_flags, FT_Pos x_offset)
+{
+    // Bitmap fonts can't be moved, all bins share the glyph
+    if (!FT_IS_SCALABLE(face))
+    {
+        x_offset = 0;
+    }
+    const GlyphCacheKey key = {face, face->size->metrics.x_scale, face->size->metrics.y_scale, load_flags, glyph_index, x_offset};
+    const CachedGlyph *cached = glyph_cache.Find(key);
+    if (cached != nullptr)
+    {
+        return &cached->slot;
+    }
+
+    // Snapshot glyphs keep their pixels in the snapshot
+    SnapshotFont snapshot_font;
+    const GlyphSnapshotEntry *entry = nullptr;
+    if (glyph_snapshot.EntryCount() > 0 && ReadSnapshotFont(face, snapshot_font))
+    {
+        entry = glyph_snapshot.Find(snapshot_font, key);
+    }
+    if (entry != nullptr)
+    {
+        FT_STATS_ADD(snapshot_glyphs, 1);
+        glyph_snapshot.ReadSlot(*entry, snapshot_slot);
+        auto glyph = std::make_unique<CachedGlyph>(snapshot_slot, true);
+        const size_t bytes = glyph->Bytes();
+        cached = glyph_cache.Insert(key, std::move(glyph), bytes);
+        return cached != nullptr ? &cached->slot : &snapshot_slot;
+    }
+
+    MemoryTagScope memory_tag(FaceMemoryTag(face));
+    FT_Error error = LoadGlyphSlot(face, glyph_index, load_flags, x_offset);
+    if (error)
+    {
+        return NULL;
+    }
+
+    auto glyph = std::make_unique<CachedGlyph>(*face->glyph);
+    const size_t bytes = glyph->Bytes();
+    cached = glyph_cache.Insert(key, std::move(glyph), bytes);
+
+    // Glyphs over the budget are not cached
+    return cached != nullptr ? &cached->slot : face->glyph;
+}
+
+std::vector<FT_ULong> GetCharmapCharcodes(FT_Face face, FT_ULong first_charcode, FT_ULong last_charcode)
+{
+    std::vector<FT_ULong> charcodes;
+    FT_UInt gindex;
+    FT_ULong charcode = first_charcode != 0 ? FT_Get_Next_Char(face, first_charcode - 1, &gindex) : FT_Get_First_Char(face, &gindex);
+    while (gindex != 0 && charcode <= last_charcode)
+    {
+        charcodes.push_back(charcode);
+        charcode = FT_Get_Next_Char(face, charcode, &gindex);
+    }
+    return charcodes;
+}
+
+BitmapView AppendToGlyphBuffer(const FT_Bitmap &bitmap)
+{
+    BitmapView view;
+    const unsigned int apitch = abs(bitmap.pitch);
+    view.rows = bitmap.rows;
+    view.width = bitmap.width;
+    view.pitch = apitch;
+    view.pixel_mode = bitmap.pixel_mode;
+    view.num_grays = bitmap.num_grays;
+    view.offset = glyph_buffer.size();
+    view.length = bitmap.buffer != NULL ? bitmap.rows * apitch : 0;
+
+    // Glyphs loaded without rendering have no pixels
+    if (view.length == 0)
+    {
+        return view;
+    }
+
+    glyph_buffer.resize(view.offset + view.length);
+    unsigned char *dst = glyph_buffer.data() + view.offset;
+
+    if (bitmap.pitch > 0)
+    {
+        ::memcpy(dst, bitmap.buffer, view.length);
+    }
+    else
+    {
+        // Negative pitch means the bottom row is first in the buffer
+        for (unsigned int y = 0; y < bitmap.rows; y++)
+        {
+            ::memcpy(dst + y * apitch, bitmap.buffer + (bitmap.rows - 1 - y) * apitch, apitch);
+        }
+    }
+    return view;
+}
+
+GlyphView MakeGlyphView(const FT_GlyphSlotRec *slot)
+{
+    GlyphView view;
+    view.linearHoriAdvance = slot->linearHoriAdvance;
+    view.linearVertAdvance = slot->linearVertAdvance;
+    view.advance = slot->advance;
+    view.metrics = slot->metrics;
+    view.glyph_index = slot->glyph_index;
+    view.format = slot->format;
+    view.bitmap = AppendToGlyphBuffer(slot->bitmap);
+    view.bitmap_left = slot->bitmap_left;
+    view.bitmap_top = slot->bitmap_top;
+    return view;
+}
+
+void ClearGlyphBuffer()
+{
+    // Capacity is kept, so the next loads don't need to reallocate
+    glyph_buffer.clear();
+}
+
+bool GetGlyphViewBitmap(const BitmapView &view, FT_Bitmap &bitmap)
+{
+    if (view.length == 0 || view.offset + view.length > glyph_buffer.size())
+    {
+        return false;
+    }
+
+    bitmap.rows = view.rows;
+    bitmap.width = view.width;
+    bitmap.pitch = view.pitch;
+    bitmap.buffer = glyph_buffer.data() + view.offset;
+    bitmap.num_grays = view.num_grays;
+    bitmap.pixel_mode = view.pixel_mode;
+    bitmap.palette_mode = 0;
+    bitmap.palette = NULL;
+    return true;
+}
+
+bool ConvertViewBitmap(const BitmapView &view, int format, unsigned int color)
+{
+    FT_Bitmap bitmap;
+    if (!GetGlyphViewBitmap(view, bitmap) || format < BITMAP_FORMAT_ALPHA || format > BITMAP_FORMAT_RGBA_PREMULTIPLIED)
+    {
+        return false;
+    }
+
+    convert_buffer.resize(GetConvertedBytes(bitmap, (BitmapFormat)format));
+    if (!ConvertBitmap(bitmap, (BitmapFormat)format, color, convert_buffer.data()))
+    {
+        fprintf(stderr, "FreeType: Pixel mode '%d' is not supported.\n", bitmap.pixel_mode);
+        return false;
+    }
+    FT_STATS_ADD(bitmap_conversions, 1);
+    FT_STATS_ADD(converted_bytes, convert_buffer.size());
+    return true;
+}
+
+// Loads the glyphs and fills the columns, returns the number of glyphs.
+// Glyphs that fail to load are left out, the charcode column tells which
+// glyph each row is.
+int FillGlyphMetrics(FT_Face face, const std::vector<FT_ULong> &charcodes, FT_Int32 load_flags, int use_sdf)
+{
+    // Rows are written to full size columns, and the columns are packed
+    // after the glyphs are loaded
+    const size_t capacity = charcodes.size();
+    glyph_metrics.resize(GLYPH_METRICS_COLUMNS * capacity);
+    size_t count = 0;
+    ForEachGlyph(face, charcodes, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                 {
+        int32_t *row = glyph_metrics.data() + count;
+        const BitmapView bitmap = AppendToGlyphBuffer(slot->bitmap);
+        row[GLYPH_METRICS_CHARCODE * capacity] = charcode;
+        row[GLYPH_METRICS_GLYPH_INDEX * capacity] = slot->glyph_index;
+        row[GLYPH_METRICS_ADVANCE_X * capacity] = slot->advance.x;
+        row[GLYPH_METRICS_ADVANCE_Y * capacity] = slot->advance.y;
+        row[GLYPH_METRICS_BEARING_X * capacity] = slot->metrics.horiBearingX;
+        row[GLYPH_METRICS_BEARING_Y * capacity] = slot->metrics.horiBearingY;
+        row[GLYPH_METRICS_WIDTH * capacity] = slot->metrics.width;
+        row[GLYPH_METRICS_HEIGHT * capacity] = slot->metrics.height;
+        row[GLYPH_METRICS_BITMAP_WIDTH * capacity] = bitmap.width;
+        row[GLYPH_METRICS_BITMAP_ROWS * capacity] = bitmap.rows;
+        row[GLYPH_METRICS_BITMAP_PITCH * capacity] = bitmap.pitch;
+        row[GLYPH_METRICS_BITMAP_LEFT * capacity] = slot->bitmap_left;
+        row[GLYPH_METRICS_BITMAP_TOP * capacity] = slot->bitmap_top;
+        row[GLYPH_METRICS_BITMAP_OFFSET * capacity] = bitmap.offset;
+        count++; });
+
+    if (count < capacity)
+    {
+        for (size_t column = 1; column < GLYPH_METRICS_COLUMNS; column++)
+        {
+            ::memmove(glyph_metrics.data() + column * count, glyph_metrics.data() + column * capacity, count * sizeof(int32_t));
+        }
+        glyph_metrics.resize(GLYPH_METRICS_COLUMNS * count);
+    }
+    glyph_metrics_count = count;
+    return count;
+}
+
+// Glyph atlas
+//
+// Glyphs are rendered straight into shared 8-bit (or SDF) atlas pages, with a
+// metrics table of UV rects, bearings and advances. Glyphs can be added at any
+// time without repacking, and the dirty rectangles tell which parts of the
+// pages need to be uploaded again.
+
+int CreateAtlasForSize(FT_Size size, int width, int height, int padding, FT_Int32 load_flags, int use_sdf)
+{
+    if (width <= 0 || height <= 0 || padding < 0)
+    {
+        fprintf(stderr, "FreeType: Invalid atlas size.\n");
+        return -1;
+    }
+
+    load_flags |= FT_LOAD_RENDER;
+    if (use_sdf)
+    {
+        load_flags |= FT_LOAD_TARGET_(FT_RENDER_MODE_SDF);
+    }
+
+    const int id = next_atlas_id++;
+    atlases[id] = std::make_unique<FontAtlas>(size, load_flags, width, height, padding);
+    return id;
+}
+
+// Creates an atlas of the current font and size
+int CreateAtlas(int width, int height, int padding, FT_Int32 load_flags, int use_sdf)
+{
+    if (current_face == NULL)
+    {
+        fprintf(stderr, "FreeType: Current font is not set.\n");
+        return -1;
+    }
+    return CreateAtlasForSize(current_face->size, width, height, padding, load_flags, use_sdf);
+}
+
+int CreateAtlasWithSize(int size_handle, int width, int height, int padding, FT_Int32 load_flags, int use_sdf)
+{
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return -1;
+    }
+    return CreateAtlasForSize(handle->size, width, height, padding, load_flags, use_sdf);
+}
+
+void DestroyAtlas(int atlas_id)
+{
+    atlases.erase(atlas_id);
+}
+
+FontAtlas *GetAtlas(int atlas_id)
+{
+    auto it = atlases.find(atlas_id);
+    if (it == atlases.end())
+    {
+        fprintf(stderr, "FreeType: Atlas '%d' not found.\n", atlas_id);
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+const std::vector<int> *AddAtlasGlyphs(int atlas_id, const std::vector<FT_ULong> &charcodes)
+{
+    FontAtlas *state = GetAtlas(atlas_id);
+    if (state == nullptr)
+    {
+        return nullptr;
+    }
+
+    FT_Face face = state->face;
+    ScopedSize scoped_size(state->size);
+    MemoryTagScope memory_tag(FaceMemoryTag(face));
+    if (face->size->metrics.x_scale != state->x_scale || face->size->metrics.y_scale != state->y_scale)
+    {
+        fprintf(stderr, "FreeType: Font size has changed after the atlas was created.\n");
+        return nullptr;
+    }
+
+    state->added.clear();
+    for (auto &c : charcodes)
+    {
+        const FT_UInt gindex = FT_Get_Char_Index(face, c);
+        int entry = gindex == 0 ? -1 : state->atlas.Find(gindex);
+        if (gindex == 0 || entry >= 0)
+        {
+            state->added.push_back(entry);
+            continue;
+        }
+
+        FT_Error error = LoadGlyphSlot(face, gindex, state->load_flags);
+        if (error)
+        {
+            fprintf(stderr, "Can't load char '%lu'\n", c);
+            state->added.push_back(-1);
+            continue;
+        }
+
+        const FT_GlyphSlot slot = face->glyph;
+        const FT_Bitmap &bitmap = slot->bitmap;
+        const unsigned char *pixels = bitmap.buffer;
+        unsigned int width = bitmap.width;
+        unsigned int rows = bitmap.rows;
+        int pitch = bitmap.pitch;
+
+        // Atlas pages are 8-bit, other pixel modes are converted to alpha
+        if (bitmap.buffer != NULL && (bitmap.pixel_mode != FT_PIXEL_MODE_GRAY || bitmap.num_grays != 256))
+        {
+            if (!GetConvertedSize(bitmap, width, rows))
+            {
+                fprintf(stderr, "FreeType: Pixel mode '%d' is not supported.\n", bitmap.pixel_mode);
+                state->added.push_back(-1);
+                continue;
+            }
+            convert_buffer.resize(GetConvertedBytes(bitmap, BITMAP_FORMAT_ALPHA));
+            ConvertBitmap(bitmap, BITMAP_FORMAT_ALPHA, 0, convert_buffer.data());
+            FT_STATS_ADD(bitmap_conversions, 1);
+            FT_STATS_ADD(converted_bytes, convert_buffer.size());
+            pixels = convert_buffer.data();
+            pitch = width;
+        }
+
+        entry = state->atlas.Add(gindex, width, rows, pixels, pitch,
+                                 slot->bitmap_left, slot->bitmap_top,
+                                 slot->advance.x / 64.0f, slot->advance.y / 64.0f);
+        if (entry < 0)
+        {
+            fprintf(stderr, "FreeType: Char '%lu' doesn't fit to the atlas.\n", c);
+        }
+        state->added.push_back(entry);
+    }
+
+    return &state->added;
+}
+
+int AtlasGetPageCount(int atlas_id)
+{
+    FontAtlas *state = GetAtlas(atlas_id);
+    return state == nullptr ? 0 : state->atlas.pages.size();
+}
+
+void AtlasClearDirtyRects(int atlas_id)
+{
+    FontAtlas *state = GetAtlas(atlas_id);
+    if (state != nullptr)
+    {
+        state->atlas.ClearDirty();
+    }
+}
+
+// Glyph cache
+//
+// Glyph loading looks up glyphs from the cache before loading them. Least
+// recently used glyphs are evicted when the cache goes over the budget,
+// budget of 0 disables the cache.
+
+void SetGlyphCacheBudget(size_t bytes)
+{
+    glyph_cache.SetBudget(bytes);
+}
+
+LruCacheStats GetGlyphCacheStats()
+{
+    return glyph_cache.Stats();
+}
+
+void ResetGlyphCacheStats()
+{
+    glyph_cache.ResetStats();
+}
+
+void ClearGlyphCache()
+{
+    glyph_cache.Clear();
+}
+
+void ExportGlyphSnapshot(std::vector<unsigned char> &out)
+{
+    GlyphSnapshotWriter writer;
+    glyph_cache.ForEach([&](const GlyphCacheKey &key, const CachedGlyph &glyph)
+                        {
+        SnapshotFont font;
+        if (ReadSnapshotFont(key.face, font))
+        {
+            writer.Add(font, key, glyph);
+        } });
+    writer.Finish(out);
+}
+
+int ImportGlyphSnapshot(std::vector<unsigned char> snapshot)
+{
+    glyph_cache.Clear();
+    if (!glyph_snapshot.Load(std::move(snapshot)))
+    {
+        fprintf(stderr, "FreeType: Glyph snapshot is not valid for this build.\n");
+        return -1;
+    }
+    return glyph_snapshot.EntryCount();
+}
+
+int ImportGlyphSnapshotView(const unsigned char *data, size_t size)
+{
+    glyph_cache.Clear();
+    if (!glyph_snapshot.LoadView(data, size))
+    {
+        fprintf(stderr, "FreeType: Glyph snapshot is not valid for this build.\n");
+        return -1;
+    }
+    return glyph_snapshot.EntryCount();
+}
+
+void ClearGlyphSnapshot()
+{
+    glyph_cache.Clear();
+    glyph_snapshot.Clear();
+}
+
+FT_Vector GetKerning(FT_UInt left_glyph_index, FT_UInt right_glyph_index, FT_UInt kern_mode)
+{
+    FT_Vector vector;
+    if (current_face == NULL)
+    {
+        fprintf(stderr, "FreeType: Current font is not set.\n");
+        return vector;
+    }
+
+    FT_STATS_ADD(kerning_lookups, 1);
+    FT_Error error = FT_Get_Kerning(current_face, left_glyph_index, right_glyph_index, kern_mode, &vector);
+    if (error)
+    {
+        fprintf(stderr, "Unable to read kerning.\n");
+        return vector;
+    }
+    return vector;
+}
+
+FT_Vector GetKerningWithSize(int size_handle, FT_UInt left_glyph_index, FT_UInt right_glyph_index, FT_UInt kern_mode)
+{
+    FT_Vector vector = {0, 0};
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return vector;
+    }
+
+    ScopedSize scoped_size(handle->size);
+    FT_STATS_ADD(kerning_lookups, 1);
+    FT_Error error = FT_Get_Kerning(handle->font->face, left_glyph_index, right_glyph_index, kern_mode, &vector);
+    if (error)
+    {
+        fprintf(stderr, "Unable to read kerning.\n");
+    }
+    return vector;
+}
+
+std::vector<int32_t> kerning_pairs;
+
+namespace
+{
+    // Reads the pairs of the horizontal format 0 subtables of a Windows
+    // `kern` table, returns false if the face has no such table
+    bool ReadKernTablePairs(FT_Face face, std::vector<std::pair<FT_UInt, FT_UInt>> &pairs)
+    {
+        FT_ULong length = 0;
+        if (!FT_IS_SFNT(face) || FT_Load_Sfnt_Table(face, TTAG_kern, 0, NULL, &length) || length < 4)
+        {
+            return false;
+        }
+        std::vector<FT_Byte> table(length);
+        if (FT_Load_Sfnt_Table(face, TTAG_kern, 0, table.data(), &length))
+        {
+            return false;
+        }
+        auto read_u16 = [&table](FT_ULong offset)
+        { return (FT_UInt)(table[offset] << 8 | table[offset + 1]); };
+
+        // Apple tables are version 1 with a 32-bit header
+        if (read_u16(0) != 0)
+        {
+            return false;
+        }
+        const FT_UInt subtable_count = read_u16(2);
+        FT_ULong offset = 4;
+        for (FT_UInt i = 0; i < subtable_count && offset + 14 <= length; i++)
+        {
+            const FT_UInt subtable_length = read_u16(offset + 2);
+            const FT_UInt coverage = read_u16(offset + 4);
+            // Format 0, horizontal, neither minimum nor cross-stream values
+            if ((coverage & 0xff07) == 0x0001)
+            {
+                // The length field overflows for large subtables, the pair
+                // count is clipped to the table instead
+                const FT_ULong pair_count = std::min<FT_ULong>(read_u16(offset + 6), (length - offset - 14) / 6);
+                for (FT_ULong pair = offset + 14; pair < offset + 14 + pair_count * 6; pair += 6)
+                {
+                    pairs.emplace_back(read_u16(pair), read_u16(pair + 2));
+                }
+            }
+            if (subtable_length == 0)
+            {
+                break;
+            }
+            offset += subtable_length;
+        }
+        return true;
+    }
+}
+
+int FillKerningPairs(FT_Face face, std::vector<FT_UInt> glyph_indices, FT_UInt kern_mode)
+{
+    kerning_pairs.clear();
+    if (!FT_HAS_KERNING(face))
+    {
+        return 0;
+    }
+
+    std::sort(glyph_indices.begin(), glyph_indices.end());
+    glyph_indices.erase(std::unique(glyph_indices.begin(), glyph_indices.end()), glyph_indices.end());
+    auto add_pair = [face, kern_mode](FT_UInt left, FT_UInt right)
+    {
+        FT_Vector vector;
+        if (!FT_Get_Kerning(face, left, right, kern_mode, &vector) && vector.x != 0)
+        {
+            kerning_pairs.push_back(left);
+            kerning_pairs.push_back(right);
+            kerning_pairs.push_back(vector.x);
+        }
+    };
+
+    std::vector<std::pair<FT_UInt, FT_UInt>> table_pairs;
+    if (ReadKernTablePairs(face, table_pairs))
+    {
+        // Only the pairs of the table with both glyphs in the set are looked
+        // up, so the values match `GetKerning`
+        auto in_set = [&glyph_indices](FT_UInt glyph_index)
+        { return std::binary_search(glyph_indices.begin(), glyph_indices.end(), glyph_index); };
+        table_pairs.erase(std::remove_if(table_pairs.begin(), table_pairs.end(),
+                                         [&in_set](const std::pair<FT_UInt, FT_UInt> &pair)
+                                         { return !in_set(pair.first) || !in_set(pair.second); }),
+                          table_pairs.end());
+        std::sort(table_pairs.begin(), table_pairs.end());
+        table_pairs.erase(std::unique(table_pairs.begin(), table_pairs.end()), table_pairs.end());
+        FT_STATS_ADD(kerning_lookups, table_pairs.size());
+        for (const auto &pair : table_pairs)
+        {
+            add_pair(pair.first, pair.second);
+        }
+        return kerning_pairs.size() / KERNING_PAIR_SIZE;
+    }
+
+    // Other kerning sources, such as Type 1 metrics files, can only be
+    // queried pair by pair
+    if (glyph_indices.size() > KERNING_PAIR_SET_LIMIT)
+    {
+        fprintf(stderr, "FreeType: Too many glyphs for kerning pairs without a kern table.\n");
+        return 0;
+    }
+    FT_STATS_ADD(kerning_lookups, glyph_indices.size() * glyph_indices.size());
+    for (FT_UInt left : glyph_indices)
+    {
+        for (FT_UInt right : glyph_indices)
+        {
+            add_pair(left, right);
+        }
+    }
+    return kerning_pairs.size() / KERNING_PAIR_SIZE;
+}
+
+// Face and size handles
+//
+// Handles name faces and sizes explicitly, so several fonts and sizes can be
+// used without `SetFont` and `SetPixelSize` in between. Each size handle has
+// its own FT_Size created with FT_New_Size, it's activated for the duration
+// of each call.
+
+int GetFaceHandle(std::string familyName, std::string styleName)
+{
+    auto family = face_map.find(familyName);
+    if (family == face_map.end())
+    {
+        return -1;
+    }
+    auto style = family->second.find(styleName);
+    if (style == family->second.end())
+    {
+        return -1;
+    }
+    return style->second->handle;
+}
+
+Font *GetFontByHandle(int face_handle)
+{
+    auto it = face_handles.find(face_handle);
+    if (it == face_handles.end())
+    {
+        fprintf(stderr, "FreeType: Face handle '%d' not found.\n", face_handle);
+        return nullptr;
+    }
+    return it->second;
+}
+
+SizeHandle *GetSizeHandle(int size_handle)
+{
+    auto it = size_handles.find(size_handle);
+    if (it == size_handles.end())
+    {
+        fprintf(stderr, "FreeType: Size handle '%d' not found.\n", size_handle);
+        return nullptr;
+    }
+    return &it->second;
+}
+
+// Returns the handle of an existing size with the same request, or creates a
+// new size
+int CreateSizeHandle(int face_handle, const SizeRequest &request)
+{
+    Font *font = GetFontByHandle(face_handle);
+    if (font == nullptr)
+    {
+        return -1;
+    }
+
+    auto existing = font->sizes.find(request);
+    if (existing != font->sizes.end())
+    {
+        return existing->second;
+    }
+
+    FT_Face face = font->Open();
+    if (face == nullptr)
+    {
+        return -1;
+    }
+
+    MemoryTagScope memory_tag(font->handle);
+    FT_Size size;
+    FT_Error error = FT_New_Size(face, &size);
+    if (error)
+    {
+        fprintf(stderr, "FreeType: Unable to create size.\n");
+        return -1;
+    }
+
+    {
+        ScopedSize scoped_size(size);
+        error = ApplySizeRequest(face, request);
+    }
+    if (error)
+    {
+        fprintf(stderr, "FreeType: Error setting size.\n");
+        FT_Done_Size(size);
+        return -1;
+    }
+
+    const int handle = next_handle++;
+    size_handles[handle] = {font, size, request};
+    font->sizes[request] = handle;
+    return handle;
+}
+
+int CreatePixelSize(int face_handle, FT_UInt pixel_width, FT_UInt pixel_height)
+{
+    return CreateSizeHandle(face_handle, std::make_tuple(0, (FT_F26Dot6)pixel_width, (FT_F26Dot6)pixel_height, 0u, 0u));
+}
+
+int CreateCharSize(int face_handle, FT_F26Dot6 char_width, FT_F26Dot6 char_height, FT_UInt horz_resolution, FT_UInt vert_resolution)
+{
+    return CreateSizeHandle(face_handle, std::make_tuple(1, char_width, char_height, horz_resolution, vert_resolution));
+}
+
+void DestroySize(int size_handle)
+{
+    auto it = size_handles.find(size_handle);
+    if (it == size_handles.end())
+    {
+        return;
+    }
+
+    Font *font = it->second.font;
+    FT_Size size = it->second.size;
+    for (auto s = font->sizes.begin(); s != font->sizes.end(); s++)
+    {
+        if (s->second == size_handle)
+        {
+            font->sizes.erase(s);
+            break;
+        }
+    }
+
+    // Atlases of the size can't add glyphs anymore
+    for (auto a = atlases.begin(); a != atlases.end();)
+    {
+        a = a->second->size == size ? atlases.erase(a) : std::next(a);
+    }
+
+    size_handles.erase(it);
+    FT_Done_Size(size);
+    font->last_used = NowMs();
+}
+
+FT_CharMap SelectFaceCharmap(int face_handle, FT_Encoding encoding)
+{
+    Font *font = GetFontByHandle(face_handle);
+    if (font == nullptr)
+    {
+        return nullptr;
+    }
+
+    FT_Face face = font->Open();
+    if (face == nullptr)
+    {
+        return nullptr;
+    }
+
+    FT_Error error = FT_Select_Charmap(face, encoding);
+    if (error)
+    {
+        fprintf(stderr, "FreeType: Error selecting charmap.\n");
+        return nullptr;
+    }
+    font->encoding = encoding;
+    return face->charmap;
+}
+
+// Variation instances
+
+namespace
+{
+    // Reads the axes and named instances of a variable face on first use,
+    // returns false if the face is not variable
+    bool ReadVariations(Font *font)
+    {
+        if (font->variations_read)
+        {
+            if (font->axes.empty())
+            {
+                fprintf(stderr, "FreeType: Face has no variation axes.\n");
+            }
+            return !font->axes.empty();
+        }
+
+        FT_Face face = font->Open();
+        if (face == nullptr)
+        {
+            return false;
+        }
+        if (!FT_HAS_MULTIPLE_MASTERS(face))
+        {
+            font->variations_read = true;
+            fprintf(stderr, "FreeType: Face has no variation axes.\n");
+            return false;
+        }
+
+        MemoryTagScope memory_tag(font->handle);
+        FT_MM_Var *mm;
+        if (FT_Get_MM_Var(face, &mm))
+        {
+            fprintf(stderr, "FreeType: Unable to read the variation axes.\n");
+            return false;
+        }
+        // Axis names are freed with the MM_Var
+        font->axes.assign(mm->axis, mm->axis + mm->num_axis);
+        for (auto &axis : font->axes)
+        {
+            axis.name = nullptr;
+        }
+        for (FT_UInt i = 0; i < mm->num_namedstyles; i++)
+        {
+            font->named_instances.emplace_back(mm->namedstyle[i].coords, mm->namedstyle[i].coords + mm->num_axis);
+        }
+        FT_Done_MM_Var(GetOrDeleteLibrary(), mm);
+        font->variations_read = true;
+        return !font->axes.empty();
+    }
+
+    // Snaps the coordinate to the steps of the axis, counted from the default
+    // so the default stays exact
+    FT_Fixed SnapAxisCoord(const FT_Var_Axis &axis, FT_Fixed value)
+    {
+        const double step = (double)(axis.maximum - axis.minimum) / VARIATION_AXIS_STEPS;
+        if (step <= 0)
+        {
+            return axis.def;
+        }
+        const FT_Fixed snapped = axis.def + (FT_Fixed)llround(llround((value - axis.def) / step) * step);
+        return std::max(axis.minimum, std::min(axis.maximum, snapped));
+    }
+
+    // Returns the instance of the face at the coordinates, the face itself at
+    // the default coordinates
+    int GetInstanceHandle(Font *font, const std::vector<FT_Fixed> &coords)
+    {
+        auto found = font->instances.find(coords);
+        if (found == font->instances.end())
+        {
+            bool is_default = true;
+            for (size_t i = 0; i < font->axes.size(); i++)
+            {
+                is_default = is_default && coords[i] == font->axes[i].def;
+            }
+            if (is_default)
+            {
+                return font->handle;
+            }
+            found = font->instances.emplace(coords, std::make_unique<Font>(font, coords)).first;
+        }
+        found->second->last_used = NowMs();
+        return found->second->handle;
+    }
+
+    // Instances are made of the face they were created from
+    Font *GetVariableFont(int face_handle)
+    {
+        Font *font = GetFontByHandle(face_handle);
+        return font != nullptr && font->base != nullptr ? font->base : font;
+    }
+}
+
+bool ReadVariationInfo(int face_handle, VariationInfo &info)
+{
+    Font *instance = GetFontByHandle(face_handle);
+    Font *font = GetVariableFont(face_handle);
+    if (font == nullptr || !ReadVariations(font))
+    {
+        return false;
+    }
+
+    const std::vector<FT_Var_Axis> &axes = font->axes;
+    info.axes.clear();
+    info.coords.clear();
+    for (size_t i = 0; i < axes.size(); i++)
+    {
+        const FT_Var_Axis &axis = axes[i];
+        const char tag[] = {(char)(axis.tag >> 24), (char)(axis.tag >> 16), (char)(axis.tag >> 8), (char)axis.tag};
+        info.axes.push_back({std::string(tag, 4), axis.minimum / 65536.0, axis.def / 65536.0, axis.maximum / 65536.0});
+        info.coords.push_back((i < instance->coords.size() ? instance->coords[i] : axis.def) / 65536.0);
+    }
+    info.named_instances = font->named_instances.size();
+    info.instances = font->instances.size();
+    return true;
+}
+
+int GetVariationInstance(int face_handle, const std::vector<double> &coords)
+{
+    Font *font = GetVariableFont(face_handle);
+    if (font == nullptr || !ReadVariations(font))
+    {
+        return -1;
+    }
+
+    const std::vector<FT_Var_Axis> &axes = font->axes;
+    std::vector<FT_Fixed> snapped(axes.size());
+    for (size_t i = 0; i < axes.size(); i++)
+    {
+        snapped[i] = i < coords.size() ? SnapAxisCoord(axes[i], (FT_Fixed)llround(coords[i] * 65536.0)) : axes[i].def;
+    }
+    return GetInstanceHandle(font, snapped);
+}
+
+int GetNamedInstance(int face_handle, int instance_index)
+{
+    Font *font = GetVariableFont(face_handle);
+    if (font == nullptr || !ReadVariations(font))
+    {
+        return -1;
+    }
+    if (instance_index < 0 || instance_index >= (int)font->named_instances.size())
+    {
+        fprintf(stderr, "FreeType: Named instance '%d' not found.\n", instance_index);
+        return -1;
+    }
+
+    // Named instances are not snapped
+    return GetInstanceHandle(font, font->named_instances[instance_index]);
+}
+
+int ClearVariationInstances(int face_handle)
+{
+    Font *font = GetVariableFont(face_handle);
+    if (font == nullptr)
+    {
+        return 0;
+    }
+    const int count = font->instances.size();
+    font->instances.clear();
+    return count;
+}
+
+// Parallel loading
+//
+// Glyphs of a size handle are loaded on a worker pool, each worker opens the
+// face over the shared font bytes. Without pthreads the pool has only the
+// calling thread.
+
+#ifndef FT_WASM_MAX_THREADS
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define FT_WASM_MAX_THREADS 1
+#else
+#define FT_WASM_MAX_THREADS 64
+#endif
+#endif
+
+// Sets the number of threads loading glyphs, returns the number used
+int SetWorkerCount(int num_workers)
+{
+    const int count = std::max(1, std::min(num_workers, FT_WASM_MAX_THREADS));
+    if (!rasterizer || (int)rasterizer->Size() != count)
+    {
+        rasterizer.reset();
+        rasterizer = std::make_unique<ParallelRasterizer>(count);
+    }
+    return count;
+}
+
+int GetWorkerCount()
+{
+    return rasterizer ? rasterizer->Size() : 1;
+}
@@ -0,0 +1,705 @@
+#pragma once
+
+// Wrapper core without emscripten: font registry, glyph loading, glyph
+// buffer and metrics columns, atlases, kerning, size handles and parallel
+// loading. `ft.cpp` binds it to JS, native builds use it directly, see
+// CMakeLists.txt.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <freetype/freetype.h>
+#include <freetype/ftmm.h>
+#include <freetype/ftsizes.h>
+
+#include "atlas.h"
+#include "char_coverage.h"
+#include "convert.h"
+#include "face_scan.h"
+#include "ft_memory.h"
+#include "glyph_cache.h"
+#include "glyph_snapshot.h"
+#include "outline.h"
+#include "parallel_raster.h"
+#include "sdf.h"
+#include "shaper.h"
+#include "stats.h"
+#include "webfont.h"
+
+// Face of `SetFont`, used by the calls without a size handle
+extern FT_Face current_face;
+
+// Allocator of the library, FreeType allocations of each face are accounted
+// to its handle
+extern TrackedMemory ft_memory;
+
+// Milliseconds from an arbitrary start, for timeouts and time budgets
+double NowMs();
+
+class FontPtr
+{
+public:
+    // Allocates the font storage, the bytes are written by the caller
+    FontPtr(size_t font_size)
+    {
+        size = font_size;
+        bytes = (FT_Bytes)::malloc(size);
+        hash = 0;
+        format = FONT_FORMAT_SFNT;
+        sfnt = bytes;
+        sfnt_size = size;
+        decode_ms = 0;
+    }
+
+    ~FontPtr()
+    {
+        // printf("free bytes?\n");
+        ::free((void *)bytes);
+    }
+
+    signed long size;
+    FT_Bytes bytes;
+    uint64_t hash;
+
+    // Faces are opened from the sfnt, which is the font itself or the
+    // decoded WOFF font. The original bytes are kept for deduplication.
+    FontFormat format;
+    std::vector<unsigned char> decoded;
+    FT_Bytes sfnt;
+    signed long sfnt_size;
+    double decode_ms;
+};
+
+struct FontStorageStats
+{
+    size_t fonts;
+    size_t bytes;
+    size_t decoded_bytes;
+    size_t pending_bytes;
+    size_t shared_loads;
+};
+
+struct FontSourceInfo
+{
+    int format;
+    size_t size;
+    size_t sfnt_size;
+    double decode_ms;
+};
+
+// Unicode coverage of a face, see char_coverage.h
+struct CoverageInfo
+{
+    size_t codepoints;
+    size_t ranges;
+    size_t bytes;
+};
+
+struct FaceInfo
+{
+    int face_handle;
+    FT_Long face_index;
+    std::string family_name;
+    std::string style_name;
+    FT_Long style_flags;
+};
+
+// Coverage bytes of glyphs loaded as glyph views
+extern std::vector<unsigned char> glyph_buffer;
+
+// Columns of `FillGlyphMetrics`, each `glyph_metrics_count` values long
+extern std::vector<int32_t> glyph_metrics;
+extern size_t glyph_metrics_count;
+
+// Output of `ConvertViewBitmap`, and scratch space of other conversions
+extern std::vector<unsigned char> convert_buffer;
+
+// Rendered glyphs, so repeated loads are lookups instead of rasterization
+extern GlyphCache glyph_cache;
+
+// Glyphs of a previous process, see `ImportGlyphSnapshot`
+extern GlyphSnapshot glyph_snapshot;
+
+// Glyph atlas bound to a face and size
+class FontAtlas
+{
+public:
+    FontAtlas(FT_Size ft_size, FT_Int32 flags, int width, int height, int padding)
+        : atlas(width, height, padding)
+    {
+        size = ft_size;
+        face = size->face;
+        x_scale = size->metrics.x_scale;
+        y_scale = size->metrics.y_scale;
+        load_flags = flags;
+    }
+
+    GlyphAtlas atlas;
+    FT_Face face;
+    FT_Size size;
+    FT_Fixed x_scale;
+    FT_Fixed y_scale;
+    FT_Int32 load_flags;
+    // Entry indices of the last `AddAtlasGlyphs` call
+    std::vector<int> added;
+};
+
+class Font;
+
+// Size objects created with `CreateSizeHandle`, each keeps its own scaling
+// and hinting state, so switching between them doesn't recompute anything
+struct SizeHandle
+{
+    Font *font;
+    FT_Size size;
+    SizeRequest request;
+};
+
+extern std::map<int, Font *> face_handles;
+extern std::map<int, SizeHandle> size_handles;
+
+class Font
+{
+public:
+    // Face that is opened with `Open` right away
+    Font(std::shared_ptr<FontPtr> ptr, FT_Long index);
+
+    // Face that is opened on first use
+    Font(const FaceScanInfo &info, std::shared_ptr<FontPtr> ptr);
+
+    // Variation instance of the face with the design coordinates, opened on
+    // first use
+    Font(Font *instance_of, const std::vector<FT_Fixed> &instance_coords);
+
+    ~Font();
+
+    // Returns the face, opens it if it's not open
+    FT_Face Open();
+
+    void Close();
+
+    // Lazy faces can be closed when nothing refers to the face
+    bool IsIdle(double now) const;
+
+    FT_Face face;
+    std::shared_ptr<FontPtr> bytes;
+    int handle;
+    FT_Long face_index;
+    FT_Long style_flags;
+    bool lazy;
+    double last_used = 0;
+    // Size request -> size handle
+    std::map<SizeRequest, int> sizes;
+    // Charmap and size of the face, set with `SetCharmap`, `SetPixelSize`...
+    FT_Encoding encoding = FT_ENCODING_NONE;
+    SizeRequest size_request;
+    bool has_size_request = false;
+    // Unicode coverage, built when the face is first opened and kept when
+    // it's closed
+    CharCoverage coverage;
+    // Face of a variation instance and its design coordinates, null and
+    // empty for faces
+    Font *base = nullptr;
+    std::vector<FT_Fixed> coords;
+    // Variation instances of the face by design coordinates
+    std::map<std::vector<FT_Fixed>, std::unique_ptr<Font>> instances;
+    // Axes and named instance coordinates of a variable face, read once and
+    // kept when the face is closed. Axis names are not kept.
+    bool variations_read = false;
+    std::vector<FT_Var_Axis> axes;
+    std::vector<std::vector<FT_Fixed>> named_instances;
+
+private:
+    void Register();
+};
+
+// Activates a size for the scope, and restores the size that was active
+// before, so `SetPixelSize` and `SetCharSize` keep changing the face's own
+// size. FT_Activate_Size only swaps a pointer.
+class ScopedSize
+{
+public:
+    explicit ScopedSize(FT_Size size)
+    {
+        previous = size->face->size;
+        FT_Activate_Size(size);
+    }
+
+    ~ScopedSize()
+    {
+        FT_Activate_Size(previous);
+    }
+
+private:
+    FT_Size previous;
+};
+
+FT_Library GetOrDeleteLibrary(bool deleteLibrary = false);
+void Cleanup();
+
+// Fonts
+//
+// Fonts are stored once per content, and their faces are registered by
+// family and style name.
+
+std::shared_ptr<FontPtr> StoreFont(std::unique_ptr<FontPtr> font);
+std::vector<FT_FaceRec> LoadFaces(std::shared_ptr<FontPtr> fns);
+std::vector<FaceInfo> LoadFaceInfos(std::shared_ptr<FontPtr> fns);
+
+// Copies the bytes to a new font storage, returns null if out of memory
+std::unique_ptr<FontPtr> CopyFontBytes(const unsigned char *bytes, size_t size);
+
+// Font storage written by the caller and loaded later, keyed by the address
+// of its bytes
+unsigned char *AllocatePendingFont(size_t size);
+FontPtr *GetPendingFont(uintptr_t address);
+std::unique_ptr<FontPtr> TakePendingFont(uintptr_t address);
+
+void UnloadFont(std::string familyName);
+FontStorageStats GetFontStorageStats();
+bool ReadFontSourceInfo(int face_handle, FontSourceInfo &info);
+
+// Coverage of the face, faces of `LoadFaceInfos` are opened to build it
+bool ReadFaceCoverage(int face_handle, CoverageInfo &info);
+
+Font *FindFont(FT_Face face);
+int FaceMemoryTag(FT_Face face);
+int EvictIdleFaces();
+void SetFaceIdleTimeout(double timeout_ms);
+bool IsFaceOpen(int face_handle);
+
+MemoryStats GetMemoryStats();
+bool ReadFaceMemoryStats(int face_handle, MemoryStats &stats);
+void ResetMemoryPeaks();
+void SetMemoryLimit(size_t bytes);
+size_t GetMemoryPoolBytes();
+
+HotPathStats GetStats();
+void ResetStats();
+
+// Current face
+//
+// Setters of the legacy API, errors are reported to stderr and returned.
+
+FT_Face SelectFont(const std::string &faceName, const std::string &styleName);
+FT_Error SetCurrentSize(const SizeRequest &request);
+FT_Error SelectCurrentCharmap(FT_Encoding encoding);
+FT_Error SetCurrentCharmapByIndex(int index);
+
+// Glyph loading
+
+FT_Error LoadGlyphSlot(FT_Face face, FT_UInt glyph_index, FT_Int32 load_flags, FT_Pos x_offset = 0);
+const FT_GlyphSlotRec *LoadCachedGlyph(FT_Face face, FT_UInt glyph_index, FT_Int32 load_flags, FT_Pos x_offset = 0);
+
+// Subpixel positioning
+//
+// Glyphs are rendered at `bins` fractional x offsets per pixel, bin `i` is
+// moved right by i / bins pixels. Works best without horizontal hinting,
+// e.g. FT_LOAD_TARGET_LIGHT.
+const int MAX_SUBPIXEL_BINS = 64;
+
+// Offset of the bin in 26.6 pixels
+inline FT_Pos SubpixelOffset(int bin, int bins)
+{
+    return bin * 64 / bins;
+}
+
+// Splits the 26.6 pen position to whole pixels and the nearest bin. The
+// fraction rounds up to the next pixel when it's closer than the last bin.
+inline int SubpixelBin(FT_Pos x, int bins, FT_Pos *pixel_x)
+{
+    const int bin = (int)(((x & 63) * bins + 32) >> 6);
+    *pixel_x = (x >> 6) + (bin == bins ? 1 : 0);
+    return bin == bins ? 0 : bin;
+}
+
+// Loads glyphs of the face's charmap between `first_charcode` and
+// `last_charcode`, calls `on_glyph(charcode, slot)` for each loaded glyph
+template <typename F>
+void ForEachCharmapGlyph(FT_Face face, FT_ULong first_charcode, FT_ULong last_charcode, FT_Int32 load_flags, int use_sdf, F on_glyph)
+{
+    FT_UInt gindex;
+    FT_ULong charcode;
+
+    if (first_charcode != 0)
+    {
+        charcode = FT_Get_Next_Char(face, first_charcode - 1, &gindex);
+    }
+    else
+    {
+        charcode = FT_Get_First_Char(face, &gindex);
+    }
+
+
+    if (use_sdf > 0) {
+        load_flags |= FT_LOAD_TARGET_(FT_RENDER_MODE_SDF);
+    }
+
+    while (gindex != 0)
+    {
+        const FT_GlyphSlotRec *slot = LoadCachedGlyph(face, gindex, load_flags);
+        if (slot == NULL)
+        {
+            fprintf(stderr, "Can't load char '%lu'\n", charcode);
+            charcode = FT_Get_Next_Char(face, charcode, &gindex);
+            if (charcode > last_charcode)
+            {
+                break;
+            }
+            continue;
+        }
+        on_glyph(charcode, slot);
+        charcode = FT_Get_Next_Char(face, charcode, &gindex);
+        if (charcode > last_charcode)
+        {
+            break;
+        }
+    }
+}
+
+// Like `ForEachCharmapGlyph`, but stops after `max_glyphs` glyphs or when
+// `time_budget_ms` has passed, 0 is no limit. At least one glyph is loaded.
+// Returns false if stopped, `next_charcode` is then the charcode to continue
+// from.
+template <typename F>
+bool ForEachCharmapGlyphSliced(FT_Face face, FT_ULong first_charcode, FT_ULong last_charcode, FT_Int32 load_flags, int use_sdf,
+                               unsigned int max_glyphs, double time_budget_ms, FT_ULong &next_charcode, F on_glyph)
+{
+    const double start = NowMs();
+    unsigned int loaded = 0;
+    FT_UInt gindex;
+    FT_ULong charcode;
+
+    if (first_charcode != 0)
+    {
+        charcode = FT_Get_Next_Char(face, first_charcode - 1, &gindex);
+    }
+    else
+    {
+        charcode = FT_Get_First_Char(face, &gindex);
+    }
+
+    if (use_sdf > 0)
+    {
+        load_flags |= FT_LOAD_TARGET_(FT_RENDER_MODE_SDF);
+    }
+
+    while (gindex != 0 && charcode <= last_charcode)
+    {
+        if (loaded > 0 && ((max_glyphs > 0 && loaded >= max_glyphs) ||
+                           (time_budget_ms > 0 && NowMs() - start >= time_budget_ms)))
+        {
+            next_charcode = charcode;
+            return false;
+        }
+
+        const FT_GlyphSlotRec *slot = LoadCachedGlyph(face, gindex, load_flags);
+        if (slot == NULL)
+        {
+            fprintf(stderr, "Can't load char '%lu'\n", charcode);
+        }
+        else
+        {
+            on_glyph(charcode, slot);
+        }
+        loaded++;
+        charcode = FT_Get_Next_Char(face, charcode, &gindex);
+    }
+    return true;
+}
+
+// Loads the glyphs of `charcodes`, calls `on_glyph(charcode, slot)` for each
+// loaded glyph
+template <typename F>
+void ForEachGlyph(FT_Face face, const std::vector<FT_ULong> &charcodes, FT_Int32 load_flags, int use_sdf, F on_glyph)
+{
+    if (use_sdf) {
+        load_flags |= FT_LOAD_TARGET_(FT_RENDER_MODE_SDF);
+    }
+
+    for (auto &c : charcodes)
+    {
+        const FT_GlyphSlotRec *slot = LoadCachedGlyph(face, FT_Get_Char_Index(face, c), load_flags);
+        if (slot == NULL)
+        {
+            fprintf(stderr, "Can't load char '%lu'\n", c);
+            continue;
+        }
+
+        on_glyph(c, slot);
+    }
+}
+
+// Charcodes of the face's charmap between `first_charcode` and
+// `last_charcode`
+std::vector<FT_ULong> GetCharmapCharcodes(FT_Face face, FT_ULong first_charcode, FT_ULong last_charcode);
+
+// Glyph views
+//
+// Glyph views don't convert bitmaps, the coverage bytes are appended to the
+// glyph buffer, and each glyph gets an offset and length into it.
+
+struct BitmapView
+{
+    unsigned int rows;
+    unsigned int width;
+    // Rows are stored top-down, so pitch is never negative
+    int pitch;
+    unsigned char pixel_mode;
+    unsigned short num_grays;
+    unsigned int offset;
+    unsigned int length;
+};
+
+struct GlyphView
+{
+    FT_Fixed linearHoriAdvance;
+    FT_Fixed linearVertAdvance;
+    FT_Vector advance;
+    FT_Glyph_Metrics metrics;
+    FT_UInt glyph_index;
+    FT_Glyph_Format format;
+    BitmapView bitmap;
+    FT_Int bitmap_left;
+    FT_Int bitmap_top;
+};
+
+BitmapView AppendToGlyphBuffer(const FT_Bitmap &bitmap);
+GlyphView MakeGlyphView(const FT_GlyphSlotRec *slot);
+void ClearGlyphBuffer();
+
+// Bitmap of a glyph view, returns false if the view is not in the glyph buffer
+bool GetGlyphViewBitmap(const BitmapView &view, FT_Bitmap &bitmap);
+
+// Converts the bitmap of a glyph view to one of BITMAP_FORMAT_*, the pixels
+// are in `convert_buffer` until the next conversion
+bool ConvertViewBitmap(const BitmapView &view, int format, unsigned int color);
+
+// Glyph metrics columns
+//
+// Lengths are in 26.6 pixels, bitmap values in pixels, and bitmaps are
+// appended to the glyph buffer like glyph views.
+
+enum GlyphMetricsColumn
+{
+    GLYPH_METRICS_CHARCODE,
+    GLYPH_METRICS_GLYPH_INDEX,
+    GLYPH_METRICS_ADVANCE_X,
+    GLYPH_METRICS_ADVANCE_Y,
+    GLYPH_METRICS_BEARING_X,
+    GLYPH_METRICS_BEARING_Y,
+    GLYPH_METRICS_WIDTH,
+    GLYPH_METRICS_HEIGHT,
+    GLYPH_METRICS_BITMAP_WIDTH,
+    GLYPH_METRICS_BITMAP_ROWS,
+    GLYPH_METRICS_BITMAP_PITCH,
+    GLYPH_METRICS_BITMAP_LEFT,
+    GLYPH_METRICS_BITMAP_TOP,
+    GLYPH_METRICS_BITMAP_OFFSET,
+    GLYPH_METRICS_COLUMNS
+};
+
+int FillGlyphMetrics(FT_Face face, const std::vector<FT_ULong> &charcodes, FT_Int32 load_flags, int use_sdf);
+
+// Glyph atlas
+
+int CreateAtlasForSize(FT_Size size, int width, int height, int padding, FT_Int32 load_flags, int use_sdf);
+int CreateAtlas(int width, int height, int padding, FT_Int32 load_flags, int use_sdf);
+int CreateAtlasWithSize(int size_handle, int width, int height, int padding, FT_Int32 load_flags, int use_sdf);
+void DestroyAtlas(int atlas_id);
+FontAtlas *GetAtlas(int atlas_id);
+
+// Adds glyphs to the atlas, returns the entry index of each charcode, or -1
+// if the glyph is missing or doesn't fit. Null if the atlas can't be used.
+const std::vector<int> *AddAtlasGlyphs(int atlas_id, const std::vector<FT_ULong> &charcodes);
+
+int AtlasGetPageCount(int atlas_id);
+void AtlasClearDirtyRects(int atlas_id);
+
+// Glyph cache
+
+void SetGlyphCacheBudget(size_t bytes);
+LruCacheStats GetGlyphCacheStats();
+void ResetGlyphCacheStats();
+void ClearGlyphCache();
+
+// Glyph cache snapshots, see glyph_snapshot.h
+
+// Writes the cached glyphs to a snapshot
+void ExportGlyphSnapshot(std::vector<unsigned char> &out);
+
+// Loads the snapshot, glyphs that are not cached are taken from it instead
+// of loading them. The glyph cache is cleared, its entries may use the
+// pixels of the previous snapshot. Returns the number of entries, or -1 if
+// the snapshot is not valid for this build.
+int ImportGlyphSnapshot(std::vector<unsigned char> snapshot);
+// Like `ImportGlyphSnapshot` without copying the bytes, see
+// `GlyphSnapshot::LoadView`
+int ImportGlyphSnapshotView(const unsigned char *data, size_t size);
+void ClearGlyphSnapshot();
+
+// Kerning
+
+FT_Vector GetKerning(FT_UInt left_glyph_index, FT_UInt right_glyph_index, FT_UInt kern_mode);
+FT_Vector GetKerningWithSize(int size_handle, FT_UInt left_glyph_index, FT_UInt right_glyph_index, FT_UInt kern_mode);
+
+// Kerning pair rows: left glyph index, right glyph index and horizontal
+// kerning, sorted by left and then right glyph index so a pair can be found
+// with a binary search. FT_KERNING_UNSCALED gives font units.
+const int KERNING_PAIR_SIZE = 3;
+
+extern std::vector<int32_t> kerning_pairs;
+
+// Glyph sets larger than this are refused for faces that have kerning but
+// no `kern` table, since those are looked up pair by pair.
+const size_t KERNING_PAIR_SET_LIMIT = 1024;
+
+// Writes the kerning of every pair of the glyphs to `kerning_pairs` with the
+// active size of the face, pairs without kerning are left out. Returns the
+// number of pairs. With a `kern` table this walks the table once and looks
+// up only its pairs, otherwise it costs one lookup per ordered pair of the
+// set, n² for n glyphs.
+int FillKerningPairs(FT_Face face, std::vector<FT_UInt> glyph_indices, FT_UInt kern_mode);
+
+// Face and size handles
+
+int GetFaceHandle(std::string familyName, std::string styleName);
+Font *GetFontByHandle(int face_handle);
+SizeHandle *GetSizeHandle(int size_handle);
+int CreateSizeHandle(int face_handle, const SizeRequest &request);
+int CreatePixelSize(int face_handle, FT_UInt pixel_width, FT_UInt pixel_height);
+int CreateCharSize(int face_handle, FT_F26Dot6 char_width, FT_F26Dot6 char_height, FT_UInt horz_resolution, FT_UInt vert_resolution);
+void DestroySize(int size_handle);
+
+// Selects the charmap of the face, returns null on error
+FT_CharMap SelectFaceCharmap(int face_handle, FT_Encoding encoding);
+
+// Variation instances
+//
+// Each instance of a variable face is a face handle of its own, opened over
+// the same font bytes with its design coordinates set, so it keeps its own
+// sizes and glyph cache entries. Switching back to an instance that was used
+// before doesn't set coordinates or render glyphs again. Coordinates are
+// snapped to VARIATION_AXIS_STEPS steps of each axis range, counted from the
+// default, so an animated axis maps to a bounded number of instances.
+const int VARIATION_AXIS_STEPS = 256;
+
+// Axis of a variable face, values in design units
+struct VariationAxis
+{
+    std::string tag;
+    double minimum;
+    double default_value;
+    double maximum;
+};
+
+struct VariationInfo
+{
+    std::vector<VariationAxis> axes;
+    int named_instances;
+    // Design coordinates of the face handle, one per axis
+    std::vector<double> coords;
+    // Instances of the face created so far
+    int instances;
+};
+
+// Axes of the face, false if the face is not variable
+bool ReadVariationInfo(int face_handle, VariationInfo &info);
+
+// Returns the face handle of the instance at the design coordinates, the
+// face itself at the default coordinates. Missing coordinates are the axis
+// defaults. Returns -1 on error.
+int GetVariationInstance(int face_handle, const std::vector<double> &coords);
+
+// Returns the face handle of the named instance `instance_index`, counted
+// from 0, or -1 on error
+int GetNamedInstance(int face_handle, int instance_index);
+
+// Closes the instances of the face with their sizes and cached glyphs,
+// returns their number
+int ClearVariationInstances(int face_handle);
+
+// Parallel loading
+
+// Worker pool of the parallel loading calls
+extern std::unique_ptr<ParallelRasterizer> rasterizer;
+
+int SetWorkerCount(int num_workers);
+int GetWorkerCount();
+
+// Loads the glyphs of `charcodes` on the workers, glyphs in the glyph cache
+// are not loaded again. Calls `on_glyph(charcode, slot)` in the order of
+// `charcodes`, the new glyphs are added to the cache after that.
+template <typename F>
+void ForEachGlyphParallel(SizeHandle *handle, const std::vector<FT_ULong> &charcodes, FT_Int32 load_flags, int use_sdf, F on_glyph)
+{
+    if (use_sdf)
+    {
+        load_flags |= FT_LOAD_TARGET_(FT_RENDER_MODE_SDF);
+    }
+    if (!rasterizer)
+    {
+        SetWorkerCount(1);
+    }
+
+    Font *font = handle->font;
+    FT_Face face = font->face;
+    ScopedSize scoped_size(handle->size);
+    GlyphCacheKey key = {face, face->size->metrics.x_scale, face->size->metrics.y_scale, load_flags, 0, 0};
+
+    // Glyph indices that are not cached, each loaded once
+    std::vector<FT_UInt> glyph_indices(charcodes.size());
+    std::vector<FT_UInt> missing;
+    std::map<FT_UInt, size_t> missing_slots;
+    for (size_t i = 0; i < charcodes.size(); i++)
+    {
+        key.glyph_index = glyph_indices[i] = FT_Get_Char_Index(face, charcodes[i]);
+        if (glyph_cache.Find(key) == nullptr && missing_slots.count(key.glyph_index) == 0)
+        {
+            missing_slots[key.glyph_index] = missing.size();
+            missing.push_back(key.glyph_index);
+        }
+    }
+
+    FaceSource source = {font->bytes, font->bytes->sfnt, font->bytes->sfnt_size, font->face_index, font->coords};
+    FT_STATS_ADD(parallel_glyph_loads, missing.size());
+    std::vector<std::unique_ptr<CachedGlyph>> loaded;
+    {
+        FT_STATS_TIMER(parallel_load_ms);
+        loaded = rasterizer->LoadGlyphs(source, handle->request, missing, load_flags);
+    }
+
+    // Nothing is added to the cache before all glyphs are passed on, so the
+    // cached glyphs are not evicted in between
+    for (size_t i = 0; i < charcodes.size(); i++)
+    {
+        key.glyph_index = glyph_indices[i];
+        const CachedGlyph *glyph = glyph_cache.Find(key);
+        if (glyph == nullptr)
+        {
+            glyph = loaded[missing_slots[key.glyph_index]].get();
+        }
+        if (glyph == nullptr)
+        {
+            fprintf(stderr, "Can't load char '%lu'\n", charcodes[i]);
+            continue;
+        }
+        on_glyph(charcodes[i], &glyph->slot);
+    }
+
+    for (size_t i = 0; i < missing.size(); i++)
+    {
+        if (loaded[i])
+        {
+            key.glyph_index = missing[i];
+            const size_t bytes = loaded[i]->Bytes();
+            glyph_cache.Insert(key, std::move(loaded[i]), bytes);
+        }
+    }
+}
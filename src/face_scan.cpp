@@ -0,0 +1,307 @@
+#include <string.h>
+
+#include <freetype/freetype.h>
+#include <freetype/ttnameid.h>
+
+#include "face_scan.h"
+
+namespace
+{
+    struct Reader
+    {
+        const unsigned char *bytes;
+        size_t size;
+
+        bool Has(size_t offset, size_t length) const
+        {
+            return offset <= size && length <= size - offset;
+        }
+
+        unsigned int U16(size_t offset) const
+        {
+            return (bytes[offset] << 8) | bytes[offset + 1];
+        }
+
+        unsigned long U32(size_t offset) const
+        {
+            return ((unsigned long)bytes[offset] << 24) | ((unsigned long)bytes[offset + 1] << 16) |
+                   ((unsigned long)bytes[offset + 2] << 8) | bytes[offset + 3];
+        }
+    };
+
+    struct Table
+    {
+        size_t offset;
+        size_t length;
+    };
+
+    bool FindTable(const Reader &font, size_t sfnt_offset, const char *tag, Table &table)
+    {
+        if (!font.Has(sfnt_offset, 12))
+        {
+            return false;
+        }
+        const unsigned int num_tables = font.U16(sfnt_offset + 4);
+        if (!font.Has(sfnt_offset + 12, 16 * (size_t)num_tables))
+        {
+            return false;
+        }
+        for (unsigned int i = 0; i < num_tables; i++)
+        {
+            const size_t record = sfnt_offset + 12 + 16 * i;
+            if (memcmp(font.bytes + record, tag, 4) == 0)
+            {
+                table.offset = font.U32(record + 8);
+                table.length = font.U32(record + 12);
+                return font.Has(table.offset, table.length);
+            }
+        }
+        return false;
+    }
+
+    // FreeType replaces characters outside of printable ASCII with '?'
+    std::string DecodeName(const unsigned char *string, size_t length, bool utf16)
+    {
+        std::string name;
+        const size_t step = utf16 ? 2 : 1;
+        for (size_t i = 0; i + step <= length; i += step)
+        {
+            unsigned int code = utf16 ? (string[i] << 8) | string[i + 1] : string[i];
+            if (code == 0)
+            {
+                break;
+            }
+            name.push_back(code < 32 || code > 127 ? '?' : (char)code);
+        }
+        return name;
+    }
+
+    // Same record preference as FreeType's `tt_face_get_name`: English
+    // Windows names, then English Apple names, then other Apple Roman and
+    // Unicode names
+    bool GetName(const Reader &font, const Table &name_table, unsigned int name_id, std::string &name)
+    {
+        if (name_table.length < 6)
+        {
+            return false;
+        }
+        const size_t count = font.U16(name_table.offset + 2);
+        const size_t strings = name_table.offset + font.U16(name_table.offset + 4);
+        if (name_table.length < 6 + 12 * count)
+        {
+            return false;
+        }
+
+        long found_win = -1, found_apple = -1, found_apple_roman = -1, found_unicode = -1;
+        bool is_english = false;
+        for (size_t n = 0; n < count; n++)
+        {
+            const size_t record = name_table.offset + 6 + 12 * n;
+            const unsigned int platform_id = font.U16(record);
+            const unsigned int encoding_id = font.U16(record + 2);
+            const unsigned int language_id = font.U16(record + 4);
+            if (font.U16(record + 6) != name_id || font.U16(record + 8) == 0)
+            {
+                continue;
+            }
+
+            switch (platform_id)
+            {
+            case TT_PLATFORM_APPLE_UNICODE:
+            case TT_PLATFORM_ISO:
+                found_unicode = n;
+                break;
+            case TT_PLATFORM_MACINTOSH:
+                if (language_id == TT_MAC_LANGID_ENGLISH)
+                {
+                    found_apple = n;
+                }
+                else if (encoding_id == TT_MAC_ID_ROMAN)
+                {
+                    found_apple_roman = n;
+                }
+                break;
+            case TT_PLATFORM_MICROSOFT:
+                if (found_win == -1 || (language_id & 0x3FF) == 0x009)
+                {
+                    if (encoding_id == TT_MS_ID_SYMBOL_CS || encoding_id == TT_MS_ID_UNICODE_CS ||
+                        encoding_id == TT_MS_ID_UCS_4)
+                    {
+                        is_english = (language_id & 0x3FF) == 0x009;
+                        found_win = n;
+                    }
+                }
+                break;
+            }
+        }
+
+        long found = -1;
+        bool utf16 = false;
+        if (found_win >= 0 && !(found_apple >= 0 && !is_english))
+        {
+            found = found_win;
+            utf16 = true;
+        }
+        else if (found_apple >= 0)
+        {
+            found = found_apple;
+        }
+        else if (found_apple_roman >= 0)
+        {
+            found = found_apple_roman;
+        }
+        else if (found_unicode >= 0)
+        {
+            found = found_unicode;
+            utf16 = true;
+        }
+        if (found < 0)
+        {
+            return false;
+        }
+
+        const size_t record = name_table.offset + 6 + 12 * found;
+        const size_t length = font.U16(record + 8);
+        const size_t offset = strings + font.U16(record + 10);
+        if (!font.Has(offset, length))
+        {
+            return false;
+        }
+        name = DecodeName(font.bytes + offset, length, utf16);
+        return !name.empty();
+    }
+
+    bool ScanSfnt(const Reader &font, size_t sfnt_offset, FaceScanInfo &face)
+    {
+        Table name_table, os2, head;
+        if (!FindTable(font, sfnt_offset, "name", name_table))
+        {
+            return false;
+        }
+
+        // FreeType prefers the WWS names, or the typographic names in fonts
+        // that are already WWS conformant
+        const bool has_os2 = FindTable(font, sfnt_offset, "OS/2", os2) && os2.length >= 64;
+        const unsigned int fs_selection = has_os2 ? font.U16(os2.offset + 62) : 0;
+        bool found_family, found_style;
+        if (fs_selection & 256)
+        {
+            found_family = GetName(font, name_table, TT_NAME_ID_TYPOGRAPHIC_FAMILY, face.family_name) ||
+                           GetName(font, name_table, TT_NAME_ID_FONT_FAMILY, face.family_name);
+            found_style = GetName(font, name_table, TT_NAME_ID_TYPOGRAPHIC_SUBFAMILY, face.style_name) ||
+                          GetName(font, name_table, TT_NAME_ID_FONT_SUBFAMILY, face.style_name);
+        }
+        else
+        {
+            found_family = GetName(font, name_table, TT_NAME_ID_WWS_FAMILY, face.family_name) ||
+                           GetName(font, name_table, TT_NAME_ID_TYPOGRAPHIC_FAMILY, face.family_name) ||
+                           GetName(font, name_table, TT_NAME_ID_FONT_FAMILY, face.family_name);
+            found_style = GetName(font, name_table, TT_NAME_ID_WWS_SUBFAMILY, face.style_name) ||
+                          GetName(font, name_table, TT_NAME_ID_TYPOGRAPHIC_SUBFAMILY, face.style_name) ||
+                          GetName(font, name_table, TT_NAME_ID_FONT_SUBFAMILY, face.style_name);
+        }
+        if (!found_family || !found_style)
+        {
+            return false;
+        }
+
+        face.style_flags = 0;
+        if (has_os2)
+        {
+            if (fs_selection & (512 | 1))
+            {
+                face.style_flags |= FT_STYLE_FLAG_ITALIC;
+            }
+            if (fs_selection & 32)
+            {
+                face.style_flags |= FT_STYLE_FLAG_BOLD;
+            }
+        }
+        else if (FindTable(font, sfnt_offset, "head", head) && head.length >= 46)
+        {
+            const unsigned int mac_style = font.U16(head.offset + 44);
+            if (mac_style & 1)
+            {
+                face.style_flags |= FT_STYLE_FLAG_BOLD;
+            }
+            if (mac_style & 2)
+            {
+                face.style_flags |= FT_STYLE_FLAG_ITALIC;
+            }
+        }
+        return true;
+    }
+}
+
+bool ScanSfntFaces(const unsigned char *bytes, size_t size, std::vector<FaceScanInfo> &faces)
+{
+    const Reader font = {bytes, size};
+    if (!font.Has(0, 12))
+    {
+        return false;
+    }
+
+    std::vector<size_t> offsets;
+    const unsigned long tag = font.U32(0);
+    if (tag == 0x74746366) // ttcf
+    {
+        const unsigned long num_fonts = font.U32(8);
+        if (num_fonts == 0 || !font.Has(12, 4 * (size_t)num_fonts))
+        {
+            return false;
+        }
+        for (unsigned long i = 0; i < num_fonts; i++)
+        {
+            offsets.push_back(font.U32(12 + 4 * i));
+        }
+    }
+    else if (tag == 0x00010000 || tag == 0x4F54544F || tag == 0x74727565) // 1.0, OTTO, true
+    {
+        offsets.push_back(0);
+    }
+    else
+    {
+        return false;
+    }
+
+    faces.clear();
+    for (size_t i = 0; i < offsets.size(); i++)
+    {
+        FaceScanInfo face;
+        face.face_index = i;
+        if (!ScanSfnt(font, offsets[i], face))
+        {
+            return false;
+        }
+        faces.push_back(face);
+    }
+    return true;
+}
+
+FT_Error ScanFaces(FT_Library library, const unsigned char *bytes, size_t size,
+                   std::vector<FaceScanInfo> &faces)
+{
+    if (ScanSfntFaces(bytes, size, faces))
+    {
+        return FT_Err_Ok;
+    }
+
+    faces.clear();
+    FT_Long num_faces = 1;
+    for (FT_Long i = 0; i < num_faces; i++)
+    {
+        FT_Face face;
+        FT_Error error = FT_New_Memory_Face(library, bytes, size, i, &face);
+        if (error)
+        {
+            return error;
+        }
+        num_faces = face->num_faces;
+        faces.push_back({i,
+                         face->family_name ? face->family_name : "",
+                         face->style_name ? face->style_name : "",
+                         face->style_flags});
+        FT_Done_Face(face);
+    }
+    return FT_Err_Ok;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include <freetype/freetype.h>
+
+// Face metadata of a font file, read without opening the faces
+struct FaceScanInfo
+{
+    FT_Long face_index;
+    std::string family_name;
+    std::string style_name;
+    FT_Long style_flags;
+};
+
+// Reads the faces of an sfnt font or collection from the table directories
+// and the name, OS/2 and head tables. Names are chosen like FreeType does, so
+// they match the `family_name` and `style_name` of the opened faces. Returns
+// false if the font is not an sfnt or a name is missing.
+bool ScanSfntFaces(const unsigned char *bytes, size_t size, std::vector<FaceScanInfo> &faces);
+
+// Scans the sfnt tables, or opens and closes each face for other formats
+FT_Error ScanFaces(FT_Library library, const unsigned char *bytes, size_t size,
+                   std::vector<FaceScanInfo> &faces);
@@ -1,165 +1,165 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 
+#include <map>
+#include <vector>
+
 #include <freetype/freetype.h>
 
 #include <emscripten/emscripten.h>
 #include <emscripten/val.h>
 #include <emscripten/bind.h>
 
-FT_Face current_face;
+#include "core.h"
+#include "layout.h"
+
+// JS bindings of the core, see core.h. Functions here convert between JS
+// values and the core types, everything else is in core.cpp.
 
-class FontPtr
+// Copies the JS array to the wasm memory in one `set` call
+std::unique_ptr<FontPtr> CopyFont(emscripten::val font)
 {
-public:
-    FontPtr(std::vector<unsigned char> font)
+    const size_t size = font["length"].as<size_t>();
+    auto fns = std::make_unique<FontPtr>(size);
+    if (fns->bytes == nullptr)
     {
-        // Store the font to a wasm memory
-        size = font.size();
-        bytes = (FT_Bytes)::malloc(size);
-        ::memcpy((void *)bytes, font.data(), size);
+        fprintf(stderr, "FreeType: Unable to allocate %zu bytes for the font.\n", size);
+        return nullptr;
     }
+    emscripten::val(emscripten::typed_memory_view(size, (unsigned char *)fns->bytes)).call<void>("set", font);
+    return fns;
+}
 
-    ~FontPtr()
+std::vector<FT_FaceRec> LoadFontFromBytes(emscripten::val font)
+{
+    FT_STATS_TIMER(font_load_ms);
+    auto fns = CopyFont(font);
+    if (fns == nullptr)
     {
-        // printf("free bytes?\n");
-        ::free((void *)bytes);
+        return {};
     }
+    return LoadFaces(StoreFont(std::move(fns)));
+}
 
-    signed long size;
-    FT_Bytes bytes;
-};
+// Allocates a buffer in the wasm memory for a font of `size` bytes and
+// returns its address, 0 if it fails. The font is written to the view of
+// `GetFontBufferView` and loaded with `LoadFontFromBuffer`.
+uintptr_t AllocateFontBuffer(size_t size)
+{
+    return (uintptr_t)AllocatePendingFont(size);
+}
 
-class Font
+// View of a buffer of `AllocateFontBuffer`. It detaches when the memory
+// grows, so it's fetched again after other calls into the module.
+emscripten::val GetFontBufferView(uintptr_t address)
 {
-public:
-    Font(FT_Face ft_face, std::shared_ptr<FontPtr> ptr)
+    const FontPtr *fns = GetPendingFont(address);
+    if (fns == nullptr)
     {
-        face = ft_face;
-        bytes = ptr;
+        return emscripten::val::null();
     }
+    return emscripten::val(emscripten::typed_memory_view(fns->size, fns->bytes));
+}
 
-    ~Font()
+// Loads the font written to a buffer of `AllocateFontBuffer`, the buffer is
+// owned by the module after the call
+std::vector<FT_FaceRec> LoadFontFromBuffer(uintptr_t address)
+{
+    FT_STATS_TIMER(font_load_ms);
+    auto fns = TakePendingFont(address);
+    if (fns == nullptr)
     {
-        // printf("free font?\n");
-        FT_Done_Face(face);
+        return {};
     }
-    FT_Face face;
-    std::shared_ptr<FontPtr> bytes;
-};
-
-// FamilyName -> StyleName -> (FT_Bytes, FT_Face)
-std::map<std::string, std::map<std::string, std::unique_ptr<Font>>>
-    face_map;
+    return LoadFaces(StoreFont(std::move(fns)));
+}
 
-FT_Library GetOrDeleteLibrary(bool deleteLibrary = false)
+// Loads a font or collection without opening its faces
+std::vector<FaceInfo> LoadFontCollection(emscripten::val font)
 {
-    static bool inited = false;
-    static FT_Library library;
-    if (deleteLibrary)
+    FT_STATS_TIMER(font_load_ms);
+    auto fns = CopyFont(font);
+    if (fns == nullptr)
     {
-        if (inited)
-        {
-            FT_Done_FreeType(library);
-            inited = false;
-            library = nullptr;
-        }
+        return {};
     }
-    else
+    return LoadFaceInfos(StoreFont(std::move(fns)));
+}
+
+std::vector<FaceInfo> LoadFontCollectionFromBuffer(uintptr_t address)
+{
+    FT_STATS_TIMER(font_load_ms);
+    auto fns = TakePendingFont(address);
+    if (fns == nullptr)
     {
-        if (!inited)
-        {
-            FT_Init_FreeType(&library);
-            inited = true;
-        }
+        return {};
     }
-    return library;
+    return LoadFaceInfos(StoreFont(std::move(fns)));
 }
 
-void Cleanup()
+// Frees a buffer of `AllocateFontBuffer` that was not loaded
+void FreeFontBuffer(uintptr_t address)
 {
-    face_map.clear();
-    GetOrDeleteLibrary(true);
+    TakePendingFont(address);
 }
 
-std::vector<FT_FaceRec> LoadFontFromBytes(std::vector<unsigned char> font)
+emscripten::val GetFaceMemoryStats(int face_handle)
 {
-    FT_Library library = GetOrDeleteLibrary();
-    FT_Error error;
-    std::vector<FT_FaceRec> rtn;
-    FT_Face face_temp;
-
-    // Store the font to a wasm memory
-    auto fns = std::make_shared<FontPtr>(font);
-
-    // Get num of faces
-    error = FT_New_Memory_Face(library, fns->bytes, fns->size, -1, &face_temp);
-    if (error)
+    MemoryStats stats;
+    if (!ReadFaceMemoryStats(face_handle, stats))
     {
-        fprintf(stderr, "FreeType: FT_New_Memory_Face (face index -1) failed.\n");
-        return rtn;
+        return emscripten::val::null();
     }
-    int num_faces = face_temp->num_faces;
-    FT_Done_Face(face_temp);
+    return emscripten::val(stats);
+}
 
-    // Iterate faces stored in the font
-    for (int i = 0; i < num_faces; i++)
+emscripten::val GetFaceCoverage(int face_handle)
+{
+    CoverageInfo info;
+    if (!ReadFaceCoverage(face_handle, info))
     {
-
-        FT_Face ft_face;
-        error = FT_New_Memory_Face(library, fns->bytes, fns->size, i, &ft_face);
-        if (error)
-        {
-            fprintf(stderr, "FreeType: FT_New_Memory_Face (face index %d) failed.\n", i);
-            return rtn;
-        }
-
-        face_map[ft_face->family_name][ft_face->style_name] = std::make_unique<Font>(ft_face, fns);
-        rtn.push_back(*ft_face);
+        return emscripten::val::null();
     }
-
-    return rtn;
+    return emscripten::val(info);
 }
 
-void UnloadFont(std::string familyName)
+emscripten::val GetVariationInfo(int face_handle)
 {
-    // Unset current face if it matches
-    if (current_face != NULL && current_face->family_name == familyName)
+    VariationInfo info;
+    if (!ReadVariationInfo(face_handle, info))
     {
-        current_face = NULL;
+        return emscripten::val::null();
     }
-
-    // Unload faces
-    face_map.erase(familyName);
+    return emscripten::val(info);
 }
 
-emscripten::val SetFont(std::string faceName, std::string styleName)
+emscripten::val GetFontSourceInfo(int face_handle)
 {
-    auto ptr = face_map[faceName][styleName].get();
-    if (ptr == nullptr)
+    FontSourceInfo info;
+    if (!ReadFontSourceInfo(face_handle, info))
     {
         return emscripten::val::null();
     }
-    current_face = face_map[faceName][styleName]->face;
-    return emscripten::val(*current_face);
+    return emscripten::val(info);
 }
 
-emscripten::val SetCharSize(FT_F26Dot6 char_width, FT_F26Dot6 char_height, FT_UInt horz_resolution, FT_UInt vert_resolution)
+emscripten::val SetFont(std::string faceName, std::string styleName)
 {
-
-    if (current_face == NULL)
+    FT_Face face = SelectFont(faceName, styleName);
+    if (face == nullptr)
     {
-        fprintf(stderr, "FreeType: Unable to set size, font is not set. Use `SetFont` first.");
         return emscripten::val::null();
     }
+    return emscripten::val(*face);
+}
 
-    FT_Error error = FT_Set_Char_Size(current_face, char_width, char_height, horz_resolution, vert_resolution);
-    if (error)
+emscripten::val SetCharSize(FT_F26Dot6 char_width, FT_F26Dot6 char_height, FT_UInt horz_resolution, FT_UInt vert_resolution)
+{
+    if (SetCurrentSize(std::make_tuple(1, char_width, char_height, horz_resolution, vert_resolution)))
     {
-        fprintf(stderr, "FreeType: Error setting size.\n");
         return emscripten::val::null();
     }
-
     return emscripten::val(current_face->size->metrics);
 }
 
@@ -167,65 +167,29 @@ emscripten::val SetPixelSize(
     FT_UInt pixel_width,
     FT_UInt pixel_height)
 {
-
-    if (current_face == NULL)
-    {
-        fprintf(stderr, "FreeType: Unable to set size, font is not set. Use `SetFont` first.");
-        return emscripten::val::null();
-    }
-
-    FT_Error error = FT_Set_Pixel_Sizes(current_face, pixel_width, pixel_height);
-    if (error)
+    if (SetCurrentSize(std::make_tuple(0, (FT_F26Dot6)pixel_width, (FT_F26Dot6)pixel_height, 0u, 0u)))
     {
-        fprintf(stderr, "FreeType: Error setting size.\n");
         return emscripten::val::null();
     }
-
     return emscripten::val(current_face->size->metrics);
 }
 
 emscripten::val SetCharmap(unsigned int encoding)
 {
-    if (current_face == NULL)
-    {
-        fprintf(stderr, "FreeType: Current font is not set. Unable to set charmap.");
-        return emscripten::val::null();
-    }
-
-    FT_Error error = FT_Select_Charmap(current_face, (FT_Encoding)encoding);
-    if (error)
+    if (SelectCurrentCharmap((FT_Encoding)encoding))
     {
-        fprintf(stderr, "FreeType: Error selecting charmap.\n");
         return emscripten::val::null();
     }
-
     return emscripten::val(*current_face->charmap);
 }
 
 emscripten::val SetCharmapByIndex(int index)
 {
-    if (current_face == NULL)
+    if (SetCurrentCharmapByIndex(index))
     {
-        fprintf(stderr, "FreeType: Current font is not set. Unable to set charmap.\n");
         return emscripten::val::null();
     }
-
-    for (int k = 0; k < current_face->num_charmaps; k++)
-    {
-        if (k == index)
-        {
-            FT_Error error = FT_Set_Charmap(current_face, current_face->charmaps[k]);
-            if (error)
-            {
-                fprintf(stderr, "FreeType: Error setting charmap.\n");
-                return emscripten::val::null();
-            }
-            return emscripten::val(*current_face->charmap);
-        }
-    }
-
-    fprintf(stderr, "Charmap not found with index '%d'.\n", index);
-    return emscripten::val::null();
+    return emscripten::val(*current_face->charmap);
 }
 
 // TODO: Is transform any good? In docs it says:
@@ -243,8 +207,6 @@ emscripten::val SetCharmapByIndex(int index)
 //     FT_Set_Transform(current_face, NULL, &pen);
 // }
 
-// https://freetype.org/freetype2/docs/reference/ft2-base_interface.html#ft_load_xxx
-
 emscripten::val LoadGlyphsFromCharmap(FT_ULong first_charcode, FT_ULong last_charcode, FT_Int32 load_flags, int use_sdf)
 {
     emscripten::val mappe = emscripten::val::global("Map").new_();
@@ -255,47 +217,85 @@ emscripten::val LoadGlyphsFromCharmap(FT_ULong first_charcode, FT_ULong last_cha
         return mappe;
     }
 
-    FT_UInt gindex;
-    FT_ULong charcode;
+    ForEachCharmapGlyph(current_face, first_charcode, last_charcode, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                        { mappe.call<void>("set", emscripten::val(charcode), emscripten::val(*slot)); });
+    return mappe;
+}
+
+// Result of a sliced load, `glyphs` is a Map of the loaded glyphs. Loading
+// continues from `next_charcode` unless `done`.
+template <typename F>
+emscripten::val LoadCharmapSlice(FT_ULong first_charcode, FT_ULong last_charcode, FT_Int32 load_flags, int use_sdf,
+                                 unsigned int max_glyphs, double time_budget_ms, F to_val)
+{
+    emscripten::val result = emscripten::val::object();
+    emscripten::val mappe = emscripten::val::global("Map").new_();
+    result.set("glyphs", mappe);
 
-    if (first_charcode != 0)
+    if (current_face == NULL)
     {
-        charcode = FT_Get_Next_Char(current_face, first_charcode - 1, &gindex);
+        fprintf(stderr, "FreeType: Current font is not set.\n");
+        result.set("next_charcode", 0);
+        result.set("done", true);
+        return result;
     }
-    else
+
+    FT_ULong next_charcode = 0;
+    const bool done = ForEachCharmapGlyphSliced(current_face, first_charcode, last_charcode, load_flags, use_sdf, max_glyphs, time_budget_ms, next_charcode,
+                                                [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                                                { mappe.call<void>("set", emscripten::val(charcode), to_val(slot)); });
+    result.set("next_charcode", next_charcode);
+    result.set("done", done);
+    return result;
+}
+
+emscripten::val LoadGlyphsFromCharmapSliced(FT_ULong first_charcode, FT_ULong last_charcode, FT_Int32 load_flags, int use_sdf,
+                                            unsigned int max_glyphs, double time_budget_ms)
+{
+    return LoadCharmapSlice(first_charcode, last_charcode, load_flags, use_sdf, max_glyphs, time_budget_ms,
+                            [](const FT_GlyphSlotRec *slot)
+                            { return emscripten::val(*slot); });
+}
+
+emscripten::val LoadGlyphs(std::vector<FT_ULong> charcodes, FT_Int32 load_flags, int use_sdf)
+{
+    emscripten::val mappe = emscripten::val::global("Map").new_();
+
+    if (current_face == NULL)
     {
-        charcode = FT_Get_First_Char(current_face, &gindex);
+        fprintf(stderr, "FreeType: Current font is not set.\n");
+        return mappe;
     }
 
+    ForEachGlyph(current_face, charcodes, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                 { mappe.call<void>("set", emscripten::val(charcode), emscripten::val(*slot)); });
+    return mappe;
+}
 
-    if (use_sdf > 0) {
-        load_flags |= FT_LOAD_TARGET_(FT_RENDER_MODE_SDF);
-    }
+// Zero-copy glyph loading
+//
+// `LoadGlyphViews` and `LoadGlyphViewsFromCharmap` don't convert bitmaps to
+// RGBA ImageData, instead the coverage bytes are appended to the glyph buffer
+// owned by the module, and each glyph gets an offset and length into it. The
+// buffer is read from JS with `GetGlyphBuffer` and cleared by
+// `ClearGlyphBuffer`, RGBA conversion is done only with `GetGlyphImageData`.
 
-    while (gindex != 0)
+emscripten::val LoadGlyphViewsFromCharmap(FT_ULong first_charcode, FT_ULong last_charcode, FT_Int32 load_flags, int use_sdf)
+{
+    emscripten::val mappe = emscripten::val::global("Map").new_();
+
+    if (current_face == NULL)
     {
-        FT_Error error = FT_Load_Char(current_face, charcode, load_flags);
-        if (error)
-        {
-            fprintf(stderr, "Can't load char '%lu'\n", charcode);
-            charcode = FT_Get_Next_Char(current_face, charcode, &gindex);
-            if (charcode > last_charcode)
-            {
-                break;
-            }
-            continue;
-        }
-        mappe.call<void>("set", emscripten::val(charcode), emscripten::val(*current_face->glyph));
-        charcode = FT_Get_Next_Char(current_face, charcode, &gindex);
-        if (charcode > last_charcode)
-        {
-            break;
-        }
+        fprintf(stderr, "FreeType: Current font is not set.\n");
+        return mappe;
     }
+
+    ForEachCharmapGlyph(current_face, first_charcode, last_charcode, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                        { mappe.call<void>("set", emscripten::val(charcode), emscripten::val(MakeGlyphView(slot))); });
     return mappe;
 }
 
-emscripten::val LoadGlyphs(std::vector<FT_ULong> charcodes, FT_Int32 load_flags, int use_sdf)
+emscripten::val LoadGlyphViews(std::vector<FT_ULong> charcodes, FT_Int32 load_flags, int use_sdf)
 {
     emscripten::val mappe = emscripten::val::global("Map").new_();
 
@@ -305,41 +305,510 @@ emscripten::val LoadGlyphs(std::vector<FT_ULong> charcodes, FT_Int32 load_flags,
         return mappe;
     }
 
-    if (use_sdf) {
-        load_flags |= FT_LOAD_TARGET_(FT_RENDER_MODE_SDF);
+    ForEachGlyph(current_face, charcodes, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                 { mappe.call<void>("set", emscripten::val(charcode), emscripten::val(MakeGlyphView(slot))); });
+    return mappe;
+}
+
+emscripten::val LoadGlyphViewsFromCharmapSliced(FT_ULong first_charcode, FT_ULong last_charcode, FT_Int32 load_flags, int use_sdf,
+                                                unsigned int max_glyphs, double time_budget_ms)
+{
+    return LoadCharmapSlice(first_charcode, last_charcode, load_flags, use_sdf, max_glyphs, time_budget_ms,
+                            [](const FT_GlyphSlotRec *slot)
+                            { return emscripten::val(MakeGlyphView(slot)); });
+}
+
+// The view is invalidated when the buffer grows or wasm memory grows, so get
+// a new one after every load call
+emscripten::val GetGlyphBuffer()
+{
+    return emscripten::val(emscripten::typed_memory_view(glyph_buffer.size(), glyph_buffer.data()));
+}
+
+// Glyph metrics columns
+//
+// `LoadGlyphMetrics` writes the metrics of each loaded glyph to int columns
+// instead of creating objects. Lengths are in 26.6 pixels, bitmap values in
+// pixels, and bitmaps are appended to the glyph buffer like glyph views.
+
+// Copies a JS array of charcodes, glyph indices or handles in one `set` call
+// straight into a vector of the element type the caller needs. All of them
+// are 32-bit in wasm32.
+template <typename T>
+std::vector<T> CopyUint32Array(emscripten::val array)
+{
+    static_assert(sizeof(T) == sizeof(uint32_t), "elements must be 32-bit");
+    std::vector<T> values(array["length"].as<size_t>());
+    emscripten::val(emscripten::typed_memory_view(values.size(), (uint32_t *)values.data())).call<void>("set", array);
+    return values;
+}
+
+int LoadGlyphMetrics(emscripten::val charcodes, FT_Int32 load_flags, int use_sdf)
+{
+    glyph_metrics_count = 0;
+    if (current_face == NULL)
+    {
+        fprintf(stderr, "FreeType: Current font is not set.\n");
+        return 0;
     }
+    return FillGlyphMetrics(current_face, CopyUint32Array<FT_ULong>(charcodes), load_flags, use_sdf);
+}
 
-    for (auto &c : charcodes)
+// View to a column of the last `LoadGlyphMetrics` call, valid until the next
+// call
+emscripten::val GetGlyphMetricsColumn(int column)
+{
+    if (column < 0 || column >= GLYPH_METRICS_COLUMNS)
     {
-        FT_Error error = FT_Load_Char(current_face, c, load_flags);
-        if (error)
-        {
-            fprintf(stderr, "Can't load char '%lu'\n", c);
-            continue;
-        }
+        fprintf(stderr, "FreeType: Glyph metrics column '%d' not found.\n", column);
+        return emscripten::val::null();
+    }
+    return emscripten::val(emscripten::typed_memory_view(glyph_metrics_count, glyph_metrics.data() + column * glyph_metrics_count));
+}
 
-        mappe.call<void>("set", emscripten::val(c), emscripten::val(*current_face->glyph));
+// Kerning pairs of the glyphs with the current font and size, see
+// `FillKerningPairs`. The view is valid until the next call.
+emscripten::val GetKerningPairs(emscripten::val glyph_indices, FT_UInt kern_mode)
+{
+    if (current_face == NULL)
+    {
+        fprintf(stderr, "FreeType: Current font is not set.\n");
+        return emscripten::val::null();
     }
+    FillKerningPairs(current_face, CopyUint32Array<FT_UInt>(glyph_indices), kern_mode);
+    return emscripten::val(emscripten::typed_memory_view(kerning_pairs.size(), kerning_pairs.data()));
+}
 
-    return mappe;
+emscripten::val GetKerningPairsWithSize(int size_handle, emscripten::val glyph_indices, FT_UInt kern_mode)
+{
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return emscripten::val::null();
+    }
+    ScopedSize scoped_size(handle->size);
+    FillKerningPairs(handle->font->face, CopyUint32Array<FT_UInt>(glyph_indices), kern_mode);
+    return emscripten::val(emscripten::typed_memory_view(kerning_pairs.size(), kerning_pairs.data()));
 }
 
-FT_Vector GetKerning(FT_UInt left_glyph_index, FT_UInt right_glyph_index, FT_UInt kern_mode)
+// Outlines of the glyphs with the current font and size, see outline.h.
+// Returns the number of glyphs, read them with `GetOutlineGlyphs`.
+int LoadOutlines(emscripten::val glyph_indices, FT_Int32 load_flags)
 {
-    FT_Vector vector;
     if (current_face == NULL)
     {
         fprintf(stderr, "FreeType: Current font is not set.\n");
-        return vector;
+        return 0;
     }
+    return FillOutlines(current_face, CopyUint32Array<FT_UInt>(glyph_indices), load_flags);
+}
 
-    FT_Error error = FT_Get_Kerning(current_face, left_glyph_index, right_glyph_index, kern_mode, &vector);
-    if (error)
+int LoadOutlinesWithSize(int size_handle, emscripten::val glyph_indices, FT_Int32 load_flags)
+{
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
     {
-        fprintf(stderr, "Unable to read kerning.\n");
-        return vector;
+        return 0;
     }
-    return vector;
+    ScopedSize scoped_size(handle->size);
+    MemoryTagScope memory_tag(FaceMemoryTag(handle->font->face));
+    return FillOutlines(handle->font->face, CopyUint32Array<FT_UInt>(glyph_indices), load_flags);
+}
+
+// Views of the last `LoadOutlines` call, valid until the next call
+emscripten::val GetOutlineGlyphs()
+{
+    return emscripten::val(emscripten::typed_memory_view(outline_glyphs.size(), outline_glyphs.data()));
+}
+
+emscripten::val GetOutlineCommands()
+{
+    return emscripten::val(emscripten::typed_memory_view(outline_commands.size(), outline_commands.data()));
+}
+
+emscripten::val GetOutlinePoints()
+{
+    return emscripten::val(emscripten::typed_memory_view(outline_points.size(), outline_points.data()));
+}
+
+// Signed distance fields of the charcodes at the canonical pixel size, see
+// sdf.h. Read the rows with `GetSdfGlyphs`.
+SdfBatchInfo RenderSdf(int face_handle, emscripten::val charcodes, FT_UInt pixel_size, int spread, int renderer, FT_Int32 load_flags)
+{
+    return RenderSdfBatchWithFace(face_handle, CopyUint32Array<FT_ULong>(charcodes), pixel_size, spread, renderer, load_flags);
+}
+
+// Views of the last `RenderSdf` call, valid until the next call
+emscripten::val GetSdfGlyphs()
+{
+    return emscripten::val(emscripten::typed_memory_view(sdf_glyphs.size(), sdf_glyphs.data()));
+}
+
+emscripten::val GetSdfPixels()
+{
+    return emscripten::val(emscripten::typed_memory_view(sdf_pixels.size(), sdf_pixels.data()));
+}
+
+// Shapes the text with the size handle, see shaper.h. Clusters are offsets in
+// the JS string. Returns the number of glyphs, or -1.
+int ShapeText(int size_handle, std::u16string text, std::string features)
+{
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return -1;
+    }
+    ScopedSize scoped_size(handle->size);
+    MemoryTagScope memory_tag(FaceMemoryTag(handle->font->face));
+    return ShapeRun(handle->font->face, text, features);
+}
+
+// Rows of the last `ShapeText` call, SHAPED_GLYPH_SIZE ints per glyph. The
+// view is valid until the next call.
+emscripten::val GetShapedGlyphs()
+{
+    return emscripten::val(emscripten::typed_memory_view(shaped_glyphs->size(), shaped_glyphs->data()));
+}
+
+// Text layout, see layout.h. Clusters are offsets in the JS string.
+
+// Rows of the last `LayoutText` call, TEXT_GLYPH_SIZE ints per glyph. The view
+// is valid until the next call.
+emscripten::val GetLayoutGlyphs()
+{
+    return emscripten::val(emscripten::typed_memory_view(layout_glyphs.size(), layout_glyphs.data()));
+}
+
+// Line rows of the last `LayoutText` call, TEXT_LINE_SIZE ints per line
+emscripten::val GetLayoutLines()
+{
+    return emscripten::val(emscripten::typed_memory_view(layout_lines.size(), layout_lines.data()));
+}
+
+// Lays out and renders the text into one `width` x `height` buffer, see
+// layout.h. The view is valid until the next call, null on error.
+emscripten::val RenderTextWithSize(int size_handle, std::u16string text, unsigned int width, unsigned int height, int flags,
+                                   int format, unsigned int color)
+{
+    if (!RenderTextUtf16(size_handle, text, width, height, flags, format, color))
+    {
+        return emscripten::val::null();
+    }
+    return emscripten::val(emscripten::typed_memory_view(text_pixels.size(), text_pixels.data()));
+}
+
+// Resolves the characters of the text to the first face that covers them,
+// see layout.h. Returns the number of rows, or -1.
+int ResolveFallback(emscripten::val face_handles, std::u16string text)
+{
+    return ResolveFallbackUtf16(CopyUint32Array<int>(face_handles), text);
+}
+
+// Rows of the last `ResolveFallback` call, FALLBACK_GLYPH_SIZE ints per code
+// point. The view is valid until the next call.
+emscripten::val GetFallbackGlyphs()
+{
+    return emscripten::val(emscripten::typed_memory_view(fallback_glyphs.size(), fallback_glyphs.data()));
+}
+
+// Glyph atlas
+//
+// Glyphs are rendered straight into shared 8-bit (or SDF) atlas pages, with a
+// metrics table of UV rects, bearings and advances. Glyphs can be added at any
+// time without repacking, and the dirty rectangles tell which parts of the
+// pages need to be uploaded again.
+
+// Adds glyphs to the atlas, returns the entry index of each charcode, or -1
+// if the glyph is missing or doesn't fit. The view is valid until the next
+// call.
+emscripten::val AtlasAddGlyphs(int atlas_id, std::vector<FT_ULong> charcodes)
+{
+    const std::vector<int> *added = AddAtlasGlyphs(atlas_id, charcodes);
+    if (added == nullptr)
+    {
+        return emscripten::val::null();
+    }
+    return emscripten::val(emscripten::typed_memory_view(added->size(), added->data()));
+}
+
+// Metrics table with ATLAS_ENTRY_SIZE floats per entry, see atlas.h
+emscripten::val AtlasGetEntries(int atlas_id)
+{
+    FontAtlas *state = GetAtlas(atlas_id);
+    if (state == nullptr)
+    {
+        return emscripten::val::null();
+    }
+    auto &entries = state->atlas.entries;
+    return emscripten::val(emscripten::typed_memory_view(entries.size(), entries.data()));
+}
+
+emscripten::val AtlasGetPage(int atlas_id, int page)
+{
+    FontAtlas *state = GetAtlas(atlas_id);
+    if (state == nullptr || page < 0 || page >= (int)state->atlas.pages.size())
+    {
+        return emscripten::val::null();
+    }
+    auto &pixels = state->atlas.pages[page];
+    return emscripten::val(emscripten::typed_memory_view(pixels.size(), pixels.data()));
+}
+
+// Dirty rectangles as [page, x, y, width, height, ...]
+emscripten::val AtlasGetDirtyRects(int atlas_id)
+{
+    FontAtlas *state = GetAtlas(atlas_id);
+    if (state == nullptr)
+    {
+        return emscripten::val::null();
+    }
+    auto rects = state->atlas.DirtyRects();
+    return emscripten::val::global("Int32Array").new_(emscripten::val(emscripten::typed_memory_view(rects.size(), rects.data())));
+}
+
+// Glyph cache snapshots, see glyph_snapshot.h
+
+// Bytes of the last `ExportGlyphSnapshot` call
+std::vector<unsigned char> exported_snapshot;
+
+// Snapshot of the glyph cache, the view is valid until the next call
+emscripten::val ExportGlyphSnapshotView()
+{
+    ExportGlyphSnapshot(exported_snapshot);
+    return emscripten::val(emscripten::typed_memory_view(exported_snapshot.size(), exported_snapshot.data()));
+}
+
+// Copies the snapshot to the wasm memory in one `set` call, returns the
+// number of entries or -1
+int ImportGlyphSnapshotBytes(emscripten::val snapshot)
+{
+    std::vector<unsigned char> bytes(snapshot["length"].as<size_t>());
+    emscripten::val(emscripten::typed_memory_view(bytes.size(), bytes.data())).call<void>("set", snapshot);
+    return ImportGlyphSnapshot(std::move(bytes));
+}
+
+// Snapshot buffers of `AllocateGlyphSnapshotBuffer`, address -> bytes
+std::map<uintptr_t, std::vector<unsigned char>> pending_snapshots;
+
+// Allocates a buffer in the wasm memory for a snapshot of `size` bytes and
+// returns its address, 0 if it's too small. The snapshot is written to the
+// view of `GetGlyphSnapshotBufferView` and imported in place with
+// `ImportGlyphSnapshotFromBuffer`.
+uintptr_t AllocateGlyphSnapshotBuffer(size_t size)
+{
+    if (size < sizeof(GlyphSnapshotHeader))
+    {
+        fprintf(stderr, "FreeType: Glyph snapshot of %zu bytes is too small.\n", size);
+        return 0;
+    }
+    std::vector<unsigned char> bytes(size);
+    const uintptr_t address = (uintptr_t)bytes.data();
+    pending_snapshots[address] = std::move(bytes);
+    return address;
+}
+
+// View of a buffer of `AllocateGlyphSnapshotBuffer`. It detaches when the
+// memory grows, so it's fetched again after other calls into the module.
+emscripten::val GetGlyphSnapshotBufferView(uintptr_t address)
+{
+    auto it = pending_snapshots.find(address);
+    if (it == pending_snapshots.end())
+    {
+        fprintf(stderr, "FreeType: Buffer was not allocated with `AllocateGlyphSnapshotBuffer`.\n");
+        return emscripten::val::null();
+    }
+    return emscripten::val(emscripten::typed_memory_view(it->second.size(), it->second.data()));
+}
+
+// Imports the snapshot written to a buffer of `AllocateGlyphSnapshotBuffer`
+// without copying it, the buffer is owned by the module after the call.
+// Returns the number of entries or -1.
+int ImportGlyphSnapshotFromBuffer(uintptr_t address)
+{
+    auto it = pending_snapshots.find(address);
+    if (it == pending_snapshots.end())
+    {
+        fprintf(stderr, "FreeType: Buffer was not allocated with `AllocateGlyphSnapshotBuffer`.\n");
+        return -1;
+    }
+    std::vector<unsigned char> bytes = std::move(it->second);
+    pending_snapshots.erase(it);
+    return ImportGlyphSnapshot(std::move(bytes));
+}
+
+// Frees a buffer of `AllocateGlyphSnapshotBuffer` that was not imported
+void FreeGlyphSnapshotBuffer(uintptr_t address)
+{
+    pending_snapshots.erase(address);
+}
+
+// Entries of the imported snapshot, GLYPH_SNAPSHOT_ENTRY_SIZE ints each
+emscripten::val GetGlyphSnapshotEntries()
+{
+    const int32_t *entries = (const int32_t *)glyph_snapshot.Entries();
+    return emscripten::val(emscripten::typed_memory_view(glyph_snapshot.EntryCount() * GLYPH_SNAPSHOT_ENTRY_SIZE, entries));
+}
+
+// Pixels of the imported snapshot, entries have offsets into it
+emscripten::val GetGlyphSnapshotPixels()
+{
+    return emscripten::val(emscripten::typed_memory_view(glyph_snapshot.PixelsSize(), glyph_snapshot.Pixels()));
+}
+
+emscripten::val GetSizeMetrics(int size_handle)
+{
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return emscripten::val::null();
+    }
+    return emscripten::val(handle->size->metrics);
+}
+
+emscripten::val SetFaceCharmap(int face_handle, unsigned int encoding)
+{
+    FT_CharMap charmap = SelectFaceCharmap(face_handle, (FT_Encoding)encoding);
+    if (charmap == nullptr)
+    {
+        return emscripten::val::null();
+    }
+    return emscripten::val(*charmap);
+}
+
+emscripten::val LoadGlyphsWithSize(int size_handle, std::vector<FT_ULong> charcodes, FT_Int32 load_flags, int use_sdf)
+{
+    emscripten::val mappe = emscripten::val::global("Map").new_();
+
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return mappe;
+    }
+
+    ScopedSize scoped_size(handle->size);
+    ForEachGlyph(handle->font->face, charcodes, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                 { mappe.call<void>("set", emscripten::val(charcode), emscripten::val(*slot)); });
+    return mappe;
+}
+
+emscripten::val LoadGlyphsFromCharmapWithSize(int size_handle, FT_ULong first_charcode, FT_ULong last_charcode, FT_Int32 load_flags, int use_sdf)
+{
+    emscripten::val mappe = emscripten::val::global("Map").new_();
+
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return mappe;
+    }
+
+    ScopedSize scoped_size(handle->size);
+    ForEachCharmapGlyph(handle->font->face, first_charcode, last_charcode, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                        { mappe.call<void>("set", emscripten::val(charcode), emscripten::val(*slot)); });
+    return mappe;
+}
+
+emscripten::val LoadGlyphViewsWithSize(int size_handle, std::vector<FT_ULong> charcodes, FT_Int32 load_flags, int use_sdf)
+{
+    emscripten::val mappe = emscripten::val::global("Map").new_();
+
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return mappe;
+    }
+
+    ScopedSize scoped_size(handle->size);
+    ForEachGlyph(handle->font->face, charcodes, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                 { mappe.call<void>("set", emscripten::val(charcode), emscripten::val(MakeGlyphView(slot))); });
+    return mappe;
+}
+
+// Glyph views of the charcodes at each of the `bins` subpixel x offsets, the
+// view of bin `i` is moved right by i / bins pixels
+emscripten::val LoadSubpixelGlyphViewsWithSize(int size_handle, std::vector<FT_ULong> charcodes, int bins, FT_Int32 load_flags)
+{
+    if (bins < 1 || bins > MAX_SUBPIXEL_BINS)
+    {
+        fprintf(stderr, "FreeType: Subpixel bins must be between 1 and %d.\n", MAX_SUBPIXEL_BINS);
+        return emscripten::val::null();
+    }
+    emscripten::val mappe = emscripten::val::global("Map").new_();
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return mappe;
+    }
+
+    ScopedSize scoped_size(handle->size);
+    FT_Face face = handle->font->face;
+    for (FT_ULong charcode : charcodes)
+    {
+        const FT_UInt glyph_index = FT_Get_Char_Index(face, charcode);
+        emscripten::val views = emscripten::val::array();
+        for (int bin = 0; bin < bins; bin++)
+        {
+            const FT_GlyphSlotRec *slot = LoadCachedGlyph(face, glyph_index, load_flags, SubpixelOffset(bin, bins));
+            if (slot == NULL)
+            {
+                fprintf(stderr, "Can't load char '%lu'\n", charcode);
+                break;
+            }
+            views.call<void>("push", emscripten::val(MakeGlyphView(slot)));
+        }
+        mappe.call<void>("set", emscripten::val(charcode), views);
+    }
+    return mappe;
+}
+
+int LoadGlyphMetricsWithSize(int size_handle, emscripten::val charcodes, FT_Int32 load_flags, int use_sdf)
+{
+    glyph_metrics_count = 0;
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return 0;
+    }
+
+    ScopedSize scoped_size(handle->size);
+    return FillGlyphMetrics(handle->font->face, CopyUint32Array<FT_ULong>(charcodes), load_flags, use_sdf);
+}
+
+// Parallel loading
+//
+// Glyphs of a size handle are loaded on a worker pool, each worker opens the
+// face over the shared font bytes. Without pthreads the pool has only the
+// calling thread.
+
+emscripten::val LoadGlyphViewsParallel(int size_handle, std::vector<FT_ULong> charcodes, FT_Int32 load_flags, int use_sdf)
+{
+    emscripten::val mappe = emscripten::val::global("Map").new_();
+
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return mappe;
+    }
+
+    ForEachGlyphParallel(handle, charcodes, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                         { mappe.call<void>("set", emscripten::val(charcode), emscripten::val(MakeGlyphView(slot))); });
+    return mappe;
+}
+
+emscripten::val LoadGlyphViewsFromCharmapParallel(int size_handle, FT_ULong first_charcode, FT_ULong last_charcode, FT_Int32 load_flags, int use_sdf)
+{
+    emscripten::val mappe = emscripten::val::global("Map").new_();
+
+    SizeHandle *handle = GetSizeHandle(size_handle);
+    if (handle == nullptr)
+    {
+        return mappe;
+    }
+
+    // Charmap lookups are cheap, only the glyphs are loaded on the workers
+    const std::vector<FT_ULong> charcodes = GetCharmapCharcodes(handle->font->face, first_charcode, last_charcode);
+    ForEachGlyphParallel(handle, charcodes, load_flags, use_sdf, [&](FT_ULong charcode, const FT_GlyphSlotRec *slot)
+                         { mappe.call<void>("set", emscripten::val(charcode), emscripten::val(MakeGlyphView(slot))); });
+    return mappe;
 }
 
 // FT_Get_Char_Index
@@ -351,6 +820,11 @@ emscripten::val GlyphFormat_Getter(const FT_GlyphSlotRec &v)
     return emscripten::val((unsigned int)v.format);
 }
 
+emscripten::val GlyphViewFormat_Getter(const GlyphView &v)
+{
+    return emscripten::val((unsigned int)v.format);
+}
+
 emscripten::val Size_Getter(const FT_FaceRec &v)
 {
     return emscripten::val(*v.size);
@@ -404,58 +878,23 @@ unsigned char* RawData_Getter(const FT_Bitmap &v) {
     return v.buffer;
 }
 
-emscripten::val ImageData_Getter(const FT_Bitmap &v)
+emscripten::val BitmapToImageData(const FT_Bitmap &v)
 {
-    // Convert to RGBA
-
-    const auto width = v.width;
-    const auto height = v.rows;
-    const auto pixels = v.rows * v.width;
-    const auto apitch = abs(v.pitch);
-    const auto bufsize = v.rows * apitch;
+    unsigned int width, height;
 
     // Whitespace characters don't have image data
-    if (bufsize == 0)
+    if (!GetConvertedSize(v, width, height) || width == 0 || height == 0)
     {
         return emscripten::val::null();
     }
 
-    std::vector<unsigned char> rgba(pixels * 4);
-    if (v.pixel_mode == FT_PIXEL_MODE_GRAY && v.num_grays >= 255)
-    {
-        for (size_t i = 0; i < bufsize; i++)
-        {
-            // Set the alpha value at 4th byte
-            rgba[i * 4 + 3] = v.buffer[i];
-        }
-    }
-    else if (v.pixel_mode == FT_PIXEL_MODE_MONO)
-    {
-        auto nthpixel = 0;
-
-        for (auto y = 0; y < height; y++)
-        {
-            for (auto x = 0; x < width; x++)
-            {
-                const auto byteoffset = x / 8;
-                const auto buffervalue = v.buffer[y * apitch + byteoffset];
-                const auto bitoffset = x % 8;
-                const auto bitvalue = (buffervalue >> (7 - bitoffset)) & 1;
-
-                // Set the alpha value at 4th byte
-                rgba[nthpixel++ * 4 + 3] = 255 * bitvalue;
-            }
-        }
-    }
-    else
-    {
-        // TODO: Other pixel modes
-        // https://freetype.org/freetype2/docs/reference/ft2-basic_types.html#ft_pixel_mode
-        // Other pixel modes not supported yet
-        return emscripten::val::null();
-    }
+    std::vector<unsigned char> rgba(GetConvertedBytes(v, BITMAP_FORMAT_RGBA));
+    ConvertBitmap(v, BITMAP_FORMAT_RGBA, 0x000000, rgba.data());
+    FT_STATS_ADD(bitmap_conversions, 1);
+    FT_STATS_ADD(converted_bytes, rgba.size());
 
-    auto data = emscripten::val::global("Uint8ClampedArray").new_(emscripten::val::array(rgba.begin(), rgba.end()));
+    // Copy the whole RGBA buffer at once, instead of element by element
+    auto data = emscripten::val::global("Uint8ClampedArray").new_(emscripten::val(emscripten::typed_memory_view(rgba.size(), rgba.data())));
 
     emscripten::val ImageData = emscripten::val::global("ImageData");
 
@@ -475,6 +914,32 @@ emscripten::val ImageData_Getter(const FT_Bitmap &v)
                           emscripten::val(height));
 }
 
+emscripten::val ImageData_Getter(const FT_Bitmap &v)
+{
+    return BitmapToImageData(v);
+}
+
+emscripten::val GetGlyphImageData(BitmapView view)
+{
+    FT_Bitmap bitmap;
+    if (!GetGlyphViewBitmap(view, bitmap))
+    {
+        return emscripten::val::null();
+    }
+    return BitmapToImageData(bitmap);
+}
+
+// Converts the bitmap of a glyph view to one of BITMAP_FORMAT_*, the view to
+// the converted pixels is valid until the next call
+emscripten::val ConvertGlyphBitmap(BitmapView view, int format, unsigned int color)
+{
+    if (!ConvertViewBitmap(view, format, color))
+    {
+        return emscripten::val::null();
+    }
+    return emscripten::val(emscripten::typed_memory_view(convert_buffer.size(), convert_buffer.data()));
+}
+
 template <typename T>
 void NoOpSetter(T &v, emscripten::val setv) {}
 
@@ -487,17 +952,118 @@ EMSCRIPTEN_BINDINGS(my_module)
     // register_vector<int>("VectorInt");
     // register_map<FT_ULong, FT_GlyphSlotRec>("MapChars");
 
-    function("LoadFontFromBytes", &LoadFontFromBytes);
-    function("UnloadFont", &UnloadFont);
-    function("SetFont", &SetFont);
-    function("SetCharSize", &SetCharSize);
-    function("SetPixelSize", &SetPixelSize);
-    function("SetCharmap", &SetCharmap);
-    function("SetCharmapByIndex", &SetCharmapByIndex);
-    function("LoadGlyphs", &LoadGlyphs);
-    function("LoadGlyphsFromCharmap", &LoadGlyphsFromCharmap);
-    function("GetKerning", &GetKerning);
-    function("Cleanup", &Cleanup);
+    function("LoadFontFromBytes", FT_STATS_API(LoadFontFromBytes));
+    function("AllocateFontBuffer", FT_STATS_API(AllocateFontBuffer));
+    function("GetFontBufferView", FT_STATS_API(GetFontBufferView));
+    function("LoadFontFromBuffer", FT_STATS_API(LoadFontFromBuffer));
+    function("FreeFontBuffer", FT_STATS_API(FreeFontBuffer));
+    function("LoadFontCollection", FT_STATS_API(LoadFontCollection));
+    function("LoadFontCollectionFromBuffer", FT_STATS_API(LoadFontCollectionFromBuffer));
+    function("SetFaceIdleTimeout", FT_STATS_API(SetFaceIdleTimeout));
+    function("EvictIdleFaces", FT_STATS_API(EvictIdleFaces));
+    function("IsFaceOpen", FT_STATS_API(IsFaceOpen));
+    function("GetFontStorageStats", FT_STATS_API(GetFontStorageStats));
+
+    // Not counted as API calls
+    function("GetStats", &GetStats);
+    function("ResetStats", &ResetStats);
+
+    function("GetFontSourceInfo", FT_STATS_API(GetFontSourceInfo));
+    function("GetFaceCoverage", FT_STATS_API(GetFaceCoverage));
+    function("GetMemoryStats", FT_STATS_API(GetMemoryStats));
+    function("GetFaceMemoryStats", FT_STATS_API(GetFaceMemoryStats));
+    function("ResetMemoryPeaks", FT_STATS_API(ResetMemoryPeaks));
+    function("SetMemoryLimit", FT_STATS_API(SetMemoryLimit));
+    function("GetMemoryPoolBytes", FT_STATS_API(GetMemoryPoolBytes));
+    function("UnloadFont", FT_STATS_API(UnloadFont));
+    function("SetFont", FT_STATS_API(SetFont));
+    function("SetCharSize", FT_STATS_API(SetCharSize));
+    function("SetPixelSize", FT_STATS_API(SetPixelSize));
+    function("SetCharmap", FT_STATS_API(SetCharmap));
+    function("SetCharmapByIndex", FT_STATS_API(SetCharmapByIndex));
+    function("LoadGlyphs", FT_STATS_API(LoadGlyphs));
+    function("LoadGlyphsFromCharmap", FT_STATS_API(LoadGlyphsFromCharmap));
+    function("LoadGlyphsFromCharmapSliced", FT_STATS_API(LoadGlyphsFromCharmapSliced));
+    function("LoadGlyphViews", FT_STATS_API(LoadGlyphViews));
+    function("LoadGlyphViewsFromCharmap", FT_STATS_API(LoadGlyphViewsFromCharmap));
+    function("LoadGlyphViewsFromCharmapSliced", FT_STATS_API(LoadGlyphViewsFromCharmapSliced));
+    function("GetGlyphBuffer", FT_STATS_API(GetGlyphBuffer));
+    function("LoadGlyphMetrics", FT_STATS_API(LoadGlyphMetrics));
+    function("LoadGlyphMetricsWithSize", FT_STATS_API(LoadGlyphMetricsWithSize));
+    function("GetGlyphMetricsColumn", FT_STATS_API(GetGlyphMetricsColumn));
+    function("ClearGlyphBuffer", FT_STATS_API(ClearGlyphBuffer));
+    function("MeasureText", FT_STATS_API(MeasureTextUtf16));
+    function("LayoutText", FT_STATS_API(LayoutTextUtf16));
+    function("GetLayoutGlyphs", FT_STATS_API(GetLayoutGlyphs));
+    function("GetLayoutLines", FT_STATS_API(GetLayoutLines));
+    function("RenderText", FT_STATS_API(RenderTextWithSize));
+    function("ResolveFallback", FT_STATS_API(ResolveFallback));
+    function("GetFallbackGlyphs", FT_STATS_API(GetFallbackGlyphs));
+    function("LoadOutlines", FT_STATS_API(LoadOutlines));
+    function("LoadOutlinesWithSize", FT_STATS_API(LoadOutlinesWithSize));
+    function("GetOutlineGlyphs", FT_STATS_API(GetOutlineGlyphs));
+    function("GetOutlineCommands", FT_STATS_API(GetOutlineCommands));
+    function("GetOutlinePoints", FT_STATS_API(GetOutlinePoints));
+    function("SetOutlineCacheBudget", FT_STATS_API(SetOutlineCacheBudget));
+    function("GetOutlineCacheStats", FT_STATS_API(GetOutlineCacheStats));
+    function("ResetOutlineCacheStats", FT_STATS_API(ResetOutlineCacheStats));
+    function("ClearOutlineCache", FT_STATS_API(ClearOutlineCache));
+    function("RenderSdf", FT_STATS_API(RenderSdf));
+    function("GetSdfGlyphs", FT_STATS_API(GetSdfGlyphs));
+    function("GetSdfPixels", FT_STATS_API(GetSdfPixels));
+    function("ShapeText", FT_STATS_API(ShapeText));
+    function("GetShapedGlyphs", FT_STATS_API(GetShapedGlyphs));
+    function("SetShapeCacheBudget", FT_STATS_API(SetShapeCacheBudget));
+    function("GetShapeCacheStats", FT_STATS_API(GetShapeCacheStats));
+    function("ResetShapeCacheStats", FT_STATS_API(ResetShapeCacheStats));
+    function("ClearShapeCache", FT_STATS_API(ClearShapeCache));
+    function("GetGlyphImageData", FT_STATS_API(GetGlyphImageData));
+    function("ConvertGlyphBitmap", FT_STATS_API(ConvertGlyphBitmap));
+    function("CreateAtlas", FT_STATS_API(CreateAtlas));
+    function("DestroyAtlas", FT_STATS_API(DestroyAtlas));
+    function("AtlasAddGlyphs", FT_STATS_API(AtlasAddGlyphs));
+    function("AtlasGetEntries", FT_STATS_API(AtlasGetEntries));
+    function("AtlasGetPageCount", FT_STATS_API(AtlasGetPageCount));
+    function("AtlasGetPage", FT_STATS_API(AtlasGetPage));
+    function("AtlasGetDirtyRects", FT_STATS_API(AtlasGetDirtyRects));
+    function("AtlasClearDirtyRects", FT_STATS_API(AtlasClearDirtyRects));
+    function("SetGlyphCacheBudget", FT_STATS_API(SetGlyphCacheBudget));
+    function("GetGlyphCacheStats", FT_STATS_API(GetGlyphCacheStats));
+    function("ResetGlyphCacheStats", FT_STATS_API(ResetGlyphCacheStats));
+    function("ClearGlyphCache", FT_STATS_API(ClearGlyphCache));
+    function("ExportGlyphSnapshot", FT_STATS_API(ExportGlyphSnapshotView));
+    function("ImportGlyphSnapshot", FT_STATS_API(ImportGlyphSnapshotBytes));
+    function("AllocateGlyphSnapshotBuffer", FT_STATS_API(AllocateGlyphSnapshotBuffer));
+    function("GetGlyphSnapshotBufferView", FT_STATS_API(GetGlyphSnapshotBufferView));
+    function("ImportGlyphSnapshotFromBuffer", FT_STATS_API(ImportGlyphSnapshotFromBuffer));
+    function("FreeGlyphSnapshotBuffer", FT_STATS_API(FreeGlyphSnapshotBuffer));
+    function("GetGlyphSnapshotEntries", FT_STATS_API(GetGlyphSnapshotEntries));
+    function("GetGlyphSnapshotPixels", FT_STATS_API(GetGlyphSnapshotPixels));
+    function("ClearGlyphSnapshot", FT_STATS_API(ClearGlyphSnapshot));
+    function("GetKerning", FT_STATS_API(GetKerning));
+    function("GetKerningPairs", FT_STATS_API(GetKerningPairs));
+    function("GetFaceHandle", FT_STATS_API(GetFaceHandle));
+    function("CreatePixelSize", FT_STATS_API(CreatePixelSize));
+    function("CreateCharSize", FT_STATS_API(CreateCharSize));
+    function("DestroySize", FT_STATS_API(DestroySize));
+    function("GetSizeMetrics", FT_STATS_API(GetSizeMetrics));
+    function("SetFaceCharmap", FT_STATS_API(SetFaceCharmap));
+    function("GetVariationInfo", FT_STATS_API(GetVariationInfo));
+    function("GetVariationInstance", FT_STATS_API(GetVariationInstance));
+    function("GetNamedInstance", FT_STATS_API(GetNamedInstance));
+    function("ClearVariationInstances", FT_STATS_API(ClearVariationInstances));
+    function("LoadGlyphsWithSize", FT_STATS_API(LoadGlyphsWithSize));
+    function("LoadGlyphsFromCharmapWithSize", FT_STATS_API(LoadGlyphsFromCharmapWithSize));
+    function("LoadGlyphViewsWithSize", FT_STATS_API(LoadGlyphViewsWithSize));
+    function("LoadSubpixelGlyphViewsWithSize", FT_STATS_API(LoadSubpixelGlyphViewsWithSize));
+    function("GetKerningWithSize", FT_STATS_API(GetKerningWithSize));
+    function("GetKerningPairsWithSize", FT_STATS_API(GetKerningPairsWithSize));
+    function("CreateAtlasWithSize", FT_STATS_API(CreateAtlasWithSize));
+    function("SetWorkerCount", FT_STATS_API(SetWorkerCount));
+    function("GetWorkerCount", FT_STATS_API(GetWorkerCount));
+    function("LoadGlyphViewsParallel", FT_STATS_API(LoadGlyphViewsParallel));
+    function("LoadGlyphViewsFromCharmapParallel", FT_STATS_API(LoadGlyphViewsFromCharmapParallel));
+    function("Cleanup", FT_STATS_API(Cleanup));
 
     value_object<FT_Glyph_Metrics>("FT_Glyph_Metrics")
         .field("width", &FT_Glyph_Metrics::width)
@@ -520,6 +1086,107 @@ EMSCRIPTEN_BINDINGS(my_module)
         .field("bitmap_left", &FT_GlyphSlotRec::bitmap_left)
         .field("bitmap_top", &FT_GlyphSlotRec::bitmap_top);
 
+    value_object<BitmapView>("BitmapView")
+        .field("rows", &BitmapView::rows)
+        .field("width", &BitmapView::width)
+        .field("pitch", &BitmapView::pitch)
+        .field("pixel_mode", &BitmapView::pixel_mode)
+        .field("num_grays", &BitmapView::num_grays)
+        .field("offset", &BitmapView::offset)
+        .field("length", &BitmapView::length);
+
+    value_object<GlyphView>("GlyphView")
+        .field("linearHoriAdvance", &GlyphView::linearHoriAdvance)
+        .field("linearVertAdvance", &GlyphView::linearVertAdvance)
+        .field("advance", &GlyphView::advance)
+        .field("metrics", &GlyphView::metrics)
+        .field("glyph_index", &GlyphView::glyph_index)
+        .field("format", &GlyphViewFormat_Getter, &NoOpSetter<GlyphView>)
+        .field("bitmap", &GlyphView::bitmap)
+        .field("bitmap_left", &GlyphView::bitmap_left)
+        .field("bitmap_top", &GlyphView::bitmap_top);
+
+    value_object<FontStorageStats>("FontStorageStats")
+        .field("fonts", &FontStorageStats::fonts)
+        .field("bytes", &FontStorageStats::bytes)
+        .field("decoded_bytes", &FontStorageStats::decoded_bytes)
+        .field("pending_bytes", &FontStorageStats::pending_bytes)
+        .field("shared_loads", &FontStorageStats::shared_loads);
+
+    value_object<HotPathStats>("HotPathStats")
+        .field("font_loads", &HotPathStats::font_loads)
+        .field("font_bytes", &HotPathStats::font_bytes)
+        .field("font_load_ms", &HotPathStats::font_load_ms)
+        .field("webfont_decodes", &HotPathStats::webfont_decodes)
+        .field("webfont_decode_ms", &HotPathStats::webfont_decode_ms)
+        .field("glyph_loads", &HotPathStats::glyph_loads)
+        .field("hinted_glyph_loads", &HotPathStats::hinted_glyph_loads)
+        .field("glyph_load_ms", &HotPathStats::glyph_load_ms)
+        .field("glyph_renders", &HotPathStats::glyph_renders)
+        .field("glyph_render_ms", &HotPathStats::glyph_render_ms)
+        .field("snapshot_glyphs", &HotPathStats::snapshot_glyphs)
+        .field("parallel_glyph_loads", &HotPathStats::parallel_glyph_loads)
+        .field("parallel_load_ms", &HotPathStats::parallel_load_ms)
+        .field("kerning_lookups", &HotPathStats::kerning_lookups)
+        .field("bitmap_conversions", &HotPathStats::bitmap_conversions)
+        .field("converted_bytes", &HotPathStats::converted_bytes)
+        .field("api_calls", &HotPathStats::api_calls);
+
+    value_object<MemoryStats>("MemoryStats")
+        .field("live_bytes", &MemoryStats::live_bytes)
+        .field("peak_bytes", &MemoryStats::peak_bytes)
+        .field("allocations", &MemoryStats::allocations);
+
+    value_object<FaceInfo>("FaceInfo")
+        .field("face_handle", &FaceInfo::face_handle)
+        .field("face_index", &FaceInfo::face_index)
+        .field("family_name", &FaceInfo::family_name)
+        .field("style_name", &FaceInfo::style_name)
+        .field("style_flags", &FaceInfo::style_flags);
+
+    value_object<FontSourceInfo>("FontSourceInfo")
+        .field("format", &FontSourceInfo::format)
+        .field("size", &FontSourceInfo::size)
+        .field("sfnt_size", &FontSourceInfo::sfnt_size)
+        .field("decode_ms", &FontSourceInfo::decode_ms);
+
+    value_object<CoverageInfo>("CoverageInfo")
+        .field("codepoints", &CoverageInfo::codepoints)
+        .field("ranges", &CoverageInfo::ranges)
+        .field("bytes", &CoverageInfo::bytes);
+
+    value_object<VariationAxis>("VariationAxis")
+        .field("tag", &VariationAxis::tag)
+        .field("minimum", &VariationAxis::minimum)
+        .field("default_value", &VariationAxis::default_value)
+        .field("maximum", &VariationAxis::maximum);
+
+    value_object<VariationInfo>("VariationInfo")
+        .field("axes", &VariationInfo::axes)
+        .field("named_instances", &VariationInfo::named_instances)
+        .field("coords", &VariationInfo::coords)
+        .field("instances", &VariationInfo::instances);
+
+    value_object<SdfBatchInfo>("SdfBatchInfo")
+        .field("glyph_count", &SdfBatchInfo::glyph_count)
+        .field("outline_glyphs", &SdfBatchInfo::outline_glyphs)
+        .field("bitmap_glyphs", &SdfBatchInfo::bitmap_glyphs)
+        .field("ms", &SdfBatchInfo::ms);
+
+    value_object<TextMetrics>("TextMetrics")
+        .field("width", &TextMetrics::width)
+        .field("height", &TextMetrics::height)
+        .field("line_count", &TextMetrics::line_count)
+        .field("glyph_count", &TextMetrics::glyph_count);
+
+    value_object<LruCacheStats>("LruCacheStats")
+        .field("hits", &LruCacheStats::hits)
+        .field("misses", &LruCacheStats::misses)
+        .field("evictions", &LruCacheStats::evictions)
+        .field("entries", &LruCacheStats::entries)
+        .field("bytes", &LruCacheStats::bytes)
+        .field("budget", &LruCacheStats::budget);
+
     value_object<FT_Vector>("FT_Vector")
         .field("x", &FT_Vector::x)
         .field("y", &FT_Vector::y);
@@ -581,6 +1248,56 @@ EMSCRIPTEN_BINDINGS(my_module)
         .field("charmaps", &CharMaps_Getter, &NoOpSetter<FT_FaceRec>)
         .field("available_sizes", &AvailableSizes_Getter, &NoOpSetter<FT_FaceRec>);
 
+    constant("ATLAS_ENTRY_SIZE", ATLAS_ENTRY_SIZE);
+    constant("STATS_ENABLED", FT_WASM_STATS != 0);
+    constant("SHAPING_ENABLED", FT_WASM_HARFBUZZ != 0);
+
+    constant("GLYPH_METRICS_CHARCODE", (int)GLYPH_METRICS_CHARCODE);
+    constant("GLYPH_METRICS_GLYPH_INDEX", (int)GLYPH_METRICS_GLYPH_INDEX);
+    constant("GLYPH_METRICS_ADVANCE_X", (int)GLYPH_METRICS_ADVANCE_X);
+    constant("GLYPH_METRICS_ADVANCE_Y", (int)GLYPH_METRICS_ADVANCE_Y);
+    constant("GLYPH_METRICS_BEARING_X", (int)GLYPH_METRICS_BEARING_X);
+    constant("GLYPH_METRICS_BEARING_Y", (int)GLYPH_METRICS_BEARING_Y);
+    constant("GLYPH_METRICS_WIDTH", (int)GLYPH_METRICS_WIDTH);
+    constant("GLYPH_METRICS_HEIGHT", (int)GLYPH_METRICS_HEIGHT);
+    constant("GLYPH_METRICS_BITMAP_WIDTH", (int)GLYPH_METRICS_BITMAP_WIDTH);
+    constant("GLYPH_METRICS_BITMAP_ROWS", (int)GLYPH_METRICS_BITMAP_ROWS);
+    constant("GLYPH_METRICS_BITMAP_PITCH", (int)GLYPH_METRICS_BITMAP_PITCH);
+    constant("GLYPH_METRICS_BITMAP_LEFT", (int)GLYPH_METRICS_BITMAP_LEFT);
+    constant("GLYPH_METRICS_BITMAP_TOP", (int)GLYPH_METRICS_BITMAP_TOP);
+    constant("GLYPH_METRICS_BITMAP_OFFSET", (int)GLYPH_METRICS_BITMAP_OFFSET);
+    constant("GLYPH_METRICS_COLUMNS", (int)GLYPH_METRICS_COLUMNS);
+
+    constant("KERNING_PAIR_SIZE", KERNING_PAIR_SIZE);
+    constant("GLYPH_SNAPSHOT_ENTRY_SIZE", GLYPH_SNAPSHOT_ENTRY_SIZE);
+    constant("MAX_SUBPIXEL_BINS", MAX_SUBPIXEL_BINS);
+    constant("VARIATION_AXIS_STEPS", VARIATION_AXIS_STEPS);
+    constant("SHAPED_GLYPH_SIZE", SHAPED_GLYPH_SIZE);
+    constant("SDF_GLYPH_SIZE", SDF_GLYPH_SIZE);
+    constant("SDF_RENDERER_AUTO", (int)SDF_RENDERER_AUTO);
+    constant("SDF_RENDERER_OUTLINE", (int)SDF_RENDERER_OUTLINE);
+    constant("SDF_RENDERER_BITMAP", (int)SDF_RENDERER_BITMAP);
+    constant("OUTLINE_GLYPH_SIZE", OUTLINE_GLYPH_SIZE);
+    constant("OUTLINE_MOVE", (int)OUTLINE_MOVE);
+    constant("OUTLINE_LINE", (int)OUTLINE_LINE);
+    constant("OUTLINE_CONIC", (int)OUTLINE_CONIC);
+    constant("OUTLINE_CUBIC", (int)OUTLINE_CUBIC);
+    constant("OUTLINE_CLOSE", (int)OUTLINE_CLOSE);
+    constant("TEXT_GLYPH_SIZE", TEXT_GLYPH_SIZE);
+    constant("TEXT_LINE_SIZE", TEXT_LINE_SIZE);
+    constant("TEXT_LAYOUT_KERNING", (int)TEXT_LAYOUT_KERNING);
+    constant("TEXT_LAYOUT_HINTED", (int)TEXT_LAYOUT_HINTED);
+    constant("TEXT_LAYOUT_WRAP", (int)TEXT_LAYOUT_WRAP);
+    constant("TEXT_SUBPIXEL_BINS", TEXT_SUBPIXEL_BINS);
+    constant("FALLBACK_GLYPH_SIZE", FALLBACK_GLYPH_SIZE);
+
+    constant("FONT_FORMAT_SFNT", (int)FONT_FORMAT_SFNT);
+    constant("FONT_FORMAT_WOFF", (int)FONT_FORMAT_WOFF);
+    constant("FONT_FORMAT_WOFF2", (int)FONT_FORMAT_WOFF2);
+    constant("BITMAP_FORMAT_ALPHA", (int)BITMAP_FORMAT_ALPHA);
+    constant("BITMAP_FORMAT_RGBA", (int)BITMAP_FORMAT_RGBA);
+    constant("BITMAP_FORMAT_RGBA_PREMULTIPLIED", (int)BITMAP_FORMAT_RGBA_PREMULTIPLIED);
+
     constant("FT_GLYPH_FORMAT_NONE", (unsigned int)FT_Glyph_Format::FT_GLYPH_FORMAT_NONE);
     constant("FT_GLYPH_FORMAT_COMPOSITE", (unsigned int)FT_Glyph_Format::FT_GLYPH_FORMAT_COMPOSITE);
     constant("FT_GLYPH_FORMAT_BITMAP", (unsigned int)FT_Glyph_Format::FT_GLYPH_FORMAT_BITMAP);
@@ -697,4 +1414,4 @@ namespace emscripten
 
     }
 }
-#endif
\ No newline at end of file
+#endif
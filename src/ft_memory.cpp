@@ -0,0 +1,242 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "ft_memory.h"
+
+namespace
+{
+    // Header before each block, 16 bytes keep the malloc alignment
+    struct BlockHeader
+    {
+        uint32_t size;
+        int32_t tag;
+        int32_t size_class;
+        uint32_t reserved;
+    };
+
+    const size_t SIZE_CLASS_STEP = 16;
+    const size_t NUM_SIZE_CLASSES = 16;
+    const size_t CHUNK_SIZE = 16 * 1024;
+
+    thread_local int current_tag = 0;
+
+    // Size class of the size, or -1 for sizes allocated with malloc
+    int SizeClass(size_t size)
+    {
+        return size <= SIZE_CLASS_STEP * NUM_SIZE_CLASSES ? (int)((size + SIZE_CLASS_STEP - 1) / SIZE_CLASS_STEP) - 1 : -1;
+    }
+
+    size_t BlockSize(int size_class)
+    {
+        return sizeof(BlockHeader) + (size_class + 1) * SIZE_CLASS_STEP;
+    }
+}
+
+TrackedMemory::TrackedMemory()
+{
+    memory.user = this;
+    memory.alloc = Alloc;
+    memory.free = Free;
+    memory.realloc = Realloc;
+}
+
+TrackedMemory::~TrackedMemory()
+{
+    for (void *chunk : chunks)
+    {
+        ::free(chunk);
+    }
+}
+
+void *TrackedMemory::Alloc(FT_Memory memory, long size)
+{
+    return static_cast<TrackedMemory *>(memory->user)->Allocate(size);
+}
+
+void TrackedMemory::Free(FT_Memory memory, void *block)
+{
+    static_cast<TrackedMemory *>(memory->user)->Release(block);
+}
+
+void *TrackedMemory::Realloc(FT_Memory memory, long cur_size, long new_size, void *block)
+{
+    TrackedMemory *self = static_cast<TrackedMemory *>(memory->user);
+    if (block == NULL)
+    {
+        return self->Allocate(new_size);
+    }
+
+    // Blocks that stay in the same size class are reused
+    BlockHeader *header = static_cast<BlockHeader *>(block) - 1;
+    if (header->size_class >= 0 && header->size_class == SizeClass(new_size))
+    {
+        std::lock_guard<std::mutex> lock(self->mutex);
+        const size_t old_size = header->size;
+        header->size = new_size;
+        self->total.live_bytes += new_size - old_size;
+        self->total.peak_bytes = std::max(self->total.peak_bytes, self->total.live_bytes);
+        auto tag = self->tags.find(header->tag);
+        if (tag != self->tags.end())
+        {
+            tag->second.live_bytes += new_size - old_size;
+            tag->second.peak_bytes = std::max(tag->second.peak_bytes, tag->second.live_bytes);
+        }
+        return block;
+    }
+
+    void *resized = self->Allocate(new_size);
+    if (resized == NULL)
+    {
+        return NULL;
+    }
+    ::memcpy(resized, block, std::min<long>(cur_size, new_size));
+    self->Release(block);
+    return resized;
+}
+
+void *TrackedMemory::Allocate(size_t size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (limit > 0 && total.live_bytes + size > limit)
+    {
+        return NULL;
+    }
+
+    BlockHeader *header;
+    const int size_class = SizeClass(size);
+    if (size_class >= 0)
+    {
+        auto &blocks = free_blocks[size_class];
+        if (blocks.empty())
+        {
+            // Cut a new chunk to blocks of the class
+            char *chunk = static_cast<char *>(::malloc(CHUNK_SIZE));
+            if (chunk == NULL)
+            {
+                return NULL;
+            }
+            chunks.push_back(chunk);
+            const size_t block_size = BlockSize(size_class);
+            for (size_t offset = 0; offset + block_size <= CHUNK_SIZE; offset += block_size)
+            {
+                blocks.push_back(chunk + offset);
+            }
+        }
+        header = static_cast<BlockHeader *>(blocks.back());
+        blocks.pop_back();
+    }
+    else
+    {
+        header = static_cast<BlockHeader *>(::malloc(sizeof(BlockHeader) + size));
+        if (header == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    header->size = size;
+    header->tag = current_tag;
+    header->size_class = size_class;
+
+    total.live_bytes += size;
+    total.peak_bytes = std::max(total.peak_bytes, total.live_bytes);
+    total.allocations++;
+    MemoryStats &tag = tags[current_tag];
+    tag.live_bytes += size;
+    tag.peak_bytes = std::max(tag.peak_bytes, tag.live_bytes);
+    tag.allocations++;
+    return header + 1;
+}
+
+void TrackedMemory::Release(void *block)
+{
+    if (block == NULL)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    BlockHeader *header = static_cast<BlockHeader *>(block) - 1;
+    total.live_bytes -= header->size;
+    total.allocations--;
+    auto tag = tags.find(header->tag);
+    if (tag != tags.end())
+    {
+        tag->second.live_bytes -= header->size;
+        tag->second.allocations--;
+    }
+
+    if (header->size_class >= 0)
+    {
+        free_blocks[header->size_class].push_back(header);
+    }
+    else
+    {
+        ::free(header);
+    }
+}
+
+MemoryStats TrackedMemory::Stats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return total;
+}
+
+bool TrackedMemory::TagStats(int tag, MemoryStats &stats)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tags.find(tag);
+    if (it == tags.end())
+    {
+        return false;
+    }
+    stats = it->second;
+    return true;
+}
+
+void TrackedMemory::EraseTag(int tag)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    tags.erase(tag);
+}
+
+void TrackedMemory::ResetPeaks()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    total.peak_bytes = total.live_bytes;
+    for (auto &tag : tags)
+    {
+        tag.second.peak_bytes = tag.second.live_bytes;
+    }
+}
+
+void TrackedMemory::SetLimit(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    limit = bytes;
+}
+
+size_t TrackedMemory::PoolBytes()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return chunks.size() * CHUNK_SIZE;
+}
+
+MemoryTagScope::MemoryTagScope(int tag)
+{
+    previous = current_tag;
+    current_tag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+    current_tag = previous;
+}
+
+int MemoryTagScope::Current()
+{
+    return current_tag;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <freetype/freetype.h>
+#include <freetype/ftsystem.h>
+
+struct MemoryStats
+{
+    size_t live_bytes;
+    size_t peak_bytes;
+    size_t allocations;
+};
+
+// FreeType allocator that accounts the allocations to the tag of the
+// current `MemoryTagScope`, e.g. a face. Small allocations come from size
+// class pools, which keep their memory for reuse.
+class TrackedMemory
+{
+public:
+    TrackedMemory();
+    ~TrackedMemory();
+
+    TrackedMemory(const TrackedMemory &) = delete;
+    TrackedMemory &operator=(const TrackedMemory &) = delete;
+
+    FT_Memory Get() { return &memory; }
+
+    MemoryStats Stats();
+
+    // Returns false if nothing was allocated with the tag
+    bool TagStats(int tag, MemoryStats &stats);
+
+    // Forgets a tag, memory freed after this is not accounted to it
+    void EraseTag(int tag);
+
+    void ResetPeaks();
+
+    // Allocations that would go over the limit fail, 0 is no limit
+    void SetLimit(size_t bytes);
+
+    // Bytes reserved by the pools, used and free
+    size_t PoolBytes();
+
+private:
+    static void *Alloc(FT_Memory memory, long size);
+    static void Free(FT_Memory memory, void *block);
+    static void *Realloc(FT_Memory memory, long cur_size, long new_size, void *block);
+
+    void *Allocate(size_t size);
+    void Release(void *block);
+
+    FT_MemoryRec_ memory;
+    std::mutex mutex;
+
+    MemoryStats total = {0, 0, 0};
+    std::map<int, MemoryStats> tags;
+    size_t limit = 0;
+
+    // Free blocks of each size class, and the chunks they are cut from
+    std::vector<void *> free_blocks[16];
+    std::vector<void *> chunks;
+};
+
+// Accounts FreeType allocations of the current thread to the tag for the
+// scope, tag 0 is the library itself
+class MemoryTagScope
+{
+public:
+    explicit MemoryTagScope(int tag);
+    ~MemoryTagScope();
+
+    static int Current();
+
+private:
+    int previous;
+};
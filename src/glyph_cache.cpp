@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "glyph_cache.h"
+
+size_t GlyphCacheKeyHash::operator()(const GlyphCacheKey &key) const
+{
+    size_t h = (size_t)key.face;
+    h = h * 31 + key.x_scale;
+    h = h * 31 + key.y_scale;
+    h = h * 31 + key.load_flags;
+    h = h * 31 + key.glyph_index;
+    h = h * 31 + key.x_offset;
+    return h;
+}
+
+CachedGlyph::CachedGlyph(const FT_GlyphSlotRec &source) : CachedGlyph(source, false)
+{
+}
+
+CachedGlyph::CachedGlyph(const FT_GlyphSlotRec &source, bool borrow_pixels)
+{
+    memset(&slot, 0, sizeof(slot));
+    slot.linearHoriAdvance = source.linearHoriAdvance;
+    slot.linearVertAdvance = source.linearVertAdvance;
+    slot.advance = source.advance;
+    slot.metrics = source.metrics;
+    slot.glyph_index = source.glyph_index;
+    slot.format = source.format;
+    slot.bitmap_left = source.bitmap_left;
+    slot.bitmap_top = source.bitmap_top;
+
+    const FT_Bitmap &bitmap = source.bitmap;
+    const unsigned int apitch = abs(bitmap.pitch);
+    slot.bitmap = bitmap;
+    slot.bitmap.pitch = apitch;
+    slot.bitmap.buffer = NULL;
+
+    if (borrow_pixels)
+    {
+        slot.bitmap.buffer = bitmap.buffer;
+    }
+    else if (bitmap.buffer != NULL && bitmap.rows > 0)
+    {
+        pixels.resize(bitmap.rows * apitch);
+        for (unsigned int y = 0; y < bitmap.rows; y++)
+        {
+            // Negative pitch means the bottom row is first in the buffer
+            const unsigned int src_row = bitmap.pitch >= 0 ? y : bitmap.rows - 1 - y;
+            memcpy(pixels.data() + y * apitch, bitmap.buffer + src_row * apitch, apitch);
+        }
+        slot.bitmap.buffer = pixels.data();
+    }
+}
+
+size_t CachedGlyph::Bytes() const
+{
+    // Bookkeeping of the list and hash map is roughly as large as the key
+    return sizeof(CachedGlyph) + pixels.capacity() + 2 * sizeof(GlyphCacheKey) + 32;
+}
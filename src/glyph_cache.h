@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <freetype/freetype.h>
+
+#include "lru_cache.h"
+
+// Glyphs are cached per face, size, load flags, glyph index and subpixel x
+// offset. The SDF render mode is part of the load flags target.
+struct GlyphCacheKey
+{
+    FT_Face face;
+    FT_Fixed x_scale;
+    FT_Fixed y_scale;
+    FT_Int32 load_flags;
+    FT_UInt glyph_index;
+    // 26.6, less than a pixel
+    FT_Pos x_offset;
+
+    bool operator==(const GlyphCacheKey &other) const
+    {
+        return face == other.face && x_scale == other.x_scale && y_scale == other.y_scale &&
+               load_flags == other.load_flags && glyph_index == other.glyph_index && x_offset == other.x_offset;
+    }
+};
+
+struct GlyphCacheKeyHash
+{
+    size_t operator()(const GlyphCacheKey &key) const;
+};
+
+// Copy of a loaded glyph slot, the bitmap rows are stored top-down
+class CachedGlyph
+{
+public:
+    explicit CachedGlyph(const FT_GlyphSlotRec &source);
+    // Keeps the source bitmap buffer instead of copying it, the bitmap must
+    // be top-down and outlive the entry
+    CachedGlyph(const FT_GlyphSlotRec &source, bool borrow_pixels);
+    CachedGlyph(const CachedGlyph &) = delete;
+    CachedGlyph &operator=(const CachedGlyph &) = delete;
+
+    // Approximate heap usage of the entry
+    size_t Bytes() const;
+
+    // Only the fields exposed to JS are copied, `slot.bitmap.buffer` points
+    // to `pixels` unless borrowed
+    FT_GlyphSlotRec slot;
+    std::vector<unsigned char> pixels;
+};
+
+typedef LruCache<GlyphCacheKey, CachedGlyph, GlyphCacheKeyHash> GlyphCache;
@@ -0,0 +1,230 @@
+#include <string.h>
+
+#include <algorithm>
+#include <tuple>
+
+#include "glyph_snapshot.h"
+
+namespace
+{
+    const uint32_t freetype_version = FREETYPE_MAJOR << 16 | FREETYPE_MINOR << 8 | FREETYPE_PATCH;
+
+    auto EntryKey(const GlyphSnapshotEntry &entry)
+    {
+        return std::make_tuple(entry.font_hash_high, entry.font_hash_low, entry.font_size, entry.face_index, entry.x_scale,
+                               entry.y_scale, entry.load_flags, entry.x_offset, entry.glyph_index);
+    }
+
+    // Bytes of a bitmap row, UINT64_MAX for an unknown pixel mode. Glyphs
+    // that are not rendered have no pixel mode and an empty bitmap.
+    uint64_t RowBytes(uint32_t pixel_mode, uint32_t width)
+    {
+        switch (pixel_mode)
+        {
+        case FT_PIXEL_MODE_NONE:
+            return width == 0 ? 0 : UINT64_MAX;
+        case FT_PIXEL_MODE_MONO:
+            return ((uint64_t)width + 7) / 8;
+        case FT_PIXEL_MODE_GRAY2:
+            return ((uint64_t)width + 3) / 4;
+        case FT_PIXEL_MODE_GRAY4:
+            return ((uint64_t)width + 1) / 2;
+        case FT_PIXEL_MODE_GRAY:
+        case FT_PIXEL_MODE_LCD:
+        case FT_PIXEL_MODE_LCD_V:
+            return width;
+        case FT_PIXEL_MODE_BGRA:
+            return (uint64_t)width * 4;
+        default:
+            return UINT64_MAX;
+        }
+    }
+
+    bool EntryLess(const GlyphSnapshotEntry &a, const GlyphSnapshotEntry &b)
+    {
+        return EntryKey(a) < EntryKey(b);
+    }
+
+    // Entry with only the key fields set
+    GlyphSnapshotEntry MakeKeyEntry(const SnapshotFont &font, const GlyphCacheKey &key)
+    {
+        GlyphSnapshotEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.font_hash_low = (uint32_t)font.hash;
+        entry.font_hash_high = (uint32_t)(font.hash >> 32);
+        entry.font_size = font.size;
+        entry.face_index = font.face_index;
+        entry.x_scale = (int32_t)key.x_scale;
+        entry.y_scale = (int32_t)key.y_scale;
+        entry.load_flags = key.load_flags;
+        entry.x_offset = (int32_t)key.x_offset;
+        entry.glyph_index = key.glyph_index;
+        return entry;
+    }
+}
+
+void GlyphSnapshotWriter::Add(const SnapshotFont &font, const GlyphCacheKey &key, const CachedGlyph &glyph)
+{
+    const FT_GlyphSlotRec &slot = glyph.slot;
+    GlyphSnapshotEntry entry = MakeKeyEntry(font, key);
+    entry.linear_hori_advance = (int32_t)slot.linearHoriAdvance;
+    entry.linear_vert_advance = (int32_t)slot.linearVertAdvance;
+    entry.advance_x = (int32_t)slot.advance.x;
+    entry.advance_y = (int32_t)slot.advance.y;
+    entry.width = (int32_t)slot.metrics.width;
+    entry.height = (int32_t)slot.metrics.height;
+    entry.hori_bearing_x = (int32_t)slot.metrics.horiBearingX;
+    entry.hori_bearing_y = (int32_t)slot.metrics.horiBearingY;
+    entry.hori_advance = (int32_t)slot.metrics.horiAdvance;
+    entry.vert_bearing_x = (int32_t)slot.metrics.vertBearingX;
+    entry.vert_bearing_y = (int32_t)slot.metrics.vertBearingY;
+    entry.vert_advance = (int32_t)slot.metrics.vertAdvance;
+    entry.format = slot.format;
+    entry.bitmap_left = slot.bitmap_left;
+    entry.bitmap_top = slot.bitmap_top;
+    entry.rows = slot.bitmap.rows;
+    entry.bitmap_width = slot.bitmap.width;
+    entry.pitch = slot.bitmap.pitch;
+    entry.pixel_mode = slot.bitmap.pixel_mode;
+    entry.num_grays = slot.bitmap.num_grays;
+
+    // Cached bitmaps are top-down with a positive pitch
+    const size_t length = slot.bitmap.buffer != NULL ? (size_t)slot.bitmap.rows * slot.bitmap.pitch : 0;
+    entry.pixels_offset = pixels.size();
+    entry.pixels_length = length;
+    pixels.insert(pixels.end(), slot.bitmap.buffer, slot.bitmap.buffer + length);
+    entries.push_back(entry);
+}
+
+void GlyphSnapshotWriter::Finish(std::vector<unsigned char> &out)
+{
+    std::sort(entries.begin(), entries.end(), EntryLess);
+
+    GlyphSnapshotHeader header;
+    header.magic = GLYPH_SNAPSHOT_MAGIC;
+    header.version = GLYPH_SNAPSHOT_VERSION;
+    header.freetype_version = freetype_version;
+    header.entry_size = sizeof(GlyphSnapshotEntry);
+    header.entry_count = entries.size();
+    header.pixels_offset = sizeof(header) + entries.size() * sizeof(GlyphSnapshotEntry);
+    header.pixels_size = pixels.size();
+    header.reserved = 0;
+
+    out.resize(header.pixels_offset + pixels.size());
+    memcpy(out.data(), &header, sizeof(header));
+    if (!entries.empty())
+    {
+        memcpy(out.data() + sizeof(header), entries.data(), entries.size() * sizeof(GlyphSnapshotEntry));
+    }
+    if (!pixels.empty())
+    {
+        memcpy(out.data() + header.pixels_offset, pixels.data(), pixels.size());
+    }
+}
+
+bool GlyphSnapshot::Load(std::vector<unsigned char> snapshot)
+{
+    Clear();
+    bytes = std::move(snapshot);
+    if (!Attach(bytes.data(), bytes.size()))
+    {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool GlyphSnapshot::LoadView(const unsigned char *data, size_t data_size)
+{
+    Clear();
+    if ((uintptr_t)data % alignof(GlyphSnapshotEntry) != 0)
+    {
+        return false;
+    }
+    return Attach(data, data_size);
+}
+
+bool GlyphSnapshot::Attach(const unsigned char *data, size_t data_size)
+{
+    GlyphSnapshotHeader header;
+    if (data_size < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != GLYPH_SNAPSHOT_MAGIC || header.version != GLYPH_SNAPSHOT_VERSION ||
+        header.freetype_version != freetype_version || header.entry_size != sizeof(GlyphSnapshotEntry) ||
+        header.pixels_offset != sizeof(header) + (uint64_t)header.entry_count * sizeof(GlyphSnapshotEntry) ||
+        (uint64_t)header.pixels_offset + header.pixels_size != data_size)
+    {
+        return false;
+    }
+
+    entries = (const GlyphSnapshotEntry *)(data + sizeof(header));
+    entry_count = header.entry_count;
+    pixels = data + header.pixels_offset;
+    pixels_size = header.pixels_size;
+    size = data_size;
+    return true;
+}
+
+void GlyphSnapshot::Clear()
+{
+    bytes.clear();
+    bytes.shrink_to_fit();
+    size = 0;
+    entries = nullptr;
+    entry_count = 0;
+    pixels = nullptr;
+    pixels_size = 0;
+}
+
+const GlyphSnapshotEntry *GlyphSnapshot::Find(const SnapshotFont &font, const GlyphCacheKey &key) const
+{
+    if (entry_count == 0)
+    {
+        return nullptr;
+    }
+    const GlyphSnapshotEntry probe = MakeKeyEntry(font, key);
+    const GlyphSnapshotEntry *end = entries + entry_count;
+    const GlyphSnapshotEntry *it = std::lower_bound(entries, end, probe, EntryLess);
+    if (it == end || EntryKey(*it) != EntryKey(probe))
+    {
+        return nullptr;
+    }
+    const uint64_t row_bytes = RowBytes(it->pixel_mode, it->bitmap_width);
+    if (row_bytes == UINT64_MAX || (it->rows > 0 && row_bytes > (uint64_t)std::max(it->pitch, 0)) ||
+        (uint64_t)it->pixels_offset + it->pixels_length > pixels_size ||
+        (uint64_t)it->rows * (uint32_t)std::max(it->pitch, 0) > it->pixels_length)
+    {
+        return nullptr;
+    }
+    return it;
+}
+
+void GlyphSnapshot::ReadSlot(const GlyphSnapshotEntry &entry, FT_GlyphSlotRec &slot) const
+{
+    memset(&slot, 0, sizeof(slot));
+    slot.linearHoriAdvance = entry.linear_hori_advance;
+    slot.linearVertAdvance = entry.linear_vert_advance;
+    slot.advance.x = entry.advance_x;
+    slot.advance.y = entry.advance_y;
+    slot.metrics.width = entry.width;
+    slot.metrics.height = entry.height;
+    slot.metrics.horiBearingX = entry.hori_bearing_x;
+    slot.metrics.horiBearingY = entry.hori_bearing_y;
+    slot.metrics.horiAdvance = entry.hori_advance;
+    slot.metrics.vertBearingX = entry.vert_bearing_x;
+    slot.metrics.vertBearingY = entry.vert_bearing_y;
+    slot.metrics.vertAdvance = entry.vert_advance;
+    slot.glyph_index = entry.glyph_index;
+    slot.format = (FT_Glyph_Format)entry.format;
+    slot.bitmap_left = entry.bitmap_left;
+    slot.bitmap_top = entry.bitmap_top;
+    slot.bitmap.rows = entry.rows;
+    slot.bitmap.width = entry.bitmap_width;
+    slot.bitmap.pitch = entry.pitch;
+    slot.bitmap.pixel_mode = entry.pixel_mode;
+    slot.bitmap.num_grays = entry.num_grays;
+    slot.bitmap.buffer = entry.pixels_length > 0 ? (unsigned char *)pixels + entry.pixels_offset : NULL;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <freetype/freetype.h>
+
+#include "glyph_cache.h"
+
+// Glyph cache snapshots
+//
+// A snapshot holds rendered glyphs with their metrics, so a new process can
+// start with the glyphs of the last one instead of rendering them again.
+// The layout is a header, the entries sorted by key, and the pixels:
+//
+//   GlyphSnapshotHeader
+//   GlyphSnapshotEntry[entry_count]
+//   pixels[pixels_size]
+//
+// All fields are little-endian 32-bit ints, as in wasm memory, so the entries
+// can be read in place with an Int32Array. Loading only checks the header,
+// entries are found with a binary search and their pixels are used from the
+// snapshot without copying.
+//
+// Entries are keyed by the content hash of the font bytes, face index, size,
+// load flags, subpixel offset and glyph index. A font whose bytes changed has
+// another hash, so its stale entries are never found. Snapshots of another
+// FreeType version are rejected as the rendering may differ.
+
+const uint32_t GLYPH_SNAPSHOT_MAGIC = 0x53475446; // "FTGS"
+const uint32_t GLYPH_SNAPSHOT_VERSION = 1;
+
+struct GlyphSnapshotHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    // FREETYPE_MAJOR << 16 | FREETYPE_MINOR << 8 | FREETYPE_PATCH
+    uint32_t freetype_version;
+    uint32_t entry_size;
+    uint32_t entry_count;
+    uint32_t pixels_offset;
+    uint32_t pixels_size;
+    uint32_t reserved;
+};
+
+struct GlyphSnapshotEntry
+{
+    // Key
+    uint32_t font_hash_low;
+    uint32_t font_hash_high;
+    uint32_t font_size;
+    int32_t face_index;
+    int32_t x_scale;
+    int32_t y_scale;
+    int32_t load_flags;
+    int32_t x_offset;
+    uint32_t glyph_index;
+
+    // Slot, lengths in 26.6 pixels like FT_GlyphSlotRec
+    int32_t linear_hori_advance;
+    int32_t linear_vert_advance;
+    int32_t advance_x;
+    int32_t advance_y;
+    int32_t width;
+    int32_t height;
+    int32_t hori_bearing_x;
+    int32_t hori_bearing_y;
+    int32_t hori_advance;
+    int32_t vert_bearing_x;
+    int32_t vert_bearing_y;
+    int32_t vert_advance;
+    uint32_t format;
+    int32_t bitmap_left;
+    int32_t bitmap_top;
+
+    // Bitmap, rows are top-down so pitch is never negative
+    uint32_t rows;
+    uint32_t bitmap_width;
+    int32_t pitch;
+    uint32_t pixel_mode;
+    uint32_t num_grays;
+    // Offset from the start of the pixels
+    uint32_t pixels_offset;
+    uint32_t pixels_length;
+};
+
+// Ints per entry, for reading the entries from JS
+const int GLYPH_SNAPSHOT_ENTRY_SIZE = sizeof(GlyphSnapshotEntry) / sizeof(int32_t);
+
+// Font of the entries, the hash is `FontPtr::hash` of the original bytes
+struct SnapshotFont
+{
+    uint64_t hash;
+    uint32_t size;
+    int32_t face_index;
+};
+
+// Writes cached glyphs to a snapshot
+class GlyphSnapshotWriter
+{
+public:
+    void Add(const SnapshotFont &font, const GlyphCacheKey &key, const CachedGlyph &glyph);
+
+    // Sorts the entries and writes the snapshot to `out`
+    void Finish(std::vector<unsigned char> &out);
+
+private:
+    std::vector<GlyphSnapshotEntry> entries;
+    std::vector<unsigned char> pixels;
+};
+
+class GlyphSnapshot
+{
+public:
+    // Takes the snapshot bytes, returns false and stays empty if the header
+    // is not valid for this build
+    bool Load(std::vector<unsigned char> snapshot);
+    // Uses the snapshot bytes in place without copying them, e.g. a memory
+    // mapped file. They must stay valid and 4-byte aligned until the next
+    // `Load`, `LoadView` or `Clear`.
+    bool LoadView(const unsigned char *data, size_t size);
+    void Clear();
+
+    // Entry of the glyph, or nullptr. Entries with pixels outside of the
+    // snapshot, rows wider than their pitch or an unknown pixel mode are not
+    // returned.
+    const GlyphSnapshotEntry *Find(const SnapshotFont &font, const GlyphCacheKey &key) const;
+
+    // Slot of the entry, the bitmap buffer points into the snapshot
+    void ReadSlot(const GlyphSnapshotEntry &entry, FT_GlyphSlotRec &slot) const;
+
+    size_t EntryCount() const { return entry_count; }
+    const GlyphSnapshotEntry *Entries() const { return entries; }
+    const unsigned char *Pixels() const { return pixels; }
+    size_t PixelsSize() const { return pixels_size; }
+    size_t Bytes() const { return size; }
+
+private:
+    // Checks the header and points the entries and pixels into `data`
+    bool Attach(const unsigned char *data, size_t data_size);
+
+    // Owned bytes of `Load`, empty for `LoadView`
+    std::vector<unsigned char> bytes;
+    size_t size = 0;
+    const GlyphSnapshotEntry *entries = nullptr;
+    size_t entry_count = 0;
+    const unsigned char *pixels = nullptr;
+    size_t pixels_size = 0;
+};
@@ -0,0 +1,527 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <freetype/freetype.h>
+#include <freetype/ftadvanc.h>
+
+#include "layout.h"
+
+std::vector<int32_t> layout_glyphs;
+std::vector<int32_t> layout_lines;
+std::vector<int32_t> fallback_glyphs;
+std::vector<unsigned char> text_pixels;
+
+namespace
+{
+    bool IsSpace(FT_ULong c)
+    {
+        return c == ' ' || c == '\t' || c == 0x3000;
+    }
+
+    bool IsHardBreak(FT_ULong c)
+    {
+        return c == '\n' || c == '\r' || c == 0x2028 || c == 0x2029;
+    }
+
+    // Lines can break after hyphens and dashes
+    bool IsBreakAfter(FT_ULong c)
+    {
+        return c == '-' || c == 0x2010 || c == 0x2013 || c == 0x2014;
+    }
+
+    struct PlacedGlyph
+    {
+        FT_UInt glyph_index;
+        FT_Pos x;
+        FT_Pos advance;
+        uint32_t cluster;
+    };
+
+    struct Line
+    {
+        size_t first;
+        size_t count;
+        FT_Pos width;
+    };
+
+    // Glyph index and advance of a code point, looked up once per call
+    struct GlyphAdvance
+    {
+        FT_UInt glyph_index;
+        FT_Pos advance;
+    };
+
+    template <typename Text, typename Decode>
+    TextMetrics LayoutWithSize(int size_handle, const Text &text, Decode decode, FT_Pos max_width, int flags, bool store)
+    {
+        SizeHandle *handle = GetSizeHandle(size_handle);
+        if (handle == nullptr)
+        {
+            if (store)
+            {
+                layout_glyphs.clear();
+                layout_lines.clear();
+            }
+            return {0, 0, 0, 0};
+        }
+
+        std::vector<FT_ULong> codepoints;
+        std::vector<uint32_t> clusters;
+        decode(text, codepoints, clusters);
+        return LayoutCodepoints(handle->size, codepoints, clusters, max_width, flags, store);
+    }
+}
+
+void DecodeUtf8(const std::string &text, std::vector<FT_ULong> &codepoints, std::vector<uint32_t> &clusters)
+{
+    // Smallest value of each sequence length, shorter encodings are overlong
+    static const FT_ULong min_values[] = {0, 0x80, 0x800, 0x10000};
+
+    codepoints.clear();
+    clusters.clear();
+    const unsigned char *bytes = (const unsigned char *)text.data();
+    const size_t size = text.size();
+    size_t i = 0;
+    while (i < size)
+    {
+        const size_t start = i;
+        const unsigned char lead = bytes[i++];
+        const int extra = lead < 0x80 ? 0 : lead < 0xc2 ? -1 : lead < 0xe0 ? 1 : lead < 0xf0 ? 2 : lead < 0xf5 ? 3 : -1;
+        FT_ULong codepoint = 0xfffd;
+        if (extra == 0)
+        {
+            codepoint = lead;
+        }
+        else if (extra > 0)
+        {
+            FT_ULong value = lead & (0x3f >> extra);
+            int k = 0;
+            for (; k < extra && i < size && (bytes[i] & 0xc0) == 0x80; k++, i++)
+            {
+                value = (value << 6) | (bytes[i] & 0x3f);
+            }
+            if (k == extra && value >= min_values[extra] && value <= 0x10ffff && (value < 0xd800 || value > 0xdfff))
+            {
+                codepoint = value;
+            }
+        }
+        codepoints.push_back(codepoint);
+        clusters.push_back(start);
+    }
+}
+
+void DecodeUtf16(const std::u16string &text, std::vector<FT_ULong> &codepoints, std::vector<uint32_t> &clusters)
+{
+    codepoints.clear();
+    clusters.clear();
+    const size_t size = text.size();
+    for (size_t i = 0; i < size; i++)
+    {
+        const size_t start = i;
+        const FT_ULong unit = text[i];
+        FT_ULong codepoint = unit;
+        if (unit >= 0xd800 && unit <= 0xdfff)
+        {
+            // Surrogate pair, lone surrogates are invalid
+            const FT_ULong low = i + 1 < size ? text[i + 1] : 0;
+            if (unit < 0xdc00 && low >= 0xdc00 && low <= 0xdfff)
+            {
+                codepoint = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+                i++;
+            }
+            else
+            {
+                codepoint = 0xfffd;
+            }
+        }
+        codepoints.push_back(codepoint);
+        clusters.push_back(start);
+    }
+}
+
+TextMetrics LayoutCodepoints(FT_Size size, const std::vector<FT_ULong> &codepoints, const std::vector<uint32_t> &clusters,
+                             FT_Pos max_width, int flags, bool store)
+{
+    FT_Face face = size->face;
+    ScopedSize scoped_size(size);
+    MemoryTagScope memory_tag(FaceMemoryTag(face));
+
+    // Unhinted advances come from the metrics tables without loading glyphs
+    const bool hinted = (flags & TEXT_LAYOUT_HINTED) != 0;
+    const FT_Int32 load_flags = hinted ? FT_LOAD_DEFAULT : FT_LOAD_NO_HINTING;
+    const bool kerning = (flags & TEXT_LAYOUT_KERNING) != 0 && FT_HAS_KERNING(face);
+    const FT_UInt kern_mode = hinted ? FT_KERNING_DEFAULT : FT_KERNING_UNFITTED;
+
+    std::unordered_map<FT_ULong, GlyphAdvance> advances;
+    std::vector<PlacedGlyph> glyphs;
+    std::vector<Line> lines;
+    glyphs.reserve(codepoints.size());
+
+    size_t line_start = 0;
+    FT_Pos pen = 0;
+    // End of the last glyph of the line that is not a space
+    FT_Pos content_end = 0;
+    // First glyph after the last break opportunity of the line, and the
+    // width of the line if it's broken there
+    size_t break_glyph = SIZE_MAX;
+    FT_Pos break_width = 0;
+    bool after_break = false;
+    FT_UInt previous = 0;
+    // Hard breaks start a line even if it stays empty
+    bool open_line = false;
+
+    auto end_line = [&](size_t end, FT_Pos width)
+    {
+        lines.push_back({line_start, end - line_start, width});
+        line_start = end;
+    };
+
+    for (size_t i = 0; i < codepoints.size(); i++)
+    {
+        const FT_ULong c = codepoints[i];
+        if (IsHardBreak(c))
+        {
+            // CR LF is one break
+            if (c == '\r' && i + 1 < codepoints.size() && codepoints[i + 1] == '\n')
+            {
+                continue;
+            }
+            end_line(glyphs.size(), content_end);
+            pen = content_end = 0;
+            break_glyph = SIZE_MAX;
+            after_break = false;
+            previous = 0;
+            open_line = true;
+            continue;
+        }
+
+        auto found = advances.find(c);
+        if (found == advances.end())
+        {
+            GlyphAdvance glyph;
+            glyph.glyph_index = FT_Get_Char_Index(face, c == '\t' ? ' ' : c);
+            FT_Fixed advance;
+            if (FT_Get_Advance(face, glyph.glyph_index, load_flags, &advance))
+            {
+                advance = 0;
+            }
+            // 16.16 to 26.6
+            glyph.advance = (advance + 512) >> 10;
+            found = advances.emplace(c, glyph).first;
+        }
+        const GlyphAdvance &glyph = found->second;
+
+        if (kerning && previous != 0 && glyph.glyph_index != 0)
+        {
+            FT_Vector delta;
+            FT_STATS_ADD(kerning_lookups, 1);
+            if (!FT_Get_Kerning(face, previous, glyph.glyph_index, kern_mode, &delta))
+            {
+                pen += delta.x;
+            }
+        }
+
+        const bool space = IsSpace(c);
+        if (!space && after_break)
+        {
+            break_glyph = glyphs.size();
+            break_width = content_end;
+        }
+        glyphs.push_back({glyph.glyph_index, pen, glyph.advance, clusters[i]});
+        pen += glyph.advance;
+        previous = glyph.glyph_index;
+        after_break = space || IsBreakAfter(c);
+
+        // Spaces hang over the end of the line
+        if (space)
+        {
+            continue;
+        }
+
+        // The line is broken at the last break opportunity, or before the
+        // glyph if there is none. Until the glyph fits or starts the line.
+        const size_t current = glyphs.size() - 1;
+        while (max_width > 0 && pen > max_width && current > line_start)
+        {
+            size_t wrap = current;
+            FT_Pos width = glyphs[current - 1].x + glyphs[current - 1].advance;
+            if (break_glyph != SIZE_MAX && break_glyph > line_start)
+            {
+                wrap = break_glyph;
+                width = break_width;
+            }
+            end_line(wrap, width);
+
+            const FT_Pos shift = glyphs[wrap].x;
+            for (size_t j = wrap; j < glyphs.size(); j++)
+            {
+                glyphs[j].x -= shift;
+            }
+            pen -= shift;
+            break_glyph = SIZE_MAX;
+        }
+        content_end = pen;
+    }
+    if (glyphs.size() > line_start || open_line)
+    {
+        end_line(glyphs.size(), content_end);
+    }
+
+    const FT_Size_Metrics &size_metrics = size->metrics;
+    TextMetrics metrics = {0, (FT_Pos)lines.size() * size_metrics.height, (int)lines.size(), (int)glyphs.size()};
+    for (auto &line : lines)
+    {
+        metrics.width = std::max(metrics.width, line.width);
+    }
+
+    if (store)
+    {
+        layout_glyphs.resize(TEXT_GLYPH_SIZE * glyphs.size());
+        layout_lines.resize(TEXT_LINE_SIZE * lines.size());
+        for (size_t l = 0; l < lines.size(); l++)
+        {
+            const Line &line = lines[l];
+            const FT_Pos baseline = size_metrics.ascender + l * size_metrics.height;
+            int32_t *line_row = layout_lines.data() + l * TEXT_LINE_SIZE;
+            line_row[0] = line.first;
+            line_row[1] = line.count;
+            line_row[2] = line.width;
+            line_row[3] = baseline;
+            for (size_t g = line.first; g < line.first + line.count; g++)
+            {
+                int32_t *row = layout_glyphs.data() + g * TEXT_GLYPH_SIZE;
+                row[0] = glyphs[g].glyph_index;
+                row[1] = glyphs[g].x;
+                row[2] = baseline;
+                row[3] = glyphs[g].cluster;
+            }
+        }
+    }
+    return metrics;
+}
+
+namespace
+{
+    // Coverage of the RGBA formats before the color is applied
+    std::vector<unsigned char> text_coverage;
+    // Glyph bitmaps that are not 8-bit gray, converted to alpha
+    std::vector<unsigned char> glyph_alpha;
+
+    // Composites the 8-bit coverage with its top left corner at x, y over
+    // `dst`, clipped to the buffer. `src` is the top row.
+    void CompositeCoverage(const unsigned char *src, int src_pitch, int src_width, int src_rows, int x, int y,
+                           unsigned char *dst, int width, int height)
+    {
+        const int x0 = std::max(x, 0);
+        const int x1 = std::min(x + src_width, width);
+        const int y0 = std::max(y, 0);
+        const int y1 = std::min(y + src_rows, height);
+        for (int row = y0; row < y1; row++)
+        {
+            const unsigned char *s = src + (ptrdiff_t)(row - y) * src_pitch + (x0 - x);
+            unsigned char *d = dst + (size_t)row * width + x0;
+            for (int col = x0; col < x1; col++, s++, d++)
+            {
+                // Source over destination
+                *d = *s + *d - (*s * *d + 127) / 255;
+            }
+        }
+    }
+
+    template <typename Text, typename Decode>
+    bool RenderWithSize(int size_handle, const Text &text, Decode decode, unsigned int width, unsigned int height, int flags,
+                        int format, unsigned int color)
+    {
+        SizeHandle *handle = GetSizeHandle(size_handle);
+        if (handle == nullptr)
+        {
+            return false;
+        }
+
+        std::vector<FT_ULong> codepoints;
+        std::vector<uint32_t> clusters;
+        decode(text, codepoints, clusters);
+        return RenderCodepoints(handle->size, codepoints, clusters, width, height, flags, format, color);
+    }
+}
+
+bool RenderCodepoints(FT_Size size, const std::vector<FT_ULong> &codepoints, const std::vector<uint32_t> &clusters,
+                      unsigned int width, unsigned int height, int flags, int format, unsigned int color)
+{
+    if (width == 0 || height == 0 || format < BITMAP_FORMAT_ALPHA || format > BITMAP_FORMAT_RGBA_PREMULTIPLIED)
+    {
+        return false;
+    }
+    const FT_Pos max_width = (flags & TEXT_LAYOUT_WRAP) != 0 ? (FT_Pos)width * 64 : 0;
+    LayoutCodepoints(size, codepoints, clusters, max_width, flags, true);
+
+    std::vector<unsigned char> &coverage = format == BITMAP_FORMAT_ALPHA ? text_pixels : text_coverage;
+    coverage.assign((size_t)width * height, 0);
+
+    FT_Face face = size->face;
+    ScopedSize scoped_size(size);
+    const bool hinted = (flags & TEXT_LAYOUT_HINTED) != 0;
+    const FT_Int32 load_flags = FT_LOAD_RENDER | (hinted ? FT_LOAD_DEFAULT : FT_LOAD_NO_HINTING);
+    const FT_Pos ppem = size->metrics.x_ppem;
+    for (size_t g = 0; g < layout_glyphs.size(); g += TEXT_GLYPH_SIZE)
+    {
+        const FT_Pos pen_x = layout_glyphs[g + 1];
+        const FT_Pos baseline = layout_glyphs[g + 2];
+
+        // Lines below the buffer and glyphs right of it are not loaded
+        if ((baseline - size->metrics.ascender) >> 6 >= (FT_Pos)height)
+        {
+            break;
+        }
+        if ((pen_x >> 6) - ppem >= (FT_Pos)width)
+        {
+            continue;
+        }
+
+        FT_Pos pixel_x = (pen_x + 32) >> 6;
+        int bin = 0;
+        if (!hinted)
+        {
+            bin = SubpixelBin(pen_x, TEXT_SUBPIXEL_BINS, &pixel_x);
+        }
+        const FT_GlyphSlotRec *slot = LoadCachedGlyph(face, layout_glyphs[g], load_flags, SubpixelOffset(bin, TEXT_SUBPIXEL_BINS));
+        if (slot == NULL || slot->bitmap.buffer == NULL || slot->bitmap.rows == 0)
+        {
+            continue;
+        }
+
+        const FT_Bitmap &bitmap = slot->bitmap;
+        const int x = pixel_x + slot->bitmap_left;
+        const int y = ((baseline + 32) >> 6) - slot->bitmap_top;
+        if (bitmap.pixel_mode == FT_PIXEL_MODE_GRAY)
+        {
+            // Negative pitch means the bottom row is first in the buffer
+            const unsigned char *top = bitmap.pitch >= 0 ? bitmap.buffer : bitmap.buffer + (size_t)(bitmap.rows - 1) * -bitmap.pitch;
+            CompositeCoverage(top, bitmap.pitch, bitmap.width, bitmap.rows, x, y, coverage.data(), width, height);
+            continue;
+        }
+
+        unsigned int alpha_width, alpha_rows;
+        if (!GetConvertedSize(bitmap, alpha_width, alpha_rows))
+        {
+            continue;
+        }
+        glyph_alpha.resize((size_t)alpha_width * alpha_rows);
+        if (ConvertBitmap(bitmap, BITMAP_FORMAT_ALPHA, 0, glyph_alpha.data()))
+        {
+            CompositeCoverage(glyph_alpha.data(), alpha_width, alpha_width, alpha_rows, x, y, coverage.data(), width, height);
+        }
+    }
+
+    if (format != BITMAP_FORMAT_ALPHA)
+    {
+        FT_Bitmap gray;
+        memset(&gray, 0, sizeof(gray));
+        gray.rows = height;
+        gray.width = width;
+        gray.pitch = width;
+        gray.pixel_mode = FT_PIXEL_MODE_GRAY;
+        gray.num_grays = 256;
+        gray.buffer = coverage.data();
+        text_pixels.resize(GetConvertedBytes(gray, (BitmapFormat)format));
+        ConvertBitmap(gray, (BitmapFormat)format, color, text_pixels.data());
+    }
+    return true;
+}
+
+bool RenderText(int size_handle, const std::string &text, unsigned int width, unsigned int height, int flags, int format,
+                unsigned int color)
+{
+    return RenderWithSize(size_handle, text, DecodeUtf8, width, height, flags, format, color);
+}
+
+bool RenderTextUtf16(int size_handle, const std::u16string &text, unsigned int width, unsigned int height, int flags,
+                     int format, unsigned int color)
+{
+    return RenderWithSize(size_handle, text, DecodeUtf16, width, height, flags, format, color);
+}
+
+TextMetrics MeasureText(int size_handle, const std::string &text, FT_Pos max_width, int flags)
+{
+    return LayoutWithSize(size_handle, text, DecodeUtf8, max_width, flags, false);
+}
+
+TextMetrics MeasureTextUtf16(int size_handle, const std::u16string &text, FT_Pos max_width, int flags)
+{
+    return LayoutWithSize(size_handle, text, DecodeUtf16, max_width, flags, false);
+}
+
+TextMetrics LayoutText(int size_handle, const std::string &text, FT_Pos max_width, int flags)
+{
+    return LayoutWithSize(size_handle, text, DecodeUtf8, max_width, flags, true);
+}
+
+TextMetrics LayoutTextUtf16(int size_handle, const std::u16string &text, FT_Pos max_width, int flags)
+{
+    return LayoutWithSize(size_handle, text, DecodeUtf16, max_width, flags, true);
+}
+
+int ResolveCodepoints(const std::vector<int> &face_handles, const std::vector<FT_ULong> &codepoints,
+                      const std::vector<uint32_t> &clusters)
+{
+    fallback_glyphs.clear();
+    std::vector<Font *> fonts;
+    for (int face_handle : face_handles)
+    {
+        Font *font = GetFontByHandle(face_handle);
+        if (font == nullptr)
+        {
+            continue;
+        }
+        if (!font->coverage.IsBuilt() && font->Open() == nullptr)
+        {
+            continue;
+        }
+        fonts.push_back(font);
+    }
+    if (fonts.empty())
+    {
+        return -1;
+    }
+
+    fallback_glyphs.resize(FALLBACK_GLYPH_SIZE * codepoints.size());
+    for (size_t i = 0; i < codepoints.size(); i++)
+    {
+        Font *match = fonts[0];
+        FT_UInt glyph_index = 0;
+        for (Font *font : fonts)
+        {
+            glyph_index = font->coverage.Find(codepoints[i]);
+            if (glyph_index != 0)
+            {
+                match = font;
+                break;
+            }
+        }
+        int32_t *row = fallback_glyphs.data() + i * FALLBACK_GLYPH_SIZE;
+        row[0] = match->handle;
+        row[1] = glyph_index;
+        row[2] = clusters[i];
+    }
+    return codepoints.size();
+}
+
+int ResolveFallback(const std::vector<int> &face_handles, const std::string &text)
+{
+    std::vector<FT_ULong> codepoints;
+    std::vector<uint32_t> clusters;
+    DecodeUtf8(text, codepoints, clusters);
+    return ResolveCodepoints(face_handles, codepoints, clusters);
+}
+
+int ResolveFallbackUtf16(const std::vector<int> &face_handles, const std::u16string &text)
+{
+    std::vector<FT_ULong> codepoints;
+    std::vector<uint32_t> clusters;
+    DecodeUtf16(text, codepoints, clusters);
+    return ResolveCodepoints(face_handles, codepoints, clusters);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <freetype/freetype.h>
+
+#include "core.h"
+
+// Text layout
+//
+// Text is measured with the advances of FT_Get_Advance, glyphs are not
+// loaded or rendered. Lines are broken greedily at spaces and after hyphens,
+// words longer than the line are broken between glyphs. Lengths are in 26.6
+// pixels.
+
+enum TextLayoutFlags
+{
+    // Adds the kerning of the `kern` table between glyph pairs
+    TEXT_LAYOUT_KERNING = 1,
+    // Hinted advances, these load each glyph once per call so they are slower
+    TEXT_LAYOUT_HINTED = 2,
+    // Breaks lines at the width of the `RenderText` buffer
+    TEXT_LAYOUT_WRAP = 4,
+};
+
+// Glyph rows: glyph index, pen x, baseline y and cluster, which is the offset
+// of the glyph's character in the text
+const int TEXT_GLYPH_SIZE = 4;
+
+// Line rows: first glyph, glyph count, width and baseline y. Width leaves out
+// the spaces at the end of the line.
+const int TEXT_LINE_SIZE = 4;
+
+struct TextMetrics
+{
+    FT_Pos width;
+    FT_Pos height;
+    int line_count;
+    int glyph_count;
+};
+
+// Rows of the last `LayoutText` call
+extern std::vector<int32_t> layout_glyphs;
+extern std::vector<int32_t> layout_lines;
+
+// Decodes the text to code points, `clusters` gets the offset of each code
+// point in the text. Invalid sequences decode to U+FFFD.
+void DecodeUtf8(const std::string &text, std::vector<FT_ULong> &codepoints, std::vector<uint32_t> &clusters);
+void DecodeUtf16(const std::u16string &text, std::vector<FT_ULong> &codepoints, std::vector<uint32_t> &clusters);
+
+// Lays out the code points with the size, lines are broken to `max_width`,
+// 0 doesn't break lines. The rows are written to `layout_glyphs` and
+// `layout_lines` if `store` is true.
+TextMetrics LayoutCodepoints(FT_Size size, const std::vector<FT_ULong> &codepoints, const std::vector<uint32_t> &clusters,
+                             FT_Pos max_width, int flags, bool store);
+
+// Measures the text without storing rows
+TextMetrics MeasureText(int size_handle, const std::string &text, FT_Pos max_width, int flags);
+TextMetrics MeasureTextUtf16(int size_handle, const std::u16string &text, FT_Pos max_width, int flags);
+
+TextMetrics LayoutText(int size_handle, const std::string &text, FT_Pos max_width, int flags);
+TextMetrics LayoutTextUtf16(int size_handle, const std::u16string &text, FT_Pos max_width, int flags);
+
+// Text rendering
+//
+// Text is laid out like `LayoutText` and the coverage of every glyph is
+// composited into one buffer, so a label is one call and one buffer. Glyphs
+// sit on the baselines of their lines, the first baseline is at the
+// ascender, and are clipped to the buffer. Unhinted glyphs are placed at
+// quarter pixels with subpixel glyphs, hinted glyphs at whole pixels.
+
+const int TEXT_SUBPIXEL_BINS = 4;
+
+// Pixels of the last `RenderText` call, `width * height` bytes of
+// BITMAP_FORMAT_ALPHA, or 4 bytes per pixel in the RGBA formats
+extern std::vector<unsigned char> text_pixels;
+
+// Renders the code points with the size to a `width` x `height` buffer of
+// one of BITMAP_FORMAT_*, coverage is drawn with `color` (0xRRGGBB) in the
+// RGBA formats. The layout rows are stored as by `LayoutText`. Returns false
+// if the buffer is empty or the format is not known.
+bool RenderCodepoints(FT_Size size, const std::vector<FT_ULong> &codepoints, const std::vector<uint32_t> &clusters,
+                      unsigned int width, unsigned int height, int flags, int format, unsigned int color);
+
+bool RenderText(int size_handle, const std::string &text, unsigned int width, unsigned int height, int flags, int format,
+                unsigned int color);
+bool RenderTextUtf16(int size_handle, const std::u16string &text, unsigned int width, unsigned int height, int flags,
+                     int format, unsigned int color);
+
+// Font fallback
+//
+// Each code point goes to the first face of an ordered list whose Unicode
+// coverage has it, see char_coverage.h. Faces are not loaded from, so this
+// is table lookups only. Faces of `LoadFontCollection` are opened once to
+// build their coverage.
+
+// Fallback rows: face handle, glyph index and cluster. Code points that no
+// face covers get the first face and glyph index 0.
+const int FALLBACK_GLYPH_SIZE = 3;
+
+// Rows of the last `ResolveFallback` call
+extern std::vector<int32_t> fallback_glyphs;
+
+// Resolves the code points with the faces, unknown face handles are skipped.
+// Returns the number of rows, or -1 if no face handle is known.
+int ResolveCodepoints(const std::vector<int> &face_handles, const std::vector<FT_ULong> &codepoints,
+                      const std::vector<uint32_t> &clusters);
+
+int ResolveFallback(const std::vector<int> &face_handles, const std::string &text);
+int ResolveFallbackUtf16(const std::vector<int> &face_handles, const std::u16string &text);
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+struct LruCacheStats
+{
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t entries;
+    size_t bytes;
+    size_t budget;
+};
+
+// Least recently used cache with a byte budget
+//
+// Values are owned by the cache and stay at the same address until evicted.
+// Every entry has a size in bytes given on insert, the least recently used
+// entries are evicted when the total goes over the budget.
+template <typename Key, typename Value, typename Hash>
+class LruCache
+{
+public:
+    explicit LruCache(size_t budget) : budget(budget) {}
+
+    // Returns the cached value and marks it as the most recently used, or
+    // nullptr if it's not in the cache
+    Value *Find(const Key &key)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+        {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->value.get();
+    }
+
+    // Returns nullptr if the value alone is over the budget
+    Value *Insert(const Key &key, std::unique_ptr<Value> value, size_t value_bytes)
+    {
+        if (value_bytes > budget)
+        {
+            return nullptr;
+        }
+
+        Erase(key);
+        entries.push_front({key, std::move(value), value_bytes});
+        index[key] = entries.begin();
+        bytes += value_bytes;
+        Evict(budget);
+        return entries.front().value.get();
+    }
+
+    void Erase(const Key &key)
+    {
+        auto it = index.find(key);
+        if (it != index.end())
+        {
+            bytes -= it->second->bytes;
+            entries.erase(it->second);
+            index.erase(it);
+        }
+    }
+
+    template <typename Predicate>
+    void EraseIf(Predicate predicate)
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (predicate(it->key))
+            {
+                bytes -= it->bytes;
+                index.erase(it->key);
+                it = entries.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+
+    // Calls `f(key, value)` for each entry, from the most recently used
+    template <typename F>
+    void ForEach(F f) const
+    {
+        for (const Entry &entry : entries)
+        {
+            f(entry.key, *entry.value);
+        }
+    }
+
+    void SetBudget(size_t new_budget)
+    {
+        budget = new_budget;
+        Evict(budget);
+    }
+
+    void Clear()
+    {
+        entries.clear();
+        index.clear();
+        bytes = 0;
+    }
+
+    void ResetStats()
+    {
+        hits = misses = evictions = 0;
+    }
+
+    LruCacheStats Stats() const
+    {
+        return {hits, misses, evictions, entries.size(), bytes, budget};
+    }
+
+private:
+    struct Entry
+    {
+        Key key;
+        std::unique_ptr<Value> value;
+        size_t bytes;
+    };
+
+    void Evict(size_t max_bytes)
+    {
+        while (bytes > max_bytes && !entries.empty())
+        {
+            Entry &last = entries.back();
+            bytes -= last.bytes;
+            index.erase(last.key);
+            entries.pop_back();
+            evictions++;
+        }
+    }
+
+    std::list<Entry> entries;
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+    size_t budget;
+    size_t bytes = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+};
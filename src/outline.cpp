@@ -0,0 +1,168 @@
+#include <stdint.h>
+
+#include <initializer_list>
+#include <memory>
+
+#include <freetype/freetype.h>
+#include <freetype/ftoutln.h>
+
+#include "core.h"
+#include "outline.h"
+
+std::vector<int32_t> outline_glyphs;
+std::vector<uint8_t> outline_commands;
+std::vector<int32_t> outline_points;
+
+namespace
+{
+    OutlineCache outline_cache(4 << 20);
+
+    struct Decomposer
+    {
+        CachedOutline *outline;
+        bool open;
+
+        void Add(OutlineCommand command, std::initializer_list<const FT_Vector *> points)
+        {
+            outline->commands.push_back(command);
+            for (const FT_Vector *point : points)
+            {
+                outline->points.push_back(point->x);
+                outline->points.push_back(point->y);
+            }
+        }
+    };
+
+    int MoveTo(const FT_Vector *to, void *user)
+    {
+        Decomposer *decomposer = (Decomposer *)user;
+        if (decomposer->open)
+        {
+            decomposer->Add(OUTLINE_CLOSE, {});
+        }
+        decomposer->Add(OUTLINE_MOVE, {to});
+        decomposer->open = true;
+        return 0;
+    }
+
+    int LineTo(const FT_Vector *to, void *user)
+    {
+        ((Decomposer *)user)->Add(OUTLINE_LINE, {to});
+        return 0;
+    }
+
+    int ConicTo(const FT_Vector *control, const FT_Vector *to, void *user)
+    {
+        ((Decomposer *)user)->Add(OUTLINE_CONIC, {control, to});
+        return 0;
+    }
+
+    int CubicTo(const FT_Vector *control1, const FT_Vector *control2, const FT_Vector *to, void *user)
+    {
+        ((Decomposer *)user)->Add(OUTLINE_CUBIC, {control1, control2, to});
+        return 0;
+    }
+
+    const FT_Outline_Funcs outline_funcs = {MoveTo, LineTo, ConicTo, CubicTo, 0, 0};
+
+    // Glyphs that fail to load get an empty outline
+    std::unique_ptr<CachedOutline> DecomposeGlyph(FT_Face face, FT_UInt glyph_index, FT_Int32 load_flags)
+    {
+        auto outline = std::make_unique<CachedOutline>();
+        outline->advance_x = 0;
+        if (LoadGlyphSlot(face, glyph_index, load_flags))
+        {
+            return outline;
+        }
+        outline->advance_x = face->glyph->advance.x;
+        if (face->glyph->format == FT_GLYPH_FORMAT_OUTLINE)
+        {
+            Decomposer decomposer = {outline.get(), false};
+            FT_Outline_Decompose(&face->glyph->outline, &outline_funcs, &decomposer);
+            if (decomposer.open)
+            {
+                decomposer.Add(OUTLINE_CLOSE, {});
+            }
+        }
+        return outline;
+    }
+
+    void AppendOutline(FT_UInt glyph_index, const CachedOutline &outline)
+    {
+        outline_glyphs.push_back(glyph_index);
+        outline_glyphs.push_back(outline_commands.size());
+        outline_glyphs.push_back(outline.commands.size());
+        outline_glyphs.push_back(outline_points.size() / 2);
+        outline_glyphs.push_back(outline.points.size() / 2);
+        outline_glyphs.push_back(outline.advance_x);
+        outline_commands.insert(outline_commands.end(), outline.commands.begin(), outline.commands.end());
+        outline_points.insert(outline_points.end(), outline.points.begin(), outline.points.end());
+    }
+}
+
+size_t CachedOutline::Bytes() const
+{
+    return sizeof(GlyphCacheKey) + sizeof(CachedOutline) + commands.size() + points.size() * sizeof(int32_t);
+}
+
+int FillOutlines(FT_Face face, const std::vector<FT_UInt> &glyph_indices, FT_Int32 load_flags)
+{
+    outline_glyphs.clear();
+    outline_commands.clear();
+    outline_points.clear();
+
+    // Only the outline is needed, embedded bitmaps would replace it
+    load_flags = (load_flags | FT_LOAD_NO_BITMAP) & ~FT_LOAD_RENDER;
+    for (FT_UInt glyph_index : glyph_indices)
+    {
+        const GlyphCacheKey key = {face, face->size->metrics.x_scale, face->size->metrics.y_scale, load_flags, glyph_index, 0};
+        const CachedOutline *cached = outline_cache.Find(key);
+        if (cached != nullptr)
+        {
+            AppendOutline(glyph_index, *cached);
+            continue;
+        }
+        auto outline = DecomposeGlyph(face, glyph_index, load_flags);
+        AppendOutline(glyph_index, *outline);
+        const size_t bytes = outline->Bytes();
+        outline_cache.Insert(key, std::move(outline), bytes);
+    }
+    return glyph_indices.size();
+}
+
+void SetOutlineCacheBudget(size_t bytes)
+{
+    outline_cache.SetBudget(bytes);
+}
+
+LruCacheStats GetOutlineCacheStats()
+{
+    return outline_cache.Stats();
+}
+
+void ResetOutlineCacheStats()
+{
+    outline_cache.ResetStats();
+}
+
+void ClearOutlineCache()
+{
+    outline_cache.Clear();
+}
+
+void ReleaseOutlines(FT_Face face)
+{
+    outline_cache.EraseIf([face](const GlyphCacheKey &key)
+                          { return key.face == face; });
+}
+
+void CleanupOutlines()
+{
+    outline_cache.Clear();
+    outline_glyphs.clear();
+    outline_glyphs.shrink_to_fit();
+    outline_commands.clear();
+    outline_commands.shrink_to_fit();
+    outline_points.clear();
+    outline_points.shrink_to_fit();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <freetype/freetype.h>
+
+#include "glyph_cache.h"
+#include "lru_cache.h"
+
+// Glyph outlines
+//
+// Outlines are decomposed to path commands with their points, so glyphs can
+// be drawn as vectors with Path2D or on the GPU at any scale. Points are x, y
+// pairs in 26.6 pixels, or in font units with FT_LOAD_NO_SCALE. The y axis
+// points up as in FreeType.
+
+enum OutlineCommand
+{
+    // One point
+    OUTLINE_MOVE = 0,
+    OUTLINE_LINE = 1,
+    // Control point and end point
+    OUTLINE_CONIC = 2,
+    // Two control points and end point
+    OUTLINE_CUBIC = 3,
+    // Closes the contour, no points
+    OUTLINE_CLOSE = 4,
+};
+
+// Glyph rows: glyph index, first command, command count, first point, point
+// count and x advance
+const int OUTLINE_GLYPH_SIZE = 6;
+
+// Decomposed outline of a glyph, cached per face, size, load flags and glyph
+// index
+struct CachedOutline
+{
+    std::vector<uint8_t> commands;
+    std::vector<int32_t> points;
+    FT_Pos advance_x;
+
+    size_t Bytes() const;
+};
+
+typedef LruCache<GlyphCacheKey, CachedOutline, GlyphCacheKeyHash> OutlineCache;
+
+// Rows of the last `FillOutlines` call, valid until the next call
+extern std::vector<int32_t> outline_glyphs;
+extern std::vector<uint8_t> outline_commands;
+extern std::vector<int32_t> outline_points;
+
+// Loads the outlines of the glyphs with the active size of the face, bitmaps
+// are not loaded or rendered. Glyphs without an outline get no commands.
+// Returns the number of glyphs.
+int FillOutlines(FT_Face face, const std::vector<FT_UInt> &glyph_indices, FT_Int32 load_flags);
+
+void SetOutlineCacheBudget(size_t bytes);
+LruCacheStats GetOutlineCacheStats();
+void ResetOutlineCacheStats();
+void ClearOutlineCache();
+
+// Drops the cached outlines of the face before it's closed
+void ReleaseOutlines(FT_Face face);
+void CleanupOutlines();
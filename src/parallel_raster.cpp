@@ -0,0 +1,120 @@
+#include <stdio.h>
+
+#include <algorithm>
+
+#include <freetype/ftmm.h>
+
+#include "parallel_raster.h"
+
+FT_Error ApplySizeRequest(FT_Face face, const SizeRequest &request)
+{
+    if (std::get<0>(request) == 0)
+    {
+        return FT_Set_Pixel_Sizes(face, std::get<1>(request), std::get<2>(request));
+    }
+    return FT_Set_Char_Size(face, std::get<1>(request), std::get<2>(request), std::get<3>(request), std::get<4>(request));
+}
+
+ParallelRasterizer::ParallelRasterizer(size_t num_workers)
+    : pool(num_workers)
+{
+    workers.resize(pool.Size());
+    for (auto &worker : workers)
+    {
+        FT_Init_FreeType(&worker.library);
+    }
+}
+
+ParallelRasterizer::~ParallelRasterizer()
+{
+    for (auto &worker : workers)
+    {
+        FT_Done_FreeType(worker.library);
+    }
+}
+
+std::vector<std::unique_ptr<CachedGlyph>> ParallelRasterizer::LoadGlyphs(const FaceSource &source, const SizeRequest &size,
+                                                                         const std::vector<FT_UInt> &glyph_indices,
+                                                                         FT_Int32 load_flags, size_t chunk_size)
+{
+    CloseUnusedFaces();
+
+    std::vector<std::unique_ptr<CachedGlyph>> glyphs(glyph_indices.size());
+    const size_t num_chunks = (glyph_indices.size() + chunk_size - 1) / chunk_size;
+    pool.Run(num_chunks, [&](size_t worker_index, size_t chunk)
+             {
+        Worker &worker = workers[worker_index];
+        FT_Face face = GetFace(worker, source, size);
+        if (face == NULL)
+        {
+            return;
+        }
+
+        const size_t end = std::min(glyph_indices.size(), (chunk + 1) * chunk_size);
+        for (size_t i = chunk * chunk_size; i < end; i++)
+        {
+            if (FT_Load_Glyph(face, glyph_indices[i], load_flags) == 0)
+            {
+                glyphs[i] = std::make_unique<CachedGlyph>(*face->glyph);
+            }
+        } });
+    return glyphs;
+}
+
+FT_Face ParallelRasterizer::GetFace(Worker &worker, const FaceSource &source, const SizeRequest &size)
+{
+    auto key = std::make_tuple(source.owner.get(), source.face_index, source.coords);
+    auto it = worker.faces.find(key);
+    if (it == worker.faces.end())
+    {
+        FT_Face face;
+        FT_Error error = FT_New_Memory_Face(worker.library, source.bytes, source.size, source.face_index, &face);
+        if (error)
+        {
+            fprintf(stderr, "FreeType: FT_New_Memory_Face (face index %ld) failed in a worker.\n", source.face_index);
+            return NULL;
+        }
+        if (!source.coords.empty() &&
+            FT_Set_Var_Design_Coordinates(face, source.coords.size(), (FT_Fixed *)source.coords.data()))
+        {
+            fprintf(stderr, "FreeType: Error setting variation coordinates in a worker.\n");
+            FT_Done_Face(face);
+            return NULL;
+        }
+        it = worker.faces.insert({key, {source.owner, face, size, false}}).first;
+    }
+
+    WorkerFace &entry = it->second;
+    if (!entry.has_size || entry.size != size)
+    {
+        FT_Error error = ApplySizeRequest(entry.face, size);
+        if (error)
+        {
+            fprintf(stderr, "FreeType: Error setting size in a worker.\n");
+            entry.has_size = false;
+            return NULL;
+        }
+        entry.size = size;
+        entry.has_size = true;
+    }
+    return entry.face;
+}
+
+void ParallelRasterizer::CloseUnusedFaces()
+{
+    for (auto &worker : workers)
+    {
+        for (auto it = worker.faces.begin(); it != worker.faces.end();)
+        {
+            if (it->second.owner.expired())
+            {
+                FT_Done_Face(it->second.face);
+                it = worker.faces.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+}
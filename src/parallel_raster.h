@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <map>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <freetype/freetype.h>
+
+#include "glyph_cache.h"
+#include "worker_pool.h"
+
+// Pixel (0) or char (1) size request: kind, width, height, horizontal and
+// vertical resolution
+typedef std::tuple<int, FT_F26Dot6, FT_F26Dot6, FT_UInt, FT_UInt> SizeRequest;
+
+FT_Error ApplySizeRequest(FT_Face face, const SizeRequest &request);
+
+// Face in font bytes that outlive the owner
+struct FaceSource
+{
+    std::shared_ptr<const void> owner;
+    FT_Bytes bytes;
+    FT_Long size;
+    FT_Long face_index;
+    // Design coordinates of a variation instance, empty for the face
+    std::vector<FT_Fixed> coords;
+};
+
+// Loads glyphs on a worker pool. FreeType objects are not shared between
+// threads, so each worker has its own FT_Library and opens its own faces
+// over the shared font bytes.
+class ParallelRasterizer
+{
+public:
+    explicit ParallelRasterizer(size_t num_workers);
+    ~ParallelRasterizer();
+
+    size_t Size() const { return pool.Size(); }
+
+    // Loads the glyphs with the size, the glyphs are split to tasks of
+    // `chunk_size` glyphs. Glyphs that fail to load are null.
+    std::vector<std::unique_ptr<CachedGlyph>> LoadGlyphs(const FaceSource &source, const SizeRequest &size,
+                                                         const std::vector<FT_UInt> &glyph_indices,
+                                                         FT_Int32 load_flags, size_t chunk_size = 32);
+
+private:
+    struct WorkerFace
+    {
+        std::weak_ptr<const void> owner;
+        FT_Face face;
+        SizeRequest size;
+        bool has_size;
+    };
+
+    struct Worker
+    {
+        FT_Library library;
+        std::map<std::tuple<const void *, FT_Long, std::vector<FT_Fixed>>, WorkerFace> faces;
+    };
+
+    FT_Face GetFace(Worker &worker, const FaceSource &source, const SizeRequest &size);
+
+    // Closes the faces of fonts that are freed
+    void CloseUnusedFaces();
+
+    // Workers are destroyed after the pool has stopped
+    std::vector<Worker> workers;
+    WorkerPool pool;
+};
@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <freetype/freetype.h>
+#include <freetype/ftbitmap.h>
+#include <freetype/ftmodapi.h>
+
+#include "core.h"
+#include "sdf.h"
+
+std::vector<int32_t> sdf_glyphs;
+std::vector<uint8_t> sdf_pixels;
+
+namespace
+{
+    // Sets the spread of both SDF renderers for the scope. The spread is a
+    // library property, the one before is restored so the SDF glyphs of
+    // `use_sdf` keep theirs.
+    class SpreadScope
+    {
+    public:
+        explicit SpreadScope(FT_Library library) : library(library)
+        {
+            FT_Property_Get(library, "sdf", "spread", &sdf_spread);
+            FT_Property_Get(library, "bsdf", "spread", &bsdf_spread);
+        }
+
+        ~SpreadScope()
+        {
+            FT_Property_Set(library, "sdf", "spread", &sdf_spread);
+            FT_Property_Set(library, "bsdf", "spread", &bsdf_spread);
+        }
+
+        FT_Error Set(FT_Int spread)
+        {
+            FT_Error error = FT_Property_Set(library, "sdf", "spread", &spread);
+            if (!error)
+            {
+                error = FT_Property_Set(library, "bsdf", "spread", &spread);
+            }
+            return error;
+        }
+
+    private:
+        FT_Library library;
+        FT_Int sdf_spread = 8;
+        FT_Int bsdf_spread = 8;
+    };
+
+    // Estimated work of each renderer for the loaded outline. The outline
+    // renderer checks the pixels within the spread of every segment, the
+    // bitmap renderer rasterizes and then sweeps the padded bitmap.
+    struct SdfCost
+    {
+        double outline;
+        double bitmap;
+    };
+
+    SdfCost EstimateCost(const FT_GlyphSlotRec *slot, int spread)
+    {
+        const double band = (2.0 * spread + 1) * (2.0 * spread + 1);
+        const double area = (slot->metrics.width / 64.0 + 2 * spread) * (slot->metrics.height / 64.0 + 2 * spread);
+        return {slot->outline.n_points * band + area, area};
+    }
+
+    // Loads the glyph without rendering
+    FT_Error LoadSdfGlyph(FT_Face face, FT_UInt glyph_index, FT_Int32 load_flags)
+    {
+        FT_STATS_ADD(glyph_loads, 1);
+        return FT_Load_Glyph(face, glyph_index, load_flags & ~FT_LOAD_RENDER);
+    }
+
+    // Renders the loaded glyph to a field, bitmap glyphs always use the
+    // bitmap renderer
+    FT_Error RenderSdfSlot(FT_GlyphSlot slot, int renderer)
+    {
+        FT_STATS_ADD(glyph_renders, 1);
+        FT_STATS_TIMER(glyph_render_ms);
+        if (renderer == SDF_RENDERER_BITMAP && slot->format == FT_GLYPH_FORMAT_OUTLINE && slot->outline.n_points > 0)
+        {
+            FT_Error error = FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL);
+            if (error)
+            {
+                return error;
+            }
+        }
+        if (slot->format == FT_GLYPH_FORMAT_BITMAP)
+        {
+            // Empty glyphs have no field, the bitmap renderer rejects them
+            if (slot->bitmap.rows == 0 || slot->bitmap.width == 0)
+            {
+                return 0;
+            }
+            // The bitmap renderer replaces the buffer, so the slot must own
+            // it, loaded bitmaps point into the font
+            FT_Error error = FT_GlyphSlot_Own_Bitmap(slot);
+            if (error)
+            {
+                return error;
+            }
+        }
+        return FT_Render_Glyph(slot, FT_RENDER_MODE_SDF);
+    }
+
+    // Appends the row and copies the field rows straight to `sdf_pixels`
+    void AppendSdfGlyph(FT_ULong charcode, const FT_GlyphSlotRec *slot, int renderer)
+    {
+        const FT_Bitmap &bitmap = slot->bitmap;
+        const size_t offset = sdf_pixels.size();
+        sdf_pixels.resize(offset + (size_t)bitmap.rows * bitmap.width);
+        for (unsigned int y = 0; y < bitmap.rows; y++)
+        {
+            // Negative pitch means the bottom row is first in the buffer
+            const int src_row = bitmap.pitch >= 0 ? y : bitmap.rows - 1 - y;
+            memcpy(sdf_pixels.data() + offset + (size_t)y * bitmap.width, bitmap.buffer + src_row * abs(bitmap.pitch), bitmap.width);
+        }
+
+        const int32_t row[SDF_GLYPH_SIZE] = {(int32_t)charcode, (int32_t)slot->glyph_index, renderer, (int32_t)bitmap.width,
+                                             (int32_t)bitmap.rows, slot->bitmap_left, slot->bitmap_top, (int32_t)slot->advance.x,
+                                             (int32_t)offset};
+        sdf_glyphs.insert(sdf_glyphs.end(), row, row + SDF_GLYPH_SIZE);
+    }
+}
+
+SdfBatchInfo RenderSdfBatch(FT_Face face, const std::vector<FT_ULong> &charcodes, int spread, int renderer, FT_Int32 load_flags)
+{
+    sdf_glyphs.clear();
+    sdf_pixels.clear();
+    SdfBatchInfo info = {0, 0, 0, 0};
+    const double start = NowMs();
+
+    SpreadScope spread_scope(face->glyph->library);
+    if (spread_scope.Set(spread) != 0)
+    {
+        fprintf(stderr, "FreeType: SDF spread must be between 2 and 32.\n");
+        info.glyph_count = -1;
+        return info;
+    }
+    MemoryTagScope memory_tag(FaceMemoryTag(face));
+
+    // Milliseconds per cost unit of each renderer, measured on the first
+    // outline glyphs of the auto renderer
+    double outline_ms = 0, outline_units = 0;
+    double bitmap_ms = 0, bitmap_units = 0;
+    int calibrated = 0;
+
+    for (FT_ULong charcode : charcodes)
+    {
+        const FT_UInt glyph_index = FT_Get_Char_Index(face, charcode);
+        if (glyph_index == 0 || LoadSdfGlyph(face, glyph_index, load_flags) != 0)
+        {
+            continue;
+        }
+
+        FT_GlyphSlot slot = face->glyph;
+        int glyph_renderer = renderer;
+        if (slot->format != FT_GLYPH_FORMAT_OUTLINE)
+        {
+            glyph_renderer = SDF_RENDERER_BITMAP;
+        }
+        else if (renderer == SDF_RENDERER_AUTO && calibrated < SDF_CALIBRATION_GLYPHS && slot->outline.n_points > 0)
+        {
+            // Renders the glyph both ways, the faster field is kept
+            const SdfCost cost = EstimateCost(slot, spread);
+            const double bitmap_start = NowMs();
+            if (RenderSdfSlot(slot, SDF_RENDERER_BITMAP) != 0)
+            {
+                continue;
+            }
+            const double bitmap_glyph_ms = NowMs() - bitmap_start;
+            const size_t sdf_glyph_count = sdf_glyphs.size();
+            AppendSdfGlyph(charcode, slot, SDF_RENDERER_BITMAP);
+
+            FT_Error error = LoadSdfGlyph(face, glyph_index, load_flags);
+            const double outline_start = NowMs();
+            if (!error)
+            {
+                error = RenderSdfSlot(slot, SDF_RENDERER_OUTLINE);
+            }
+            const double outline_glyph_ms = NowMs() - outline_start;
+            if (error)
+            {
+                info.bitmap_glyphs++;
+                info.glyph_count++;
+                continue;
+            }
+
+            calibrated++;
+            outline_ms += outline_glyph_ms;
+            outline_units += cost.outline;
+            bitmap_ms += bitmap_glyph_ms;
+            bitmap_units += cost.bitmap;
+            if (outline_glyph_ms < bitmap_glyph_ms)
+            {
+                // Replaces the bitmap field, it's the last one
+                sdf_pixels.resize(sdf_glyphs[sdf_glyph_count + SDF_GLYPH_SIZE - 1]);
+                sdf_glyphs.resize(sdf_glyph_count);
+                AppendSdfGlyph(charcode, slot, SDF_RENDERER_OUTLINE);
+                info.outline_glyphs++;
+            }
+            else
+            {
+                info.bitmap_glyphs++;
+            }
+            info.glyph_count++;
+            continue;
+        }
+        else if (renderer == SDF_RENDERER_AUTO)
+        {
+            const SdfCost cost = EstimateCost(slot, spread);
+            const double outline_estimate = outline_units > 0 ? cost.outline * outline_ms / outline_units : 0;
+            const double bitmap_estimate = bitmap_units > 0 ? cost.bitmap * bitmap_ms / bitmap_units : 0;
+            glyph_renderer = bitmap_estimate < outline_estimate ? SDF_RENDERER_BITMAP : SDF_RENDERER_OUTLINE;
+        }
+
+        if (RenderSdfSlot(slot, glyph_renderer) != 0)
+        {
+            continue;
+        }
+        AppendSdfGlyph(charcode, slot, glyph_renderer);
+        if (glyph_renderer == SDF_RENDERER_BITMAP)
+        {
+            info.bitmap_glyphs++;
+        }
+        else
+        {
+            info.outline_glyphs++;
+        }
+        info.glyph_count++;
+    }
+
+    info.ms = NowMs() - start;
+    return info;
+}
+
+SdfBatchInfo RenderSdfBatchWithFace(int face_handle, const std::vector<FT_ULong> &charcodes, FT_UInt pixel_size, int spread,
+                                    int renderer, FT_Int32 load_flags)
+{
+    sdf_glyphs.clear();
+    sdf_pixels.clear();
+    Font *font = GetFontByHandle(face_handle);
+    FT_Face face = font == nullptr ? nullptr : font->Open();
+    if (face == nullptr)
+    {
+        return {-1, 0, 0, 0};
+    }
+
+    // A size of its own for the batch, so no size handle is left behind
+    MemoryTagScope memory_tag(font->handle);
+    FT_Size size;
+    if (FT_New_Size(face, &size))
+    {
+        fprintf(stderr, "FreeType: Unable to create size.\n");
+        return {-1, 0, 0, 0};
+    }
+    SdfBatchInfo info = {-1, 0, 0, 0};
+    {
+        ScopedSize scoped_size(size);
+        if (FT_Set_Pixel_Sizes(face, 0, pixel_size))
+        {
+            fprintf(stderr, "FreeType: Error setting size.\n");
+        }
+        else
+        {
+            info = RenderSdfBatch(face, charcodes, spread, renderer, load_flags);
+        }
+    }
+    FT_Done_Size(size);
+    return info;
+}
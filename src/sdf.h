@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <freetype/freetype.h>
+
+// Signed distance field batches
+//
+// Glyphs are rendered once at a canonical pixel size, the fields scale to
+// any display size: multiply the lengths by display size / canonical size,
+// the spread scales the same way. FreeType has two SDF renderers, "sdf"
+// computes the distances from the outline and "bsdf" from a rendered
+// bitmap. The outline renderer is more exact, its cost grows with the
+// number of outline points, the bitmap one with the glyph area.
+
+enum SdfRenderer
+{
+    // Picks the renderer per glyph from the measured speed of both
+    SDF_RENDERER_AUTO = 0,
+    SDF_RENDERER_OUTLINE = 1,
+    SDF_RENDERER_BITMAP = 2,
+};
+
+// Glyph rows: charcode, glyph index, renderer, bitmap width, bitmap rows,
+// bitmap left, bitmap top, x advance in 26.6 pixels and the offset of the
+// pixels. Rows of pixels are `width` bytes, 128 is the glyph edge.
+const int SDF_GLYPH_SIZE = 9;
+
+// Glyphs of the auto renderer that are rendered both ways to measure them
+const int SDF_CALIBRATION_GLYPHS = 8;
+
+struct SdfBatchInfo
+{
+    int glyph_count;
+    int outline_glyphs;
+    int bitmap_glyphs;
+    double ms;
+};
+
+// Rows and pixels of the last `RenderSdfBatch` call
+extern std::vector<int32_t> sdf_glyphs;
+extern std::vector<uint8_t> sdf_pixels;
+
+// Renders the fields of the charcodes with the active size of the face,
+// characters the face doesn't have are left out. `spread` is the distance in
+// pixels covered by the field, 2 to 32. Returns a glyph count of -1 if the
+// spread is out of range.
+SdfBatchInfo RenderSdfBatch(FT_Face face, const std::vector<FT_ULong> &charcodes, int spread, int renderer, FT_Int32 load_flags);
+
+// Renders the batch at the canonical pixel size of the face
+SdfBatchInfo RenderSdfBatchWithFace(int face_handle, const std::vector<FT_ULong> &charcodes, FT_UInt pixel_size, int spread,
+                                    int renderer, FT_Int32 load_flags);
@@ -0,0 +1,250 @@
+#include <stdio.h>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include <freetype/freetype.h>
+#include <freetype/ftmm.h>
+
+#if FT_WASM_HARFBUZZ
+#include <hb.h>
+#endif
+
+#include "shaper.h"
+
+namespace
+{
+    ShapedRunCache shape_cache(1 << 20);
+    const std::vector<int32_t> empty_run;
+    // Rows of the last run when it's not cached
+    std::vector<int32_t> uncached_run;
+
+#if FT_WASM_HARFBUZZ
+    std::unordered_map<FT_Face, hb_face_t *> hb_faces;
+
+    // HarfBuzz reads the tables in place from the sfnt bytes the face was
+    // opened from with FT_New_Memory_Face, they outlive the HarfBuzz face as
+    // it's released before the face is closed
+    hb_face_t *GetHbFace(FT_Face face)
+    {
+        auto found = hb_faces.find(face);
+        if (found != hb_faces.end())
+        {
+            return found->second;
+        }
+        if (face->stream == NULL || face->stream->base == NULL)
+        {
+            fprintf(stderr, "FreeType: Shaping needs a face opened from memory.\n");
+            return nullptr;
+        }
+        hb_blob_t *blob = hb_blob_create((const char *)face->stream->base, face->stream->size, HB_MEMORY_MODE_READONLY,
+                                         nullptr, nullptr);
+        hb_face_t *hb_face = hb_face_create(blob, face->face_index & 0xffff);
+        hb_blob_destroy(blob);
+        hb_faces[face] = hb_face;
+        return hb_face;
+    }
+
+    // Normalized coordinates of a variation instance, HarfBuzz takes them in
+    // 2.14 where FreeType has 16.16, as in hb-ft
+    void SetVarCoords(hb_font_t *font, FT_Face face)
+    {
+        FT_MM_Var *mm_var = NULL;
+        if (!FT_HAS_MULTIPLE_MASTERS(face) || FT_Get_MM_Var(face, &mm_var))
+        {
+            return;
+        }
+        std::vector<FT_Fixed> blend(mm_var->num_axis);
+        if (!FT_Get_Var_Blend_Coordinates(face, blend.size(), blend.data()))
+        {
+            std::vector<int> coords(blend.size());
+            for (size_t i = 0; i < blend.size(); i++)
+            {
+                coords[i] = (int)(blend[i] >> 2);
+            }
+            hb_font_set_var_coords_normalized(font, coords.data(), coords.size());
+        }
+        FT_Done_MM_Var(face->glyph->library, mm_var);
+    }
+
+    // HarfBuzz scale of the size in 26.6 pixels, the same as hb-ft
+    int HbScale(FT_Fixed scale, FT_UShort units_per_em)
+    {
+        return (int)(((uint64_t)scale * units_per_em + (1 << 15)) >> 16);
+    }
+
+    bool ParseFeatures(const std::string &features, std::vector<hb_feature_t> &parsed)
+    {
+        size_t start = 0;
+        while (start < features.size())
+        {
+            size_t end = features.find(',', start);
+            if (end == std::string::npos)
+            {
+                end = features.size();
+            }
+            if (end > start)
+            {
+                hb_feature_t feature;
+                if (!hb_feature_from_string(features.data() + start, end - start, &feature))
+                {
+                    fprintf(stderr, "FreeType: Invalid feature '%s'.\n", features.substr(start, end - start).c_str());
+                    return false;
+                }
+                parsed.push_back(feature);
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+
+    bool Shape(FT_Face face, const std::u16string &text, const std::string &features, std::vector<int32_t> &rows)
+    {
+        std::vector<hb_feature_t> parsed;
+        if (!ParseFeatures(features, parsed))
+        {
+            return false;
+        }
+
+        hb_face_t *hb_face = GetHbFace(face);
+        if (hb_face == nullptr)
+        {
+            return false;
+        }
+        hb_font_t *font = hb_font_create(hb_face);
+        const FT_Size_Metrics &metrics = face->size->metrics;
+        hb_font_set_scale(font, HbScale(metrics.x_scale, face->units_per_EM), HbScale(metrics.y_scale, face->units_per_EM));
+        hb_font_set_ppem(font, metrics.x_ppem, metrics.y_ppem);
+        SetVarCoords(font, face);
+
+        hb_buffer_t *buffer = hb_buffer_create();
+        hb_buffer_add_utf16(buffer, (const uint16_t *)text.data(), text.size(), 0, text.size());
+        hb_buffer_guess_segment_properties(buffer);
+        hb_shape(font, buffer, parsed.data(), parsed.size());
+
+        unsigned int count = 0;
+        const hb_glyph_info_t *infos = hb_buffer_get_glyph_infos(buffer, &count);
+        const hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(buffer, nullptr);
+        rows.resize(count * SHAPED_GLYPH_SIZE);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            int32_t *row = rows.data() + i * SHAPED_GLYPH_SIZE;
+            row[0] = infos[i].codepoint;
+            row[1] = infos[i].cluster;
+            row[2] = positions[i].x_advance;
+            row[3] = positions[i].y_advance;
+            row[4] = positions[i].x_offset;
+            row[5] = positions[i].y_offset;
+        }
+
+        hb_buffer_destroy(buffer);
+        hb_font_destroy(font);
+        return true;
+    }
+#endif
+}
+
+const std::vector<int32_t> *shaped_glyphs = &empty_run;
+
+size_t ShapedRunKeyHash::operator()(const ShapedRunKey &key) const
+{
+    size_t h = (size_t)key.face;
+    h = h * 31 + key.x_scale;
+    h = h * 31 + key.y_scale;
+    h = h * 31 + std::hash<std::string>()(key.features);
+    h = h * 31 + std::hash<std::u16string>()(key.text);
+    return h;
+}
+
+int ShapeRun(FT_Face face, const std::u16string &text, const std::string &features)
+{
+    shaped_glyphs = &empty_run;
+#if FT_WASM_HARFBUZZ
+    if (!FT_IS_SFNT(face))
+    {
+        fprintf(stderr, "FreeType: Shaping needs an OpenType font.\n");
+        return -1;
+    }
+
+    ShapedRunKey key = {face, face->size->metrics.x_scale, face->size->metrics.y_scale, features, text};
+    const ShapedRun *cached = shape_cache.Find(key);
+    if (cached == nullptr)
+    {
+        auto run = std::make_unique<ShapedRun>();
+        if (!Shape(face, text, features, run->glyphs))
+        {
+            return -1;
+        }
+        const size_t bytes = sizeof(ShapedRunKey) + sizeof(ShapedRun) + text.size() * sizeof(char16_t) +
+                             features.size() + run->glyphs.size() * sizeof(int32_t);
+        if (bytes > shape_cache.Stats().budget)
+        {
+            uncached_run = std::move(run->glyphs);
+            shaped_glyphs = &uncached_run;
+            return uncached_run.size() / SHAPED_GLYPH_SIZE;
+        }
+        cached = shape_cache.Insert(key, std::move(run), bytes);
+    }
+    shaped_glyphs = &cached->glyphs;
+    return shaped_glyphs->size() / SHAPED_GLYPH_SIZE;
+#else
+    (void)face;
+    (void)text;
+    (void)features;
+    fprintf(stderr, "FreeType: Shaping needs a build with HARFBUZZ=1.\n");
+    return -1;
+#endif
+}
+
+void SetShapeCacheBudget(size_t bytes)
+{
+    // The last run may be evicted by the smaller budget
+    shaped_glyphs = &empty_run;
+    shape_cache.SetBudget(bytes);
+}
+
+LruCacheStats GetShapeCacheStats()
+{
+    return shape_cache.Stats();
+}
+
+void ResetShapeCacheStats()
+{
+    shape_cache.ResetStats();
+}
+
+void ClearShapeCache()
+{
+    shaped_glyphs = &empty_run;
+    shape_cache.Clear();
+}
+
+void ReleaseShaperFace(FT_Face face)
+{
+    shaped_glyphs = &empty_run;
+    shape_cache.EraseIf([face](const ShapedRunKey &key)
+                        { return key.face == face; });
+#if FT_WASM_HARFBUZZ
+    auto found = hb_faces.find(face);
+    if (found != hb_faces.end())
+    {
+        hb_face_destroy(found->second);
+        hb_faces.erase(found);
+    }
+#endif
+}
+
+void CleanupShaper()
+{
+    ClearShapeCache();
+    uncached_run.clear();
+    uncached_run.shrink_to_fit();
+#if FT_WASM_HARFBUZZ
+    for (auto &it : hb_faces)
+    {
+        hb_face_destroy(it.second);
+    }
+    hb_faces.clear();
+#endif
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <freetype/freetype.h>
+
+#include "lru_cache.h"
+
+// Text shaping with HarfBuzz, enabled with `-D FT_WASM_HARFBUZZ=1`. HarfBuzz
+// reads the font tables in place from the sfnt bytes the face was opened
+// from, the decoded buffer of WOFF and WOFF2 fonts, so no table is copied.
+// Variation instances are shaped with their coordinates. Without it
+// `ShapeRun` fails.
+#ifndef FT_WASM_HARFBUZZ
+#define FT_WASM_HARFBUZZ 0
+#endif
+
+// Shaped glyph rows: glyph index, cluster, x advance, y advance, x offset and
+// y offset. Cluster is the offset of the glyph's first character in the
+// text, positions are in 26.6 pixels.
+const int SHAPED_GLYPH_SIZE = 6;
+
+// Shaped runs are cached per face, size, features and text
+struct ShapedRunKey
+{
+    FT_Face face;
+    FT_Fixed x_scale;
+    FT_Fixed y_scale;
+    std::string features;
+    std::u16string text;
+
+    bool operator==(const ShapedRunKey &other) const
+    {
+        return face == other.face && x_scale == other.x_scale && y_scale == other.y_scale &&
+               features == other.features && text == other.text;
+    }
+};
+
+struct ShapedRunKeyHash
+{
+    size_t operator()(const ShapedRunKey &key) const;
+};
+
+struct ShapedRun
+{
+    std::vector<int32_t> glyphs;
+};
+
+typedef LruCache<ShapedRunKey, ShapedRun, ShapedRunKeyHash> ShapedRunCache;
+
+// Rows of the last `ShapeRun` call, valid until the next call
+extern const std::vector<int32_t> *shaped_glyphs;
+
+// Shapes the text with the active size of the face. `features` is a comma
+// separated list of OpenType features in the HarfBuzz syntax, e.g.
+// "liga=0,+smcp". Direction, script and language are guessed from the text.
+// Returns the number of glyphs, or -1 on errors.
+int ShapeRun(FT_Face face, const std::u16string &text, const std::string &features);
+
+void SetShapeCacheBudget(size_t bytes);
+LruCacheStats GetShapeCacheStats();
+void ResetShapeCacheStats();
+void ClearShapeCache();
+
+// Drops the cached runs and HarfBuzz face of the face before it's closed
+void ReleaseShaperFace(FT_Face face);
+void CleanupShaper();
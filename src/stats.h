@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+
+// Hot path counters and timers, enabled with `-D FT_WASM_STATS=1`. When
+// disabled the `FT_STATS_*` macros expand to nothing and `GetStats` returns
+// zeros.
+#ifndef FT_WASM_STATS
+#define FT_WASM_STATS 0
+#endif
+
+#if FT_WASM_STATS
+#include <chrono>
+#include <utility>
+#endif
+
+struct HotPathStats
+{
+    // Fonts stored, not counting loads of fonts that were already stored
+    size_t font_loads;
+    size_t font_bytes;
+    // Time of the load calls, including the WOFF decoding and face opening
+    double font_load_ms;
+
+    size_t webfont_decodes;
+    double webfont_decode_ms;
+
+    // FT_Load_Glyph calls, the time includes hinting
+    size_t glyph_loads;
+    size_t hinted_glyph_loads;
+    double glyph_load_ms;
+
+    // Rendering of the loaded outlines to bitmaps
+    size_t glyph_renders;
+    double glyph_render_ms;
+
+    // Glyphs taken from the glyph snapshot instead of loading them
+    size_t snapshot_glyphs;
+
+    // Glyphs loaded by the worker threads, and the time waited for them
+    size_t parallel_glyph_loads;
+    double parallel_load_ms;
+
+    size_t kerning_lookups;
+
+    // Bitmaps converted to another pixel format, and the converted bytes
+    size_t bitmap_conversions;
+    size_t converted_bytes;
+
+    // Calls from JS to the exported functions
+    size_t api_calls;
+};
+
+extern HotPathStats hot_path_stats;
+
+#if FT_WASM_STATS
+
+// Adds the lifetime of the timer to a `HotPathStats` field
+class StatsTimer
+{
+public:
+    explicit StatsTimer(double &total_ms) : total_ms(total_ms), start(std::chrono::steady_clock::now()) {}
+    ~StatsTimer()
+    {
+        total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    StatsTimer(const StatsTimer &) = delete;
+    StatsTimer &operator=(const StatsTimer &) = delete;
+
+private:
+    double &total_ms;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define FT_STATS_CONCAT_(a, b) a##b
+#define FT_STATS_CONCAT(a, b) FT_STATS_CONCAT_(a, b)
+
+#define FT_STATS_ADD(field, value) (hot_path_stats.field += (value))
+#define FT_STATS_TIMER(field) StatsTimer FT_STATS_CONCAT(stats_timer_, __LINE__)(hot_path_stats.field)
+
+// Wraps an exported function to count the calls
+template <typename F, F f>
+struct CountedCall;
+
+template <typename R, typename... Args, R (*f)(Args...)>
+struct CountedCall<R (*)(Args...), f>
+{
+    static R Call(Args... args)
+    {
+        hot_path_stats.api_calls++;
+        return f(std::forward<Args>(args)...);
+    }
+};
+
+#define FT_STATS_API(f) (&CountedCall<decltype(&f), &f>::Call)
+
+#else
+
+#define FT_STATS_ADD(field, value) ((void)0)
+#define FT_STATS_TIMER(field) ((void)0)
+#define FT_STATS_API(f) (&f)
+
+#endif
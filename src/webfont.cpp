@@ -0,0 +1,112 @@
+#include <string.h>
+
+#include <freetype/tttables.h>
+
+#include "webfont.h"
+
+namespace
+{
+    unsigned long ReadU32(const unsigned char *p)
+    {
+        return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16) | ((unsigned long)p[2] << 8) | p[3];
+    }
+
+    void WriteU32(unsigned char *p, unsigned long value)
+    {
+        p[0] = (unsigned char)(value >> 24);
+        p[1] = (unsigned char)(value >> 16);
+        p[2] = (unsigned char)(value >> 8);
+        p[3] = (unsigned char)value;
+    }
+
+    // Copies the decoded sfnt of the face, tag 0 loads the whole font file
+    FT_Error LoadDecodedFace(FT_Face face, std::vector<unsigned char> &out)
+    {
+        FT_ULong length = 0;
+        FT_Error error = FT_Load_Sfnt_Table(face, 0, 0, NULL, &length);
+        if (error)
+        {
+            return error;
+        }
+        out.resize(length);
+        return FT_Load_Sfnt_Table(face, 0, 0, out.data(), &length);
+    }
+}
+
+FontFormat GetFontFormat(const unsigned char *bytes, size_t size)
+{
+    if (size >= 4 && memcmp(bytes, "wOFF", 4) == 0)
+    {
+        return FONT_FORMAT_WOFF;
+    }
+    if (size >= 4 && memcmp(bytes, "wOF2", 4) == 0)
+    {
+        return FONT_FORMAT_WOFF2;
+    }
+    return FONT_FORMAT_SFNT;
+}
+
+FT_Error DecodeWebFont(FT_Library library, const unsigned char *bytes, size_t size,
+                       std::vector<unsigned char> &sfnt)
+{
+    // The first face tells the number of faces, so no face index -1 probe
+    FT_Face face;
+    FT_Error error = FT_New_Memory_Face(library, bytes, size, 0, &face);
+    if (error)
+    {
+        return error;
+    }
+    const FT_Long num_faces = face->num_faces;
+
+    if (num_faces <= 1)
+    {
+        error = LoadDecodedFace(face, sfnt);
+        FT_Done_Face(face);
+        return error;
+    }
+
+    // WOFF2 collections decode to one sfnt per face, each a full Brotli pass,
+    // they are joined to a collection with the table offsets moved to the
+    // position of each font
+    const size_t header_size = 12 + 4 * num_faces;
+    sfnt.assign(header_size, 0);
+    memcpy(sfnt.data(), "ttcf", 4);
+    WriteU32(&sfnt[4], 0x00010000);
+    WriteU32(&sfnt[8], num_faces);
+
+    std::vector<unsigned char> decoded;
+    for (FT_Long i = 0; i < num_faces; i++)
+    {
+        if (i > 0)
+        {
+            error = FT_New_Memory_Face(library, bytes, size, i, &face);
+            if (error)
+            {
+                return error;
+            }
+        }
+        error = LoadDecodedFace(face, decoded);
+        FT_Done_Face(face);
+        if (error)
+        {
+            return error;
+        }
+        if (decoded.size() < 12 || decoded.size() < 12 + 16 * (size_t)((decoded[4] << 8) | decoded[5]))
+        {
+            return FT_Err_Invalid_File_Format;
+        }
+
+        const size_t offset = (sfnt.size() + 3) & ~(size_t)3;
+        sfnt.resize(offset);
+        sfnt.insert(sfnt.end(), decoded.begin(), decoded.end());
+        WriteU32(&sfnt[12 + 4 * i], offset);
+
+        const unsigned int num_tables = (decoded[4] << 8) | decoded[5];
+        for (unsigned int t = 0; t < num_tables; t++)
+        {
+            unsigned char *record = &sfnt[offset + 12 + 16 * t];
+            WriteU32(record + 8, ReadU32(record + 8) + offset);
+        }
+    }
+    return FT_Err_Ok;
+}
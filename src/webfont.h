@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <freetype/freetype.h>
+
+enum FontFormat
+{
+    FONT_FORMAT_SFNT = 0,
+    FONT_FORMAT_WOFF = 1,
+    FONT_FORMAT_WOFF2 = 2,
+};
+
+// Format of the font file by its signature, other than WOFF is SFNT
+FontFormat GetFontFormat(const unsigned char *bytes, size_t size);
+
+// Decodes a WOFF or WOFF2 font to a raw sfnt, collections are written as a
+// TrueType collection. FreeType decompresses the font on every
+// FT_New_Memory_Face call, faces opened from the decoded font are not
+// decompressed again.
+//
+// FreeType only reconstructs the tables of the requested face, so a WOFF2
+// collection of n faces runs Brotli over the whole stream n times here. This
+// is paid once per stored font, later loads and face opens reuse the sfnt.
+FT_Error DecodeWebFont(FT_Library library, const unsigned char *bytes, size_t size,
+                       std::vector<unsigned char> &sfnt);
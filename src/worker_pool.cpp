@@ -0,0 +1,89 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(size_t num_workers)
+{
+    for (size_t i = 1; i < num_workers; i++)
+    {
+        threads.emplace_back(&WorkerPool::Loop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    start.notify_all();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void WorkerPool::Run(size_t count, const std::function<void(size_t, size_t)> &run_task)
+{
+    if (threads.empty() || count <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            run_task(0, i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &run_task;
+        task_count = count;
+        next_task = 0;
+        active = threads.size();
+        generation++;
+    }
+    start.notify_all();
+
+    Work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]
+              { return active == 0; });
+    task = nullptr;
+}
+
+void WorkerPool::Loop(size_t worker)
+{
+    size_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        start.wait(lock, [&]
+                   { return stop || generation != seen; });
+        if (stop)
+        {
+            return;
+        }
+        seen = generation;
+
+        lock.unlock();
+        Work(worker);
+        lock.lock();
+
+        if (--active == 0)
+        {
+            done.notify_one();
+        }
+    }
+}
+
+void WorkerPool::Work(size_t worker)
+{
+    while (true)
+    {
+        const size_t i = next_task.fetch_add(1);
+        if (i >= task_count)
+        {
+            return;
+        }
+        (*task)(worker, i);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads that run the tasks of one `Run` call at a time. The
+// calling thread works too, so a pool of one worker has no threads.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(size_t num_workers);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // Number of workers, including the calling thread
+    size_t Size() const { return threads.size() + 1; }
+
+    // Calls `task(worker, index)` for each index below `count` and returns
+    // when all are done. Tasks are picked in index order by whichever worker
+    // is free, `worker` is below `Size()` and the calling thread is 0.
+    void Run(size_t count, const std::function<void(size_t, size_t)> &task);
+
+private:
+    void Loop(size_t worker);
+    void Work(size_t worker);
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    bool stop = false;
+    size_t generation = 0;
+    size_t active = 0;
+
+    const std::function<void(size_t, size_t)> *task = nullptr;
+    size_t task_count = 0;
+    std::atomic<size_t> next_task{0};
+};
@@ -1,28 +1,247 @@
+// Benchmark suite over the fixture fonts in test/fonts, runs offline. Prints
+// the results as JSON to stdout, progress goes to stderr. Compare two result
+// files with test/benchmark_compare.js, see benchmark.sh.
+//
+// deno run --allow-read test/benchmark.js [--iterations n] [--warmup n] [--filter text]
 import FreetypeInit from "../dist/freetype.js";
 const Freetype = await FreetypeInit();
 
-async function createFontFromUrl(url) {
-    const font = await fetch(url);
-    const buffer = await font.arrayBuffer();
-    const face = Freetype.LoadFontFromBytes(new Uint8Array(buffer));
-    return face;
+const args = globalThis.Deno ? Deno.args : process.argv.slice(2);
+function option(name, fallback) {
+    const i = args.indexOf(`--${name}`);
+    return i >= 0 && i + 1 < args.length ? args[i + 1] : fallback;
 }
+const iterations = Number(option("iterations", 20));
+const warmup = Number(option("warmup", 3));
+const filter = option("filter", "");
 
-export async function createGoogleFont(fontName) {
-    const url = `https://fonts.googleapis.com/css?family=${fontName}`;
-    const css = await fetch(url);
-    const text = await css.text();
-    const urls = [...text.matchAll(/url\(([^\(\)]+)\)/g)].map((m) => m[1]);
-    return await createFontFromUrl(urls[0]);
+const fixtures = [
+    { file: "lato-regular.ttf", format: "ttf", pixelSize: 32 },
+    { file: "fixture-sans-cff.otf", format: "cff", pixelSize: 32 },
+    { file: "open-sans-regular.woff2", format: "woff2", pixelSize: 32 },
+    { file: "fixture-sans.ttc", format: "ttc", pixelSize: 32 },
+    { file: "fixture-bitmap.bdf", format: "bitmap", pixelSize: 16 },
+    { file: "fixture-sans-var.ttf", format: "var", pixelSize: 32 },
+];
+
+async function readFixture(file) {
+    const url = new URL(`./fonts/${file}`, import.meta.url);
+    if (globalThis.Deno) {
+        return await Deno.readFile(url);
+    }
+    const { readFile } = await import("node:fs/promises");
+    return new Uint8Array(await readFile(url));
+}
+
+function percentile(sorted, p) {
+    const i = Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1);
+    return sorted[Math.max(0, i)];
+}
+
+function summarize(samples) {
+    const sorted = [...samples].sort((a, b) => a - b);
+    const round = (v) => Math.round(v * 1000) / 1000;
+    return {
+        min: round(sorted[0]),
+        p50: round(percentile(sorted, 50)),
+        p90: round(percentile(sorted, 90)),
+        p99: round(percentile(sorted, 99)),
+        max: round(sorted[sorted.length - 1]),
+        mean: round(samples.reduce((a, b) => a + b, 0) / samples.length),
+    };
+}
+
+const results = [];
+
+// Runs `setup` untimed and `run` timed for each iteration, `run` returns the
+// number of items it processed
+function bench(fixture, name, run, setup = () => {}) {
+    const id = `${fixture.format}/${name}`;
+    if (filter && !id.includes(filter)) {
+        return;
+    }
+    const samples = [];
+    let items = 0;
+    for (let i = 0; i < warmup + iterations; i++) {
+        setup();
+        const start = performance.now();
+        items = run();
+        const ms = performance.now() - start;
+        if (i >= warmup) {
+            samples.push(ms);
+        }
+    }
+    const summary = summarize(samples);
+    results.push({ id, font: fixture.file, format: fixture.format, case: name, items, ...summary });
+    console.error(`${id.padEnd(20)} p50 ${summary.p50.toFixed(3)} ms, p90 ${summary.p90.toFixed(3)} ms (${items} items)`);
+}
+
+function unload(faces) {
+    for (const family of new Set(faces.map((face) => face.family_name))) {
+        Freetype.UnloadFont(family);
+    }
+}
+
+for (const fixture of fixtures) {
+    const bytes = await readFixture(fixture.file);
+
+    // Load and unload are timed apart, the font is not shared between loads
+    let loaded = [];
+    bench(
+        fixture,
+        "load",
+        () => (loaded = Freetype.LoadFontFromBytes(bytes)).length,
+        () => unload(loaded)
+    );
+    unload(loaded);
+    bench(
+        fixture,
+        "unload",
+        () => {
+            unload(loaded);
+            return loaded.length;
+        },
+        () => (loaded = Freetype.LoadFontFromBytes(bytes))
+    );
+
+    const faces = Freetype.LoadFontFromBytes(bytes);
+    const face = Freetype.GetFaceHandle(faces[0].family_name, faces[0].style_name);
+    Freetype.SetFaceCharmap(face, Freetype.FT_ENCODING_UNICODE);
+    const size = Freetype.CreatePixelSize(face, 0, fixture.pixelSize);
+    const clear = () => {
+        Freetype.ClearGlyphCache();
+        Freetype.ClearGlyphBuffer();
+    };
+
+    // Charmap scan loads the outlines without rendering
+    const scan = () => Freetype.LoadGlyphsFromCharmapWithSize(size, 0, 0x10ffff, Freetype.FT_LOAD_DEFAULT, false);
+    const charcodes = [...scan().keys()];
+    bench(fixture, "charmap", () => scan().size, clear);
+
+    const render = (flags, sdf) => () => Freetype.LoadGlyphViewsWithSize(size, charcodes, flags, sdf).size;
+    bench(fixture, "mono", render(Freetype.FT_LOAD_RENDER | Freetype.FT_LOAD_TARGET_MONO, false), clear);
+    bench(fixture, "gray", render(Freetype.FT_LOAD_RENDER, false), clear);
+    bench(fixture, "gray-cached", render(Freetype.FT_LOAD_RENDER, false));
+    bench(fixture, "sdf", render(Freetype.FT_LOAD_RENDER, true), clear);
+
+    // SDF batches with each renderer, the auto renderer picks per glyph
+    for (const [name, renderer] of [
+        ["sdf-outline", Freetype.SDF_RENDERER_OUTLINE],
+        ["sdf-bitmap", Freetype.SDF_RENDERER_BITMAP],
+        ["sdf-auto", Freetype.SDF_RENDERER_AUTO],
+    ]) {
+        bench(fixture, name, () => Freetype.RenderSdf(face, charcodes, fixture.pixelSize, 8, renderer, Freetype.FT_LOAD_NO_HINTING).glyph_count);
+    }
+
+    // Cold start from a snapshot of the gray glyphs, nothing is rendered
+    clear();
+    render(Freetype.FT_LOAD_RENDER, false)();
+    const snapshot = Freetype.ExportGlyphSnapshot().slice();
+    bench(fixture, "gray-snapshot", render(Freetype.FT_LOAD_RENDER, false), () => {
+        Freetype.ClearGlyphBuffer();
+        Freetype.ImportGlyphSnapshot(snapshot);
+    });
+    Freetype.ClearGlyphSnapshot();
+
+    // Subpixel positioning renders each glyph once per bin, the cache grows
+    // about linearly with the bin count
+    for (const bins of [1, 4]) {
+        const flags = Freetype.FT_LOAD_RENDER | Freetype.FT_LOAD_TARGET_LIGHT;
+        const name = `subpixel-${bins}`;
+        bench(fixture, name, () => Freetype.LoadSubpixelGlyphViewsWithSize(size, charcodes, bins, flags).size, clear);
+        if (!filter || `${fixture.format}/${name}`.includes(filter)) {
+            console.error(`${"".padEnd(20)} glyph cache ${Freetype.GetGlyphCacheStats().bytes} bytes`);
+        }
+    }
+
+    // Outlines instead of bitmaps, at any scale
+    const allIndices = [...scan().values()].map((glyph) => glyph.glyph_index);
+    bench(fixture, "outline", () => Freetype.LoadOutlinesWithSize(size, allIndices, 0), () => Freetype.ClearOutlineCache());
+    bench(fixture, "outline-cached", () => Freetype.LoadOutlinesWithSize(size, allIndices, 0));
+
+    // Kerning of every pair of the first 128 glyphs
+    clear();
+    const views = Freetype.LoadGlyphViewsWithSize(size, charcodes, Freetype.FT_LOAD_RENDER, false);
+    const glyphIndices = [...views.values()].slice(0, 128).map((view) => view.glyph_index);
+    bench(fixture, "kerning", () => {
+        for (const left of glyphIndices) {
+            for (const right of glyphIndices) {
+                Freetype.GetKerningWithSize(size, left, right, 0);
+            }
+        }
+        return glyphIndices.length * glyphIndices.length;
+    });
+
+    bench(fixture, "kerning-pairs", () => {
+        Freetype.GetKerningPairsWithSize(size, glyphIndices, 0);
+        return glyphIndices.length * glyphIndices.length;
+    });
+
+    bench(fixture, "convert", () => {
+        let count = 0;
+        for (const view of views.values()) {
+            if (Freetype.ConvertGlyphBitmap(view.bitmap, Freetype.BITMAP_FORMAT_RGBA, 0xffffff) !== null) {
+                count++;
+            }
+        }
+        return count;
+    });
+
+    // Layout of 10000 words of the font's characters, wrapped to 600 pixels
+    let text = "";
+    for (let i = 0; i < 10000; i++) {
+        for (let j = 0; j < 5; j++) {
+            text += String.fromCodePoint(charcodes[(i * 5 + j) % charcodes.length]);
+        }
+        text += " ";
+    }
+    bench(fixture, "layout", () => Freetype.LayoutText(size, text, 600 * 64, Freetype.TEXT_LAYOUT_KERNING).glyph_count);
+
+    // A label of the first words rendered into one buffer
+    const label = text.slice(0, 60);
+    bench(fixture, "render-text", () => Freetype.RenderText(size, label, 600, 2 * fixture.pixelSize, 0, Freetype.BITMAP_FORMAT_ALPHA, 0).length);
+
+    // Fallback of the same text, coverage table lookups only
+    bench(fixture, "fallback", () => Freetype.ResolveFallback([face], text));
+
+    // The first axis animated over 60 frames of the label, each frame renders
+    // the label with the instance at its coordinate. Cold frames create the
+    // instances, cached frames switch between them.
+    if (faces[0].face_flags & Freetype.FT_FACE_FLAG_MULTIPLE_MASTERS) {
+        const axis = Freetype.GetVariationInfo(face).axes[0];
+        const animate = () => {
+            const frames = 60;
+            for (let frame = 0; frame < frames; frame++) {
+                const coord = axis.minimum + ((axis.maximum - axis.minimum) * frame) / (frames - 1);
+                const instance = Freetype.GetVariationInstance(face, [coord]);
+                const instanceSize = Freetype.CreatePixelSize(instance, 0, fixture.pixelSize);
+                Freetype.RenderText(instanceSize, label, 600, 2 * fixture.pixelSize, 0, Freetype.BITMAP_FORMAT_ALPHA, 0);
+            }
+            return frames;
+        };
+        bench(fixture, "animate-axis", animate, () => Freetype.ClearVariationInstances(face));
+        bench(fixture, "animate-axis-cached", animate);
+    }
+
+    unload(faces);
 }
 
-const font2 = await createGoogleFont("Roboto");
-const setf = Freetype.SetFont("Roboto", "Regular");
-const charm = Freetype.SetCharmap(Freetype.FT_ENCODING_UNICODE);
-const size = Freetype.SetPixelSize(500, 0);
+const stats = Freetype.STATS_ENABLED ? Freetype.GetStats() : null;
+Freetype.Cleanup();
 
-const start = performance.now();
-const chars = Freetype.LoadGlyphsFromCharmap(0, 9999, Freetype.FT_LOAD_RENDER);
 console.log(
-    `Loading ${chars.size} glyphs took ${performance.now() - start} ms`
+    JSON.stringify(
+        {
+            version: 1,
+            date: new Date().toISOString(),
+            runtime: globalThis.Deno ? `deno ${Deno.version.deno}` : `node ${process.version}`,
+            iterations,
+            warmup,
+            unit: "ms",
+            results,
+            stats,
+        },
+        null,
+        2
+    )
 );
@@ -0,0 +1,75 @@
+// Compares two result files of test/benchmark.js. Cases whose p50 is slower
+// than the base by more than the threshold are regressions, the exit code is
+// 1 if there are any.
+//
+// deno run --allow-read test/benchmark_compare.js base.json head.json [--threshold 0.1]
+const args = globalThis.Deno ? Deno.args : process.argv.slice(2);
+const files = args.filter((arg, i) => !arg.startsWith("--") && !args[i - 1]?.startsWith("--"));
+const thresholdIndex = args.indexOf("--threshold");
+const threshold = thresholdIndex >= 0 ? Number(args[thresholdIndex + 1]) : 0.1;
+
+async function readJson(path) {
+    if (globalThis.Deno) {
+        return JSON.parse(await Deno.readTextFile(path));
+    }
+    const { readFile } = await import("node:fs/promises");
+    return JSON.parse(await readFile(path, "utf8"));
+}
+
+function exit(code) {
+    if (globalThis.Deno) {
+        Deno.exit(code);
+    }
+    process.exit(code);
+}
+
+if (files.length !== 2) {
+    console.error("Usage: benchmark_compare.js base.json head.json [--threshold 0.1]");
+    exit(2);
+}
+
+const [base, head] = await Promise.all(files.map(readJson));
+const baseResults = new Map(base.results.map((result) => [result.id, result]));
+
+const rows = [];
+let regressions = 0;
+for (const result of head.results) {
+    const previous = baseResults.get(result.id);
+    if (!previous) {
+        rows.push({ id: result.id, base: "-", head: result.p50.toFixed(3), change: "new", status: "" });
+        continue;
+    }
+    baseResults.delete(result.id);
+    const change = previous.p50 > 0 ? (result.p50 - previous.p50) / previous.p50 : 0;
+    let status = "";
+    if (change > threshold) {
+        status = "REGRESSION";
+        regressions++;
+    } else if (change < -threshold) {
+        status = "faster";
+    }
+    rows.push({
+        id: result.id,
+        base: previous.p50.toFixed(3),
+        head: result.p50.toFixed(3),
+        change: `${change >= 0 ? "+" : ""}${(change * 100).toFixed(1)}%`,
+        status,
+    });
+}
+for (const id of baseResults.keys()) {
+    rows.push({ id, base: baseResults.get(id).p50.toFixed(3), head: "-", change: "removed", status: "" });
+}
+
+console.log(`p50 ms, threshold ${(threshold * 100).toFixed(0)}%`);
+console.log(`${"case".padEnd(22)}${"base".padStart(10)}${"head".padStart(10)}${"change".padStart(10)}  status`);
+for (const row of rows) {
+    console.log(
+        `${row.id.padEnd(22)}${row.base.padStart(10)}${row.head.padStart(10)}${row.change.padStart(10)}  ${row.status}`
+    );
+}
+
+if (regressions > 0) {
+    console.log(`🔴 ${regressions} regression(s)`);
+    exit(1);
+}
+console.log("✅ No regressions");
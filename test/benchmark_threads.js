@@ -0,0 +1,38 @@
+// Scaling of parallel glyph loading from 1 to N threads, needs the pthreads
+// build, run with `node test/benchmark_threads.js [fixture font] [pixel size]`
+// where the font is a file in test/fonts
+import { readFile } from "node:fs/promises";
+import FreetypeInit from "../dist/freetype-threads.js";
+const Freetype = await FreetypeInit();
+
+const fontFile = process.argv[2] ?? "lato-regular.ttf";
+const pixelSize = Number(process.argv[3] ?? 200);
+
+const bytes = new Uint8Array(await readFile(new URL(`./fonts/${fontFile}`, import.meta.url)));
+const faces = Freetype.LoadFontFromBytes(bytes);
+const face = Freetype.GetFaceHandle(faces[0].family_name, faces[0].style_name);
+const size = Freetype.CreatePixelSize(face, pixelSize, 0);
+
+const maxWorkers = Freetype.SetWorkerCount(navigator.hardwareConcurrency ?? 4);
+let serialMs = 0;
+for (let workers = 1; workers <= maxWorkers; workers++) {
+    Freetype.SetWorkerCount(workers);
+    Freetype.ClearGlyphCache();
+    Freetype.ClearGlyphBuffer();
+    const start = performance.now();
+    const glyphs = Freetype.LoadGlyphViewsFromCharmapParallel(
+        size,
+        0,
+        0x10ffff,
+        Freetype.FT_LOAD_RENDER,
+        false
+    );
+    const ms = performance.now() - start;
+    serialMs = workers === 1 ? ms : serialMs;
+    console.log(
+        `${workers} threads: ${glyphs.size} glyphs in ${ms.toFixed(1)} ms, ` +
+            `speedup ${(serialMs / ms).toFixed(2)}x`
+    );
+}
+
+Freetype.Cleanup();
@@ -0,0 +1,130 @@
+// Microbenchmark of the bitmap conversion kernels, compares the SIMD kernels
+// to the scalar reference implementation. See benchmark_convert.sh.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "../src/convert.h"
+
+struct Mode
+{
+    unsigned char pixel_mode;
+    const char *name;
+    // Bitmap width in bytes per pixel, 0 for packed modes
+    unsigned int bytes;
+    unsigned int pixels_per_byte;
+};
+
+const Mode modes[] = {
+    {FT_PIXEL_MODE_MONO, "MONO", 0, 8},
+    {FT_PIXEL_MODE_GRAY2, "GRAY2", 0, 4},
+    {FT_PIXEL_MODE_GRAY4, "GRAY4", 0, 2},
+    {FT_PIXEL_MODE_GRAY, "GRAY", 1, 1},
+    {FT_PIXEL_MODE_LCD, "LCD", 3, 1},
+    {FT_PIXEL_MODE_LCD_V, "LCD_V", 1, 1},
+    {FT_PIXEL_MODE_BGRA, "BGRA", 4, 1},
+};
+
+const char *format_names[] = {"ALPHA", "RGBA", "RGBA_PREMULTIPLIED"};
+
+typedef bool (*ConvertFunction)(const FT_Bitmap &, BitmapFormat, unsigned int, unsigned char *);
+
+double Measure(ConvertFunction convert, const FT_Bitmap &bitmap, BitmapFormat format, unsigned char *dst, int iterations)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        convert(bitmap, format, 0x336699, dst);
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Random bitmap of the mode, rows are padded to 4 bytes like FreeType does.
+// With a negative pitch the rows flow up and `buffer` is the start of the
+// pixels, which is the bottom row.
+FT_Bitmap MakeBitmap(const Mode &mode, unsigned int width, unsigned int rows, bool flow_up, std::vector<unsigned char> &pixels)
+{
+    FT_Bitmap bitmap;
+    memset(&bitmap, 0, sizeof(bitmap));
+    bitmap.pixel_mode = mode.pixel_mode;
+    bitmap.num_grays = 256;
+    bitmap.width = mode.pixel_mode == FT_PIXEL_MODE_LCD ? width * 3 : width;
+    bitmap.rows = mode.pixel_mode == FT_PIXEL_MODE_LCD_V ? rows * 3 : rows;
+    const unsigned int row_bytes = mode.bytes ? width * mode.bytes : (width + mode.pixels_per_byte - 1) / mode.pixels_per_byte;
+    const int pitch = (row_bytes + 3) & ~3u;
+    bitmap.pitch = flow_up ? -pitch : pitch;
+
+    pixels.resize((size_t)pitch * bitmap.rows);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = rand();
+    }
+    bitmap.buffer = pixels.data();
+    return bitmap;
+}
+
+// Compares the SIMD kernels to the scalar ones in every format
+bool SameAsScalar(const FT_Bitmap &bitmap, const Mode &mode)
+{
+    for (int format = BITMAP_FORMAT_ALPHA; format <= BITMAP_FORMAT_RGBA_PREMULTIPLIED; format++)
+    {
+        std::vector<unsigned char> dst(GetConvertedBytes(bitmap, (BitmapFormat)format));
+        std::vector<unsigned char> reference(dst.size());
+        ConvertBitmapScalar(bitmap, (BitmapFormat)format, 0x336699, reference.data());
+        ConvertBitmap(bitmap, (BitmapFormat)format, 0x336699, dst.data());
+        if (dst != reference)
+        {
+            fprintf(stderr, "SIMD output differs from scalar: %s %s, width %u, pitch %d\n", mode.name,
+                    format_names[format], bitmap.width, bitmap.pitch);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    // Roughly a 500px glyph, same as in test/benchmark.js
+    const unsigned int width = argc > 1 ? atoi(argv[1]) : 512;
+    const unsigned int rows = argc > 2 ? atoi(argv[2]) : 512;
+    const int iterations = argc > 3 ? atoi(argv[3]) : 50;
+
+    // The odd width leaves a scalar tail after the 16 pixel SIMD loop
+    for (const Mode &mode : modes)
+    {
+        for (unsigned int check_width : {width, 37u})
+        {
+            for (bool flow_up : {false, true})
+            {
+                std::vector<unsigned char> pixels;
+                if (!SameAsScalar(MakeBitmap(mode, check_width, 13, flow_up, pixels), mode))
+                {
+                    return 1;
+                }
+            }
+        }
+    }
+
+    printf("%-6s %-18s %12s %12s %8s\n", "mode", "format", "scalar MP/s", "simd MP/s", "speedup");
+
+    for (const Mode &mode : modes)
+    {
+        std::vector<unsigned char> pixels;
+        const FT_Bitmap bitmap = MakeBitmap(mode, width, rows, false, pixels);
+        for (int format = BITMAP_FORMAT_ALPHA; format <= BITMAP_FORMAT_RGBA_PREMULTIPLIED; format++)
+        {
+            std::vector<unsigned char> dst(GetConvertedBytes(bitmap, (BitmapFormat)format));
+            const double megapixels = (double)width * rows * iterations / 1e6;
+            const double scalar_ms = Measure(ConvertBitmapScalar, bitmap, (BitmapFormat)format, dst.data(), iterations);
+            const double simd_ms = Measure(ConvertBitmap, bitmap, (BitmapFormat)format, dst.data(), iterations);
+            printf("%-6s %-18s %12.1f %12.1f %7.2fx\n", mode.name, format_names[format],
+                   megapixels / scalar_ms * 1000, megapixels / simd_ms * 1000, scalar_ms / simd_ms);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,940 @@
+// Generates the derived benchmark fixtures in test/fonts, see README.md
+// there. Built natively against the system FreeType:
+//
+//   g++ -O2 test/fonts/make_fixtures.cpp $(pkg-config --cflags --libs freetype2) -o build/make_fixtures
+//   build/make_fixtures <DejaVuSans.ttf> <DejaVuSansMono.ttf> test/fonts
+//
+// - fixture-sans-cff.otf: ASCII of DejaVu Sans as an OpenType CFF font
+// - fixture-sans.ttc: ASCII of DejaVu Sans and Sans Mono as a collection of
+//   TrueType fonts
+// - fixture-bitmap.bdf: ASCII of DejaVu Sans Mono as a 16 pixel BDF font
+// - fixture-sans-var.ttf: ASCII of DejaVu Sans as a variable TrueType font
+//   with a `wght` axis
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+#include FT_SYNTHESIS_H
+
+typedef std::vector<unsigned char> Bytes;
+
+const FT_ULong first_char = 0x20;
+const FT_ULong last_char = 0x7e;
+
+bool WriteFile(const std::string &path, const Bytes &bytes)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == NULL || fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+    {
+        fprintf(stderr, "Can't write %s\n", path.c_str());
+        return false;
+    }
+    fclose(file);
+    printf("Wrote %s (%zu bytes)\n", path.c_str(), bytes.size());
+    return true;
+}
+
+void Put16(Bytes &out, int value)
+{
+    out.push_back((value >> 8) & 0xff);
+    out.push_back(value & 0xff);
+}
+
+void Put32(Bytes &out, uint32_t value)
+{
+    Put16(out, value >> 16);
+    Put16(out, value & 0xffff);
+}
+
+void Set32(Bytes &out, size_t offset, uint32_t value)
+{
+    out[offset] = value >> 24;
+    out[offset + 1] = (value >> 16) & 0xff;
+    out[offset + 2] = (value >> 8) & 0xff;
+    out[offset + 3] = value & 0xff;
+}
+
+uint32_t Get32(const Bytes &bytes, size_t offset)
+{
+    return ((uint32_t)bytes[offset] << 24) | (bytes[offset + 1] << 16) | (bytes[offset + 2] << 8) | bytes[offset + 3];
+}
+
+// CFF
+
+// Type 2 charstring and DICT integer operand
+void PutOperand(Bytes &out, int value)
+{
+    if (value >= -107 && value <= 107)
+    {
+        out.push_back(value + 139);
+    }
+    else if (value >= 108 && value <= 1131)
+    {
+        out.push_back((value - 108) / 256 + 247);
+        out.push_back((value - 108) % 256);
+    }
+    else if (value >= -1131 && value <= -108)
+    {
+        out.push_back(-(value + 108) / 256 + 251);
+        out.push_back(-(value + 108) % 256);
+    }
+    else
+    {
+        out.push_back(28);
+        Put16(out, value);
+    }
+}
+
+// DICT operand of fixed size, for offsets not known up front
+void PutDictOffset(Bytes &out, uint32_t value)
+{
+    out.push_back(29);
+    Put32(out, value);
+}
+
+Bytes MakeIndex(const std::vector<Bytes> &items)
+{
+    Bytes out;
+    Put16(out, items.size());
+    if (items.empty())
+    {
+        return out;
+    }
+    out.push_back(4);
+    uint32_t offset = 1;
+    Put32(out, offset);
+    for (auto &item : items)
+    {
+        offset += item.size();
+        Put32(out, offset);
+    }
+    for (auto &item : items)
+    {
+        out.insert(out.end(), item.begin(), item.end());
+    }
+    return out;
+}
+
+// Outline to a charstring, conic segments are raised to cubics and the
+// coordinates are scaled from font units to 1000 units per em
+struct CharstringBuilder
+{
+    Bytes out;
+    double scale;
+    int x = 0;
+    int y = 0;
+    double last_x = 0;
+    double last_y = 0;
+
+    void Point(double px, double py, int &dx, int &dy)
+    {
+        const int nx = (int)lround(px * scale);
+        const int ny = (int)lround(py * scale);
+        dx = nx - x;
+        dy = ny - y;
+        x = nx;
+        y = ny;
+    }
+
+    void MoveTo(double px, double py)
+    {
+        int dx, dy;
+        Point(px, py, dx, dy);
+        PutOperand(out, dx);
+        PutOperand(out, dy);
+        out.push_back(21);
+        last_x = px;
+        last_y = py;
+    }
+
+    void LineTo(double px, double py)
+    {
+        int dx, dy;
+        Point(px, py, dx, dy);
+        PutOperand(out, dx);
+        PutOperand(out, dy);
+        out.push_back(5);
+        last_x = px;
+        last_y = py;
+    }
+
+    void CubicTo(double c1x, double c1y, double c2x, double c2y, double px, double py)
+    {
+        int d[6];
+        Point(c1x, c1y, d[0], d[1]);
+        Point(c2x, c2y, d[2], d[3]);
+        Point(px, py, d[4], d[5]);
+        for (int v : d)
+        {
+            PutOperand(out, v);
+        }
+        out.push_back(8);
+        last_x = px;
+        last_y = py;
+    }
+
+    static int MoveToCallback(const FT_Vector *to, void *user)
+    {
+        ((CharstringBuilder *)user)->MoveTo(to->x, to->y);
+        return 0;
+    }
+
+    static int LineToCallback(const FT_Vector *to, void *user)
+    {
+        ((CharstringBuilder *)user)->LineTo(to->x, to->y);
+        return 0;
+    }
+
+    static int ConicToCallback(const FT_Vector *control, const FT_Vector *to, void *user)
+    {
+        auto self = (CharstringBuilder *)user;
+        const double c1x = self->last_x + 2.0 / 3.0 * (control->x - self->last_x);
+        const double c1y = self->last_y + 2.0 / 3.0 * (control->y - self->last_y);
+        const double c2x = to->x + 2.0 / 3.0 * (control->x - to->x);
+        const double c2y = to->y + 2.0 / 3.0 * (control->y - to->y);
+        self->CubicTo(c1x, c1y, c2x, c2y, to->x, to->y);
+        return 0;
+    }
+
+    static int CubicToCallback(const FT_Vector *control1, const FT_Vector *control2, const FT_Vector *to, void *user)
+    {
+        ((CharstringBuilder *)user)->CubicTo(control1->x, control1->y, control2->x, control2->y, to->x, to->y);
+        return 0;
+    }
+};
+
+// Charstring or glyf entry of a glyph, and its gvar data in variable fonts
+struct GlyphInfo
+{
+    Bytes data;
+    int advance;
+    int x_min, y_min, x_max, y_max;
+    Bytes variation;
+};
+
+// sfnt
+
+struct Table
+{
+    const char *tag;
+    Bytes data;
+};
+
+uint32_t TableChecksum(const Bytes &data, size_t offset, size_t length)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < length; i += 4)
+    {
+        uint32_t word = 0;
+        for (size_t j = 0; j < 4; j++)
+        {
+            word = (word << 8) | (i + j < length ? data[offset + i + j] : 0);
+        }
+        sum += word;
+    }
+    return sum;
+}
+
+// Tables must be sorted by tag, `head` gets its checksum adjustment
+Bytes MakeSfnt(uint32_t version, const std::vector<Table> &tables)
+{
+    Bytes out;
+    const int num_tables = tables.size();
+    int entry_selector = 0;
+    while ((2 << entry_selector) <= num_tables)
+    {
+        entry_selector++;
+    }
+    const int search_range = (1 << entry_selector) * 16;
+    Put32(out, version);
+    Put16(out, num_tables);
+    Put16(out, search_range);
+    Put16(out, entry_selector);
+    Put16(out, num_tables * 16 - search_range);
+
+    size_t offset = 12 + 16 * num_tables;
+    size_t head_offset = 0;
+    for (auto &table : tables)
+    {
+        out.insert(out.end(), table.tag, table.tag + 4);
+        Put32(out, TableChecksum(table.data, 0, table.data.size()));
+        Put32(out, offset);
+        Put32(out, table.data.size());
+        if (strcmp(table.tag, "head") == 0)
+        {
+            head_offset = offset;
+        }
+        offset += (table.data.size() + 3) & ~3;
+    }
+    for (auto &table : tables)
+    {
+        out.insert(out.end(), table.data.begin(), table.data.end());
+        out.resize((out.size() + 3) & ~3);
+    }
+    Set32(out, head_offset + 8, 0xb1b0afba - TableChecksum(out, 0, out.size()));
+    return out;
+}
+
+void PutNameString(Bytes &out, const std::string &text)
+{
+    for (char c : text)
+    {
+        Put16(out, (unsigned char)c);
+    }
+}
+
+Bytes MakeNameTable(const std::vector<std::pair<int, std::string>> &names)
+{
+    Bytes out, strings;
+    Put16(out, 0);
+    Put16(out, names.size());
+    Put16(out, 6 + 12 * names.size());
+    for (auto &name : names)
+    {
+        Put16(out, 3);
+        Put16(out, 1);
+        Put16(out, 0x409);
+        Put16(out, name.first);
+        Put16(out, name.second.size() * 2);
+        Put16(out, strings.size());
+        PutNameString(strings, name.second);
+    }
+    out.insert(out.end(), strings.begin(), strings.end());
+    return out;
+}
+
+// TrueType glyph of an outline loaded with FT_LOAD_NO_SCALE, the points are
+// copied as they are
+Bytes MakeGlyfEntry(const FT_Outline &outline, const GlyphInfo &glyph)
+{
+    Bytes out;
+    if (outline.n_contours == 0)
+    {
+        return out;
+    }
+    Put16(out, outline.n_contours);
+    for (int value : {glyph.x_min, glyph.y_min, glyph.x_max, glyph.y_max})
+    {
+        Put16(out, value);
+    }
+    for (int i = 0; i < outline.n_contours; i++)
+    {
+        Put16(out, outline.contours[i]);
+    }
+    Put16(out, 0);
+    for (int i = 0; i < outline.n_points; i++)
+    {
+        out.push_back(FT_CURVE_TAG(outline.tags[i]) == FT_CURVE_TAG_ON ? 1 : 0);
+    }
+    // Coordinates are 16-bit deltas
+    long previous = 0;
+    for (int i = 0; i < outline.n_points; i++)
+    {
+        Put16(out, outline.points[i].x - previous);
+        previous = outline.points[i].x;
+    }
+    previous = 0;
+    for (int i = 0; i < outline.n_points; i++)
+    {
+        Put16(out, outline.points[i].y - previous);
+        previous = outline.points[i].y;
+    }
+    out.resize((out.size() + 3) & ~3);
+    return out;
+}
+
+// Variable fonts
+
+// Range of the `wght` axis, the default is the source font
+const int weight_min = 400;
+const int weight_max = 700;
+
+// gvar data of a glyph with one tuple at the `wght` maximum. The deltas
+// embolden the outline by `strength` units and widen the advance by as
+// much, empty glyphs don't vary.
+Bytes MakeGlyphVariation(FT_Library library, const FT_Outline &outline, int strength)
+{
+    Bytes out;
+    if (outline.n_points == 0)
+    {
+        return out;
+    }
+    FT_Outline bold;
+    FT_Outline_New(library, outline.n_points, outline.n_contours, &bold);
+    FT_Outline_Copy(&outline, &bold);
+    FT_Outline_EmboldenXY(&bold, strength, 0);
+    std::vector<int> dx, dy;
+    for (int i = 0; i < outline.n_points; i++)
+    {
+        dx.push_back(bold.points[i].x - outline.points[i].x);
+        dy.push_back(bold.points[i].y - outline.points[i].y);
+    }
+    FT_Outline_Done(library, &bold);
+    // Phantom points: left side bearing, advance, top and bottom
+    dx.insert(dx.end(), {0, strength, 0, 0});
+    dy.insert(dy.end(), {0, 0, 0, 0});
+
+    // Shared point numbers, 0 is all points, then runs of 16-bit deltas
+    Bytes data = {0};
+    for (const std::vector<int> *deltas : {&dx, &dy})
+    {
+        for (size_t i = 0; i < deltas->size(); i += 64)
+        {
+            const size_t count = std::min<size_t>(64, deltas->size() - i);
+            data.push_back(0x40 | (count - 1));
+            for (size_t j = i; j < i + count; j++)
+            {
+                Put16(data, (*deltas)[j]);
+            }
+        }
+    }
+
+    // One tuple with shared points and an embedded peak of 1.0
+    Put16(out, 0x8001);
+    Put16(out, 10);
+    Put16(out, data.size());
+    Put16(out, 0x8000);
+    Put16(out, 0x4000);
+    out.insert(out.end(), data.begin(), data.end());
+    out.resize((out.size() + 1) & ~1);
+    return out;
+}
+
+Bytes MakeGvarTable(const std::vector<GlyphInfo> &glyphs)
+{
+    Bytes out;
+    const size_t data_offset = 20 + 4 * (glyphs.size() + 1);
+    Put16(out, 1);
+    Put16(out, 0);
+    Put16(out, 1);
+    Put16(out, 0);
+    Put32(out, data_offset);
+    Put16(out, glyphs.size());
+    // Long offsets
+    Put16(out, 1);
+    Put32(out, data_offset);
+    uint32_t offset = 0;
+    for (auto &glyph : glyphs)
+    {
+        Put32(out, offset);
+        offset += glyph.variation.size();
+    }
+    Put32(out, offset);
+    for (auto &glyph : glyphs)
+    {
+        out.insert(out.end(), glyph.variation.begin(), glyph.variation.end());
+    }
+    return out;
+}
+
+// Advance deltas of the glyphs, so advances are read without loading the
+// outlines. One region at the `wght` maximum, glyph indices are the delta
+// set indices.
+Bytes MakeHvarTable(const std::vector<GlyphInfo> &glyphs, int strength)
+{
+    Bytes out;
+    Put32(out, 0x10000);
+    Put32(out, 20);
+    Put32(out, 0);
+    Put32(out, 0);
+    Put32(out, 0);
+    // Item variation store, its region list and the one item variation data
+    Put16(out, 1);
+    Put32(out, 12);
+    Put16(out, 1);
+    Put32(out, 22);
+    for (int value : {1, 1, 0, 0x4000, 0x4000})
+    {
+        Put16(out, value);
+    }
+    for (int value : {(int)glyphs.size(), 1, 1, 0})
+    {
+        Put16(out, value);
+    }
+    for (auto &glyph : glyphs)
+    {
+        Put16(out, glyph.variation.empty() ? 0 : strength);
+    }
+    return out;
+}
+
+// The `wght` axis, named 256, and the named instances Regular (257) and
+// Bold (258)
+Bytes MakeFvarTable()
+{
+    Bytes out;
+    for (int value : {1, 0, 16, 2, 1, 20, 2, 8})
+    {
+        Put16(out, value);
+    }
+    out.insert(out.end(), {'w', 'g', 'h', 't'});
+    Put32(out, weight_min << 16);
+    Put32(out, weight_min << 16);
+    Put32(out, weight_max << 16);
+    Put16(out, 0);
+    Put16(out, 256);
+    const std::pair<int, int> instances[] = {{257, weight_min}, {258, weight_max}};
+    for (auto &instance : instances)
+    {
+        Put16(out, instance.first);
+        Put16(out, 0);
+        Put32(out, instance.second << 16);
+    }
+    return out;
+}
+
+// Font of the ASCII glyphs of `source`. CFF outlines are raised to cubics
+// and scaled to 1000 units per em, TrueType outlines are copied without
+// hinting instructions. Variable fonts are TrueType with a `wght` axis.
+bool MakeOutlineFont(FT_Library library, const std::string &source, const std::string &family, bool cff, bool variable,
+                     Bytes &font)
+{
+    FT_Face face;
+    if (FT_New_Face(library, source.c_str(), 0, &face))
+    {
+        fprintf(stderr, "Can't open %s\n", source.c_str());
+        return false;
+    }
+
+    const int units_per_em = cff ? 1000 : face->units_per_EM;
+    const int strength = units_per_em / 24;
+    const double scale = (double)units_per_em / face->units_per_EM;
+    std::vector<GlyphInfo> glyphs;
+    int max_points = 0, max_contours = 0;
+
+    // .notdef is an empty glyph with the width of the space. The width is
+    // the first operand of a charstring, defaultWidthX and nominalWidthX
+    // are 0.
+    FT_Load_Char(face, ' ', FT_LOAD_NO_SCALE);
+    GlyphInfo notdef = {{}, (int)lround(face->glyph->advance.x * scale), 0, 0, 0, 0};
+    if (cff)
+    {
+        PutOperand(notdef.data, notdef.advance);
+        notdef.data.push_back(14);
+    }
+    glyphs.push_back(notdef);
+
+    for (FT_ULong c = first_char; c <= last_char; c++)
+    {
+        if (FT_Load_Char(face, c, FT_LOAD_NO_SCALE))
+        {
+            fprintf(stderr, "Can't load char %lu\n", c);
+            FT_Done_Face(face);
+            return false;
+        }
+        const FT_Outline &outline = face->glyph->outline;
+        GlyphInfo glyph;
+        glyph.advance = (int)lround(face->glyph->advance.x * scale);
+        FT_BBox bbox;
+        FT_Outline_Get_CBox(&outline, &bbox);
+        glyph.x_min = (int)floor(bbox.xMin * scale);
+        glyph.y_min = (int)floor(bbox.yMin * scale);
+        glyph.x_max = (int)ceil(bbox.xMax * scale);
+        glyph.y_max = (int)ceil(bbox.yMax * scale);
+        max_points = std::max(max_points, (int)outline.n_points);
+        max_contours = std::max(max_contours, (int)outline.n_contours);
+
+        if (cff)
+        {
+            CharstringBuilder builder;
+            builder.scale = scale;
+            if (glyph.advance != 0)
+            {
+                PutOperand(builder.out, glyph.advance);
+            }
+            FT_Outline_Funcs funcs = {CharstringBuilder::MoveToCallback, CharstringBuilder::LineToCallback,
+                                      CharstringBuilder::ConicToCallback, CharstringBuilder::CubicToCallback, 0, 0};
+            FT_Outline_Decompose(&face->glyph->outline, &funcs, &builder);
+            builder.out.push_back(14);
+            glyph.data = builder.out;
+        }
+        else
+        {
+            glyph.data = MakeGlyfEntry(outline, glyph);
+        }
+        if (variable)
+        {
+            glyph.variation = MakeGlyphVariation(library, outline, strength);
+        }
+        glyphs.push_back(glyph);
+    }
+    const int ascender = (int)lround(face->ascender * scale);
+    const int descender = (int)lround(face->descender * scale);
+    const int line_gap = (int)lround(face->height * scale) - ascender + descender;
+    const int underline_position = (int)lround(face->underline_position * scale);
+    const int underline_thickness = (int)lround(face->underline_thickness * scale);
+    FT_Done_Face(face);
+
+    int x_min = 0, y_min = 0, x_max = 0, y_max = 0, max_advance = 0, advance_sum = 0;
+    for (auto &glyph : glyphs)
+    {
+        x_min = std::min(x_min, glyph.x_min);
+        y_min = std::min(y_min, glyph.y_min);
+        x_max = std::max(x_max, glyph.x_max);
+        y_max = std::max(y_max, glyph.y_max);
+        max_advance = std::max(max_advance, glyph.advance);
+        advance_sum += glyph.advance;
+    }
+    const int num_glyphs = glyphs.size();
+    std::string ps_name = family + "-Regular";
+    ps_name.erase(std::remove(ps_name.begin(), ps_name.end(), ' '), ps_name.end());
+
+    std::vector<Table> tables;
+    if (cff)
+    {
+        // Header, Name, Top DICT, String and Global Subr INDEXes, then the
+        // CharStrings INDEX and the Private DICT
+        Bytes table = {1, 0, 4, 4};
+        const Bytes name_index = MakeIndex({Bytes(ps_name.begin(), ps_name.end())});
+        const Bytes empty_index = MakeIndex({});
+        std::vector<Bytes> charstrings;
+        for (auto &glyph : glyphs)
+        {
+            charstrings.push_back(glyph.data);
+        }
+        const Bytes charstrings_index = MakeIndex(charstrings);
+        Bytes private_dict;
+        PutOperand(private_dict, 0);
+        private_dict.push_back(20);
+        PutOperand(private_dict, 0);
+        private_dict.push_back(21);
+
+        // FontBBox, CharStrings and Private, the offsets have a fixed size
+        Bytes top_dict;
+        PutOperand(top_dict, x_min);
+        PutOperand(top_dict, y_min);
+        PutOperand(top_dict, x_max);
+        PutOperand(top_dict, y_max);
+        top_dict.push_back(5);
+        const size_t top_dict_size = top_dict.size() + 6 + 11;
+        const size_t charstrings_offset = table.size() + name_index.size() + MakeIndex({Bytes(top_dict_size)}).size() +
+                                          empty_index.size() * 2;
+        const size_t private_offset = charstrings_offset + charstrings_index.size();
+        PutDictOffset(top_dict, charstrings_offset);
+        top_dict.push_back(17);
+        PutDictOffset(top_dict, private_dict.size());
+        PutDictOffset(top_dict, private_offset);
+        top_dict.push_back(18);
+
+        const Bytes top_dict_index = MakeIndex({top_dict});
+        for (const Bytes *part : std::vector<const Bytes *>{&name_index, &top_dict_index, &empty_index, &empty_index, &charstrings_index, &private_dict})
+        {
+            table.insert(table.end(), part->begin(), part->end());
+        }
+        tables.push_back({"CFF ", table});
+    }
+
+    if (variable)
+    {
+        tables.push_back({"HVAR", MakeHvarTable(glyphs, strength)});
+    }
+
+    Bytes os2;
+    Put16(os2, 4);
+    Put16(os2, advance_sum / num_glyphs);
+    Put16(os2, 400);
+    Put16(os2, 5);
+    Put16(os2, 0);
+    // Sub- and superscript sizes and offsets, strikeout size and position
+    for (int value : {650, 600, 0, 75, 650, 600, 0, 350, 50, 250})
+    {
+        Put16(os2, value * units_per_em / 1000);
+    }
+    Put16(os2, 0);
+    os2.insert(os2.end(), 10, 0);
+    Put32(os2, 1);
+    Put32(os2, 0);
+    Put32(os2, 0);
+    Put32(os2, 0);
+    os2.insert(os2.end(), {'N', 'O', 'N', 'E'});
+    Put16(os2, 0x40);
+    Put16(os2, first_char);
+    Put16(os2, last_char);
+    Put16(os2, ascender);
+    Put16(os2, descender);
+    Put16(os2, line_gap);
+    Put16(os2, y_max);
+    Put16(os2, -y_min);
+    Put32(os2, 1);
+    Put32(os2, 0);
+    // sxHeight, sCapHeight, usDefaultChar, usBreakChar and usMaxContext
+    for (int value : {0, 0, 0, (int)' ', 0})
+    {
+        Put16(os2, value);
+    }
+    tables.push_back({"OS/2", os2});
+
+    // Format 4 with one segment for the ASCII range
+    Bytes cmap;
+    Put16(cmap, 0);
+    Put16(cmap, 1);
+    Put16(cmap, 3);
+    Put16(cmap, 1);
+    Put32(cmap, 12);
+    Put16(cmap, 4);
+    Put16(cmap, 32);
+    Put16(cmap, 0);
+    Put16(cmap, 4);
+    Put16(cmap, 4);
+    Put16(cmap, 1);
+    Put16(cmap, 0);
+    for (int value : {(int)last_char, 0xffff, 0, (int)first_char, 0xffff, (int)(1 - first_char) & 0xffff, 1, 0, 0})
+    {
+        Put16(cmap, value);
+    }
+    tables.push_back({"cmap", cmap});
+    if (variable)
+    {
+        tables.push_back({"fvar", MakeFvarTable()});
+    }
+
+    if (!cff)
+    {
+        Bytes glyf, loca;
+        for (auto &glyph : glyphs)
+        {
+            Put32(loca, glyf.size());
+            glyf.insert(glyf.end(), glyph.data.begin(), glyph.data.end());
+        }
+        Put32(loca, glyf.size());
+        tables.push_back({"glyf", glyf});
+        if (variable)
+        {
+            tables.push_back({"gvar", MakeGvarTable(glyphs)});
+        }
+        tables.push_back({"head", {}});
+        tables.push_back({"hhea", {}});
+        tables.push_back({"hmtx", {}});
+        tables.push_back({"loca", loca});
+    }
+    else
+    {
+        tables.push_back({"head", {}});
+        tables.push_back({"hhea", {}});
+        tables.push_back({"hmtx", {}});
+    }
+
+    for (auto &table : tables)
+    {
+        Bytes &data = table.data;
+        if (strcmp(table.tag, "head") == 0)
+        {
+            Put32(data, 0x10000);
+            Put32(data, 0x10000);
+            Put32(data, 0);
+            Put32(data, 0x5f0f3cf5);
+            Put16(data, 3);
+            Put16(data, units_per_em);
+            data.insert(data.end(), 16, 0);
+            // Long loca offsets
+            for (int value : {x_min, y_min, x_max, y_max, 0, 8, 2, 1, 0})
+            {
+                Put16(data, value);
+            }
+        }
+        else if (strcmp(table.tag, "hhea") == 0)
+        {
+            Put32(data, 0x10000);
+            for (int value : {ascender, descender, line_gap, max_advance, x_min, 0, x_max, 1, 0, 0, 0, 0, 0, 0, 0, num_glyphs})
+            {
+                Put16(data, value);
+            }
+        }
+        else if (strcmp(table.tag, "hmtx") == 0)
+        {
+            for (auto &glyph : glyphs)
+            {
+                Put16(data, glyph.advance);
+                Put16(data, glyph.x_min);
+            }
+        }
+    }
+
+    Bytes maxp;
+    if (cff)
+    {
+        Put32(maxp, 0x5000);
+        Put16(maxp, num_glyphs);
+    }
+    else
+    {
+        Put32(maxp, 0x10000);
+        for (int value : {num_glyphs, max_points, max_contours, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0})
+        {
+            Put16(maxp, value);
+        }
+    }
+    tables.push_back({"maxp", maxp});
+
+    std::vector<std::pair<int, std::string>> names = {
+        {0, "Derived from DejaVu, see test/fonts/README.md"},
+        {1, family},
+        {2, "Regular"},
+        {3, ps_name},
+        {4, family + " Regular"},
+        {5, "Version 1.000"},
+        {6, ps_name},
+    };
+    if (variable)
+    {
+        names.insert(names.end(), {{256, "Weight"}, {257, "Regular"}, {258, "Bold"}});
+    }
+    tables.push_back({"name", MakeNameTable(names)});
+
+    Bytes post;
+    Put32(post, 0x30000);
+    Put32(post, 0);
+    Put16(post, underline_position);
+    Put16(post, underline_thickness);
+    for (int i = 0; i < 5; i++)
+    {
+        Put32(post, 0);
+    }
+    tables.push_back({"post", post});
+
+    font = MakeSfnt(cff ? 0x4f54544f : 0x10000, tables);
+    return true;
+}
+
+// BDF
+
+bool MakeBdfFont(FT_Library library, const std::string &source, const std::string &path, int pixel_size)
+{
+    FT_Face face;
+    if (FT_New_Face(library, source.c_str(), 0, &face) || FT_Set_Pixel_Sizes(face, 0, pixel_size))
+    {
+        fprintf(stderr, "Can't open %s\n", source.c_str());
+        return false;
+    }
+
+    const int ascent = (int)(face->size->metrics.ascender >> 6);
+    const int descent = (int)(-face->size->metrics.descender >> 6);
+    std::string glyphs;
+    int max_width = 0, max_height = 0, min_left = 0, min_bottom = 0, advance_sum = 0;
+    char line[256];
+    for (FT_ULong c = first_char; c <= last_char; c++)
+    {
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER | FT_LOAD_TARGET_MONO))
+        {
+            fprintf(stderr, "Can't load char %lu\n", c);
+            FT_Done_Face(face);
+            return false;
+        }
+        const FT_GlyphSlot slot = face->glyph;
+        const FT_Bitmap &bitmap = slot->bitmap;
+        const int advance = (int)(slot->advance.x >> 6);
+        const int bottom = slot->bitmap_top - (int)bitmap.rows;
+        advance_sum += advance;
+        max_width = std::max(max_width, (int)bitmap.width);
+        max_height = std::max(max_height, (int)bitmap.rows);
+        min_left = std::min(min_left, slot->bitmap_left);
+        min_bottom = std::min(min_bottom, bottom);
+
+        snprintf(line, sizeof(line), "STARTCHAR U+%04lX\nENCODING %lu\nSWIDTH %d 0\nDWIDTH %d 0\nBBX %u %u %d %d\nBITMAP\n",
+                 c, c, advance * 1000 / pixel_size, advance, bitmap.width, bitmap.rows, slot->bitmap_left, bottom);
+        glyphs += line;
+        const unsigned int row_bytes = (bitmap.width + 7) / 8;
+        for (unsigned int y = 0; y < bitmap.rows; y++)
+        {
+            for (unsigned int x = 0; x < row_bytes; x++)
+            {
+                snprintf(line, sizeof(line), "%02X", bitmap.buffer[y * bitmap.pitch + x]);
+                glyphs += line;
+            }
+            glyphs += "\n";
+        }
+        glyphs += "ENDCHAR\n";
+    }
+    FT_Done_Face(face);
+
+    const int average_width = advance_sum * 10 / (int)(last_char - first_char + 1);
+    std::string font = "STARTFONT 2.1\n";
+    snprintf(line, sizeof(line), "FONT -Fixture-Fixture Bitmap-Medium-R-Normal--%d-%d-72-72-C-%d-ISO10646-1\n",
+             pixel_size, pixel_size * 10, average_width);
+    font += line;
+    snprintf(line, sizeof(line), "SIZE %d 72 72\nFONTBOUNDINGBOX %d %d %d %d\n", pixel_size, max_width, max_height, min_left, min_bottom);
+    font += line;
+    font += "STARTPROPERTIES 16\n";
+    font += "COPYRIGHT \"Derived from DejaVu Sans Mono, see test/fonts/README.md\"\n";
+    font += "FOUNDRY \"Fixture\"\n";
+    font += "FAMILY_NAME \"Fixture Bitmap\"\n";
+    font += "WEIGHT_NAME \"Medium\"\n";
+    font += "SLANT \"R\"\n";
+    font += "SETWIDTH_NAME \"Normal\"\n";
+    snprintf(line, sizeof(line), "PIXEL_SIZE %d\nPOINT_SIZE %d\n", pixel_size, pixel_size * 10);
+    font += line;
+    font += "RESOLUTION_X 72\nRESOLUTION_Y 72\nSPACING \"C\"\n";
+    snprintf(line, sizeof(line), "AVERAGE_WIDTH %d\n", average_width);
+    font += line;
+    font += "CHARSET_REGISTRY \"ISO10646\"\nCHARSET_ENCODING \"1\"\n";
+    snprintf(line, sizeof(line), "FONT_ASCENT %d\nFONT_DESCENT %d\n", ascent, descent);
+    font += line;
+    font += "ENDPROPERTIES\n";
+    snprintf(line, sizeof(line), "CHARS %lu\n", last_char - first_char + 1);
+    font += line;
+    font += glyphs;
+    font += "ENDFONT\n";
+    return WriteFile(path, Bytes(font.begin(), font.end()));
+}
+
+// TTC
+
+// Fonts are appended as is, the table offsets are moved by the font offset
+Bytes MakeCollection(const std::vector<Bytes> &fonts)
+{
+    Bytes out = {'t', 't', 'c', 'f'};
+    Put32(out, 0x10000);
+    Put32(out, fonts.size());
+    out.resize(out.size() + 4 * fonts.size());
+    for (size_t i = 0; i < fonts.size(); i++)
+    {
+        Bytes font = fonts[i];
+        out.resize((out.size() + 3) & ~3);
+        const uint32_t base = out.size();
+        Set32(out, 12 + 4 * i, base);
+        const int num_tables = (font[4] << 8) | font[5];
+        for (int t = 0; t < num_tables; t++)
+        {
+            const size_t entry = 12 + 16 * t + 8;
+            Set32(font, entry, Get32(font, entry) + base);
+        }
+        out.insert(out.end(), font.begin(), font.end());
+    }
+    return out;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "Usage: %s <DejaVuSans.ttf> <DejaVuSansMono.ttf> <output dir>\n", argv[0]);
+        return 1;
+    }
+    const std::string output = argv[3];
+
+    FT_Library library;
+    if (FT_Init_FreeType(&library))
+    {
+        return 1;
+    }
+    Bytes cff, sans, mono, var;
+    bool ok = MakeOutlineFont(library, argv[1], "Fixture Sans CFF", true, false, cff) &&
+              WriteFile(output + "/fixture-sans-cff.otf", cff) &&
+              MakeOutlineFont(library, argv[1], "Fixture Sans", false, false, sans) &&
+              MakeOutlineFont(library, argv[2], "Fixture Sans Mono", false, false, mono) &&
+              WriteFile(output + "/fixture-sans.ttc", MakeCollection({sans, mono})) &&
+              MakeBdfFont(library, argv[2], output + "/fixture-bitmap.bdf", 16) &&
+              MakeOutlineFont(library, argv[1], "Fixture Sans Variable", false, true, var) &&
+              WriteFile(output + "/fixture-sans-var.ttf", var);
+    FT_Done_FreeType(library);
+    return ok ? 0 : 1;
+}
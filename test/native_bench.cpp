@@ -0,0 +1,425 @@
+// Native benchmark driver of the wrapper core, runs the cases of
+// test/benchmark.js over the fixture fonts with system FreeType. Prints the
+// results as JSON in the same format, so result files can be compared with
+// test/benchmark_compare.js, and the hot paths can be profiled with perf or
+// valgrind. See CMakeLists.txt.
+//
+// native_bench [--fonts dir] [--iterations n] [--warmup n] [--filter text]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../src/core.h"
+#include "../src/layout.h"
+
+#ifndef FT_FIXTURE_DIR
+#define FT_FIXTURE_DIR "test/fonts"
+#endif
+
+struct Fixture
+{
+    const char *file;
+    const char *format;
+    FT_UInt pixel_size;
+};
+
+const Fixture fixtures[] = {
+    {"lato-regular.ttf", "ttf", 32},
+    {"fixture-sans-cff.otf", "cff", 32},
+    {"open-sans-regular.woff2", "woff2", 32},
+    {"fixture-sans.ttc", "ttc", 32},
+    {"fixture-bitmap.bdf", "bitmap", 16},
+    {"fixture-sans-var.ttf", "var", 32},
+};
+
+struct Result
+{
+    std::string id;
+    const Fixture *fixture;
+    std::string name;
+    size_t items;
+    std::vector<double> samples;
+};
+
+int iterations = 20;
+int warmup = 3;
+std::string filter;
+std::vector<Result> results;
+
+std::vector<unsigned char> ReadFile(const std::string &path)
+{
+    std::vector<unsigned char> bytes;
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+    {
+        return bytes;
+    }
+    unsigned char chunk[65536];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        bytes.insert(bytes.end(), chunk, chunk + read);
+    }
+    fclose(file);
+    return bytes;
+}
+
+double Percentile(const std::vector<double> &sorted, double p)
+{
+    const long i = std::min<long>(sorted.size() - 1, (long)ceil(p / 100 * sorted.size()) - 1);
+    return sorted[std::max(0L, i)];
+}
+
+// Runs `setup` untimed and `run` timed for each iteration, `run` returns the
+// number of items it processed
+void Bench(const Fixture &fixture, const char *name, std::function<size_t()> run, std::function<void()> setup = [] {})
+{
+    const std::string id = std::string(fixture.format) + "/" + name;
+    if (!filter.empty() && id.find(filter) == std::string::npos)
+    {
+        return;
+    }
+    Result result = {id, &fixture, name, 0, {}};
+    for (int i = 0; i < warmup + iterations; i++)
+    {
+        setup();
+        const auto start = std::chrono::steady_clock::now();
+        result.items = run();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (i >= warmup)
+        {
+            result.samples.push_back(elapsed.count());
+        }
+    }
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    fprintf(stderr, "%-20s p50 %.3f ms, p90 %.3f ms (%zu items)\n", id.c_str(), Percentile(sorted, 50), Percentile(sorted, 90), result.items);
+    results.push_back(result);
+}
+
+// Family and style names of the loaded faces
+typedef std::vector<std::pair<std::string, std::string>> FaceNames;
+
+FaceNames Load(const std::vector<unsigned char> &bytes)
+{
+    FaceNames names;
+    auto fns = CopyFontBytes(bytes.data(), bytes.size());
+    if (fns != nullptr)
+    {
+        for (auto &face : LoadFaces(StoreFont(std::move(fns))))
+        {
+            names.push_back({face.family_name, face.style_name});
+        }
+    }
+    return names;
+}
+
+void Unload(const FaceNames &names)
+{
+    std::set<std::string> families;
+    for (auto &name : names)
+    {
+        families.insert(name.first);
+    }
+    for (auto &family : families)
+    {
+        UnloadFont(family);
+    }
+}
+
+void PrintResults()
+{
+    printf("{\n  \"version\": 1,\n  \"runtime\": \"native freetype %d.%d.%d\",\n", FREETYPE_MAJOR, FREETYPE_MINOR, FREETYPE_PATCH);
+    printf("  \"iterations\": %d,\n  \"warmup\": %d,\n  \"unit\": \"ms\",\n  \"results\": [", iterations, warmup);
+    for (size_t r = 0; r < results.size(); r++)
+    {
+        const Result &result = results[r];
+        std::vector<double> sorted = result.samples;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (double sample : sorted)
+        {
+            sum += sample;
+        }
+        printf("%s\n    {\"id\": \"%s\", \"font\": \"%s\", \"format\": \"%s\", \"case\": \"%s\", \"items\": %zu, "
+               "\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"mean\": %.3f}",
+               r > 0 ? "," : "", result.id.c_str(), result.fixture->file, result.fixture->format, result.name.c_str(), result.items,
+               sorted.front(), Percentile(sorted, 50), Percentile(sorted, 90), Percentile(sorted, 99), sorted.back(), sum / sorted.size());
+    }
+    printf("\n  ],\n  \"stats\": ");
+    if (FT_WASM_STATS)
+    {
+        const HotPathStats stats = GetStats();
+        printf("{\"font_loads\": %zu, \"glyph_loads\": %zu, \"glyph_load_ms\": %.3f, \"glyph_renders\": %zu, \"glyph_render_ms\": %.3f, "
+               "\"kerning_lookups\": %zu, \"bitmap_conversions\": %zu}\n}\n",
+               stats.font_loads, stats.glyph_loads, stats.glyph_load_ms, stats.glyph_renders,
+               stats.glyph_render_ms, stats.kerning_lookups, stats.bitmap_conversions);
+    }
+    else
+    {
+        printf("null\n}\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string fonts = FT_FIXTURE_DIR;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--fonts") == 0)
+        {
+            fonts = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--iterations") == 0)
+        {
+            iterations = std::max(1, atoi(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--warmup") == 0)
+        {
+            warmup = std::max(0, atoi(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--filter") == 0)
+        {
+            filter = argv[i + 1];
+        }
+    }
+
+    for (const Fixture &fixture : fixtures)
+    {
+        const std::vector<unsigned char> bytes = ReadFile(fonts + "/" + fixture.file);
+        if (bytes.empty())
+        {
+            fprintf(stderr, "Unable to read %s/%s\n", fonts.c_str(), fixture.file);
+            return 1;
+        }
+
+        // Load and unload are timed apart, the font is not shared between loads
+        FaceNames loaded;
+        Bench(fixture, "load", [&]
+              { loaded = Load(bytes);
+                return loaded.size(); }, [&]
+              { Unload(loaded); });
+        Unload(loaded);
+        Bench(fixture, "unload", [&]
+              { Unload(loaded);
+                return loaded.size(); }, [&]
+              { loaded = Load(bytes); });
+
+        const FaceNames faces = Load(bytes);
+        if (faces.empty())
+        {
+            fprintf(stderr, "Unable to load %s\n", fixture.file);
+            return 1;
+        }
+        const int face_handle = GetFaceHandle(faces[0].first, faces[0].second);
+        SelectFaceCharmap(face_handle, FT_ENCODING_UNICODE);
+        const int size_handle = CreatePixelSize(face_handle, 0, fixture.pixel_size);
+        SizeHandle *size = GetSizeHandle(size_handle);
+        if (size == nullptr)
+        {
+            return 1;
+        }
+        FT_Face face = size->font->face;
+        const auto clear = []
+        {
+            ClearGlyphCache();
+            ClearGlyphBuffer();
+        };
+
+        // Charmap scan loads the outlines without rendering
+        std::vector<FT_ULong> charcodes;
+        const auto scan = [&]
+        {
+            ScopedSize scoped_size(size->size);
+            charcodes.clear();
+            ForEachCharmapGlyph(face, 0, 0x10ffff, FT_LOAD_DEFAULT, 0, [&](FT_ULong charcode, const FT_GlyphSlotRec *)
+                                { charcodes.push_back(charcode); });
+            return charcodes.size();
+        };
+        scan();
+        const std::vector<FT_ULong> all_charcodes = charcodes;
+        Bench(fixture, "charmap", scan, clear);
+
+        std::vector<GlyphView> views;
+        const auto render = [&](FT_Int32 flags, int sdf)
+        {
+            return [&, flags, sdf]
+            {
+                ScopedSize scoped_size(size->size);
+                views.clear();
+                ForEachGlyph(face, all_charcodes, flags, sdf, [&](FT_ULong, const FT_GlyphSlotRec *slot)
+                             { views.push_back(MakeGlyphView(slot)); });
+                return views.size();
+            };
+        };
+        Bench(fixture, "mono", render(FT_LOAD_RENDER | FT_LOAD_TARGET_MONO, 0), clear);
+        Bench(fixture, "gray", render(FT_LOAD_RENDER, 0), clear);
+        Bench(fixture, "gray-cached", render(FT_LOAD_RENDER, 0));
+        Bench(fixture, "sdf", render(FT_LOAD_RENDER, 1), clear);
+
+        // SDF batches with each renderer, the auto renderer picks per glyph
+        const std::pair<const char *, int> sdf_renderers[] = {
+            {"sdf-outline", SDF_RENDERER_OUTLINE}, {"sdf-bitmap", SDF_RENDERER_BITMAP}, {"sdf-auto", SDF_RENDERER_AUTO}};
+        for (const auto &renderer : sdf_renderers)
+        {
+            Bench(fixture, renderer.first, [&]
+                  { return (size_t)RenderSdfBatchWithFace(face_handle, all_charcodes, fixture.pixel_size, 8, renderer.second, FT_LOAD_NO_HINTING).glyph_count; });
+        }
+
+        // Cold start from a snapshot of the gray glyphs, nothing is rendered
+        std::vector<unsigned char> snapshot;
+        clear();
+        render(FT_LOAD_RENDER, 0)();
+        ExportGlyphSnapshot(snapshot);
+        Bench(fixture, "gray-snapshot", render(FT_LOAD_RENDER, 0), [&]
+              { ClearGlyphBuffer();
+                ImportGlyphSnapshot(snapshot); });
+        ClearGlyphSnapshot();
+
+        // Subpixel positioning renders each glyph once per bin, the cache grows
+        // about linearly with the bin count
+        for (int bins : {1, 4})
+        {
+            const std::string name = "subpixel-" + std::to_string(bins);
+            Bench(fixture, name.c_str(), [&]
+                  {
+                ScopedSize scoped_size(size->size);
+                size_t count = 0;
+                for (FT_ULong charcode : all_charcodes)
+                {
+                    const FT_UInt glyph_index = FT_Get_Char_Index(face, charcode);
+                    for (int bin = 0; bin < bins; bin++)
+                    {
+                        count += LoadCachedGlyph(face, glyph_index, FT_LOAD_RENDER | FT_LOAD_TARGET_LIGHT, SubpixelOffset(bin, bins)) != NULL;
+                    }
+                }
+                return count; }, clear);
+            if (filter.empty() || (std::string(fixture.format) + "/" + name).find(filter) != std::string::npos)
+            {
+                fprintf(stderr, "%-20s glyph cache %zu bytes\n", "", GetGlyphCacheStats().bytes);
+            }
+        }
+
+        // Outlines instead of bitmaps, at any scale
+        std::vector<FT_UInt> all_indices;
+        for (FT_ULong charcode : all_charcodes)
+        {
+            all_indices.push_back(FT_Get_Char_Index(face, charcode));
+        }
+        const auto outlines = [&]
+        {
+            ScopedSize scoped_size(size->size);
+            return (size_t)FillOutlines(face, all_indices, FT_LOAD_DEFAULT);
+        };
+        Bench(fixture, "outline", outlines, ClearOutlineCache);
+        Bench(fixture, "outline-cached", outlines);
+
+        // Kerning of every pair of the first 128 glyphs
+        clear();
+        render(FT_LOAD_RENDER, 0)();
+        std::vector<FT_UInt> glyph_indices;
+        for (size_t i = 0; i < views.size() && i < 128; i++)
+        {
+            glyph_indices.push_back(views[i].glyph_index);
+        }
+        Bench(fixture, "kerning", [&]
+              {
+            for (FT_UInt left : glyph_indices)
+            {
+                for (FT_UInt right : glyph_indices)
+                {
+                    GetKerningWithSize(size_handle, left, right, FT_KERNING_DEFAULT);
+                }
+            }
+            return glyph_indices.size() * glyph_indices.size(); });
+
+        Bench(fixture, "kerning-pairs", [&]
+              {
+            ScopedSize scoped_size(size->size);
+            FillKerningPairs(face, glyph_indices, FT_KERNING_DEFAULT);
+            return glyph_indices.size() * glyph_indices.size(); });
+
+        Bench(fixture, "convert", [&]
+              {
+            size_t count = 0;
+            for (const GlyphView &view : views)
+            {
+                if (ConvertViewBitmap(view.bitmap, BITMAP_FORMAT_RGBA, 0xffffff))
+                {
+                    count++;
+                }
+            }
+            return count; });
+
+        // Layout of 10000 words of the font's characters, wrapped to 600 pixels
+        std::vector<FT_ULong> text;
+        std::vector<uint32_t> clusters;
+        for (size_t i = 0; i < 10000; i++)
+        {
+            for (size_t j = 0; j < 5; j++)
+            {
+                text.push_back(all_charcodes[(i * 5 + j) % all_charcodes.size()]);
+            }
+            text.push_back(' ');
+        }
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            clusters.push_back(i);
+        }
+        Bench(fixture, "layout", [&]
+              { return (size_t)LayoutCodepoints(size->size, text, clusters, 600 * 64, TEXT_LAYOUT_KERNING, true).glyph_count; });
+
+        // A label of the first words rendered into one buffer
+        const std::vector<FT_ULong> label(text.begin(), text.begin() + 60);
+        Bench(fixture, "render-text", [&]
+              { return RenderCodepoints(size->size, label, clusters, 600, 2 * fixture.pixel_size, 0, BITMAP_FORMAT_ALPHA, 0) ? label.size() : 0; });
+
+        // Fallback of the same text, coverage table lookups only
+        Bench(fixture, "fallback", [&]
+              { return (size_t)ResolveCodepoints({face_handle}, text, clusters); });
+
+        // The first axis animated over 60 frames of the label, each frame
+        // renders the label with the instance at its coordinate. Cold frames
+        // create the instances, cached frames switch between them.
+        VariationInfo variations;
+        if (FT_HAS_MULTIPLE_MASTERS(face) && ReadVariationInfo(face_handle, variations))
+        {
+            const VariationAxis &axis = variations.axes[0];
+            const auto animate = [&]
+            {
+                const int frames = 60;
+                for (int frame = 0; frame < frames; frame++)
+                {
+                    const double coord = axis.minimum + (axis.maximum - axis.minimum) * frame / (frames - 1);
+                    const int instance = GetVariationInstance(face_handle, {coord});
+                    SizeHandle *instance_size = GetSizeHandle(CreatePixelSize(instance, 0, fixture.pixel_size));
+                    RenderCodepoints(instance_size->size, label, clusters, 600, 2 * fixture.pixel_size, 0, BITMAP_FORMAT_ALPHA, 0);
+                }
+                return (size_t)frames;
+            };
+            Bench(fixture, "animate-axis", animate, [&]
+                  { ClearVariationInstances(face_handle); });
+            Bench(fixture, "animate-axis-cached", animate);
+            if (ReadVariationInfo(face_handle, variations) &&
+                (filter.empty() || (std::string(fixture.format) + "/animate-axis").find(filter) != std::string::npos))
+            {
+                fprintf(stderr, "%-20s %d instances, glyph cache %zu bytes\n", "", variations.instances, GetGlyphCacheStats().bytes);
+            }
+        }
+
+        Unload(faces);
+    }
+
+    PrintResults();
+    Cleanup();
+    return 0;
+}
@@ -0,0 +1,494 @@
+// Tests of the wrapper core in the native build, over the fixture fonts. The
+// JS API is tested with test/test.js. See CMakeLists.txt.
+//
+// native_test [fonts dir]
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <freetype/ftadvanc.h>
+#include <freetype/ftmodapi.h>
+
+#include "../src/core.h"
+#include "../src/layout.h"
+
+#ifndef FT_FIXTURE_DIR
+#define FT_FIXTURE_DIR "test/fonts"
+#endif
+
+int failures = 0;
+
+#define CHECK(condition)                                                  \
+    do                                                                    \
+    {                                                                     \
+        if (!(condition))                                                 \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+std::string fonts = FT_FIXTURE_DIR;
+
+std::unique_ptr<FontPtr> ReadFont(const char *file)
+{
+    FILE *f = fopen((fonts + "/" + file).c_str(), "rb");
+    if (f == NULL)
+    {
+        fprintf(stderr, "Unable to read %s/%s\n", fonts.c_str(), file);
+        return nullptr;
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    auto fns = std::make_unique<FontPtr>(size);
+    const size_t read = fread((void *)fns->bytes, 1, size, f);
+    fclose(f);
+    return read == (size_t)size ? std::move(fns) : nullptr;
+}
+
+void TestFontsAndSizes()
+{
+    auto faces = LoadFaces(StoreFont(ReadFont("lato-regular.ttf")));
+    CHECK(faces.size() == 1);
+    CHECK(std::string(faces[0].family_name) == "Lato");
+
+    // Identical bytes are stored once
+    LoadFaces(StoreFont(ReadFont("lato-regular.ttf")));
+    CHECK(GetFontStorageStats().fonts == 1);
+    CHECK(GetFontStorageStats().shared_loads == 1);
+
+    const int face = GetFaceHandle("Lato", "Regular");
+    CHECK(face > 0);
+    CHECK(SelectFaceCharmap(face, FT_ENCODING_UNICODE) != nullptr);
+    const int size = CreatePixelSize(face, 0, 32);
+    CHECK(size > 0);
+    CHECK(CreatePixelSize(face, 0, 32) == size);
+    CHECK(GetSizeHandle(size)->size->metrics.y_ppem == 32);
+
+    // Glyph views are appended to the glyph buffer, the second load is cached
+    std::vector<GlyphView> views;
+    {
+        ScopedSize scoped_size(GetSizeHandle(size)->size);
+        for (int i = 0; i < 2; i++)
+        {
+            views.clear();
+            ForEachGlyph(GetSizeHandle(size)->font->face, {'A', 'V'}, FT_LOAD_RENDER, 0, [&](FT_ULong, const FT_GlyphSlotRec *slot)
+                         { views.push_back(MakeGlyphView(slot)); });
+        }
+    }
+    CHECK(views.size() == 2);
+    CHECK(views[0].bitmap.length == views[0].bitmap.rows * views[0].bitmap.width);
+    CHECK(GetGlyphCacheStats().hits == 2);
+
+    // Lato kerns AV
+    CHECK(GetKerningWithSize(size, views[0].glyph_index, views[1].glyph_index, FT_KERNING_DEFAULT).x < 0);
+    {
+        ScopedSize scoped_size(GetSizeHandle(size)->size);
+        const FT_UInt a = views[0].glyph_index;
+        const FT_UInt v = views[1].glyph_index;
+        CHECK(FillKerningPairs(GetSizeHandle(size)->font->face, {v, a, v}, FT_KERNING_UNSCALED) == 2);
+        CHECK(kerning_pairs[0] == (int32_t)std::min(a, v) && kerning_pairs[3] == (int32_t)std::max(a, v));
+        CHECK(kerning_pairs[a < v ? 2 : 5] == GetKerningWithSize(size, a, v, FT_KERNING_UNSCALED).x);
+
+        // The kern table walk finds the same pairs as looking up every pair
+        FT_Face face = GetSizeHandle(size)->font->face;
+        std::vector<FT_UInt> glyphs;
+        for (FT_UInt glyph_index = 0; glyph_index < 300; glyph_index++)
+        {
+            glyphs.push_back(glyph_index);
+        }
+        int brute_force = 0;
+        for (FT_UInt left : glyphs)
+        {
+            for (FT_UInt right : glyphs)
+            {
+                FT_Vector vector;
+                brute_force += !FT_Get_Kerning(face, left, right, FT_KERNING_UNSCALED, &vector) && vector.x != 0;
+            }
+        }
+        CHECK(brute_force > 0 && FillKerningPairs(face, glyphs, FT_KERNING_UNSCALED) == brute_force);
+    }
+
+    CHECK(ConvertViewBitmap(views[0].bitmap, BITMAP_FORMAT_RGBA, 0xffffff));
+    CHECK(convert_buffer.size() == views[0].bitmap.length * 4);
+
+    // Subpixel bins are cached apart and move the bitmap
+    {
+        ScopedSize scoped_size(GetSizeHandle(size)->size);
+        FT_Face lato = GetSizeHandle(size)->font->face;
+        const FT_UInt o = FT_Get_Char_Index(lato, 'o');
+        const size_t entries = GetGlyphCacheStats().entries;
+        const GlyphView whole = MakeGlyphView(LoadCachedGlyph(lato, o, FT_LOAD_RENDER | FT_LOAD_TARGET_LIGHT, 0));
+        const GlyphView half = MakeGlyphView(LoadCachedGlyph(lato, o, FT_LOAD_RENDER | FT_LOAD_TARGET_LIGHT, 32));
+        CHECK(GetGlyphCacheStats().entries == entries + 2);
+        CHECK(whole.advance.x == half.advance.x);
+        CHECK(memcmp(glyph_buffer.data() + whole.bitmap.offset, glyph_buffer.data() + half.bitmap.offset,
+                     std::min(whole.bitmap.length, half.bitmap.length)) != 0 ||
+              whole.bitmap.width != half.bitmap.width);
+
+        FT_Pos pixel_x;
+        CHECK(SubpixelBin(3 * 64 + 16, 4, &pixel_x) == 1 && pixel_x == 3);
+        CHECK(SubpixelBin(3 * 64 + 60, 4, &pixel_x) == 0 && pixel_x == 4);
+        CHECK(SubpixelBin(-24, 4, &pixel_x) == 3 && pixel_x == -1);
+    }
+
+    // Outlines of A and V, the second load is cached
+    {
+        ScopedSize scoped_size(GetSizeHandle(size)->size);
+        FT_Face lato = GetSizeHandle(size)->font->face;
+        const std::vector<FT_UInt> av = {views[0].glyph_index, views[1].glyph_index};
+        CHECK(FillOutlines(lato, av, FT_LOAD_DEFAULT) == 2);
+        CHECK(FillOutlines(lato, av, FT_LOAD_DEFAULT) == 2 && GetOutlineCacheStats().hits == 2);
+        CHECK(outline_glyphs.size() == 2 * OUTLINE_GLYPH_SIZE && outline_glyphs[5] == views[0].advance.x);
+        CHECK(outline_commands.front() == OUTLINE_MOVE && outline_commands.back() == OUTLINE_CLOSE);
+        size_t points = 0;
+        for (uint8_t command : outline_commands)
+        {
+            points += command == OUTLINE_CLOSE ? 0 : command == OUTLINE_CONIC ? 2 : command == OUTLINE_CUBIC ? 3 : 1;
+        }
+        CHECK(points * 2 == outline_points.size());
+        CHECK(outline_glyphs[OUTLINE_GLYPH_SIZE + 3] == outline_glyphs[4]);
+        // Font units
+        FT_Fixed advance = 0;
+        FT_Get_Advance(lato, av[1], FT_LOAD_NO_SCALE, &advance);
+        CHECK(FillOutlines(lato, av, FT_LOAD_NO_SCALE) == 2 && outline_glyphs[OUTLINE_GLYPH_SIZE + 5] == advance);
+    }
+
+    // Snapshot glyphs are used in place, entries of other font bytes are not
+    // found
+    {
+        ScopedSize scoped_size(GetSizeHandle(size)->size);
+        FT_Face lato = GetSizeHandle(size)->font->face;
+        const FT_GlyphSlotRec *rendered = LoadCachedGlyph(lato, views[0].glyph_index, FT_LOAD_RENDER);
+        const std::vector<unsigned char> pixels(rendered->bitmap.buffer, rendered->bitmap.buffer + rendered->bitmap.rows * rendered->bitmap.pitch);
+        std::vector<unsigned char> snapshot;
+        ExportGlyphSnapshot(snapshot);
+        const size_t entries = GetGlyphCacheStats().entries;
+        CHECK(ImportGlyphSnapshot(std::vector<unsigned char>(snapshot.begin(), snapshot.end() - 1)) == -1);
+        CHECK(ImportGlyphSnapshot(snapshot) == (int)entries);
+        CHECK(GetGlyphCacheStats().entries == 0);
+
+        const FT_GlyphSlotRec *restored = LoadCachedGlyph(lato, views[0].glyph_index, FT_LOAD_RENDER);
+        CHECK(restored->bitmap.buffer >= glyph_snapshot.Pixels() &&
+              restored->bitmap.buffer < glyph_snapshot.Pixels() + glyph_snapshot.PixelsSize());
+        CHECK(std::equal(pixels.begin(), pixels.end(), restored->bitmap.buffer));
+        CHECK(restored->advance.x == views[0].advance.x && restored->bitmap_top == views[0].bitmap_top);
+
+        const GlyphCacheKey key = {lato, lato->size->metrics.x_scale, lato->size->metrics.y_scale, FT_LOAD_RENDER, views[0].glyph_index, 0};
+        SnapshotFont font = {GetSizeHandle(size)->font->bytes->hash, (uint32_t)GetSizeHandle(size)->font->bytes->size, 0};
+        CHECK(glyph_snapshot.Find(font, key) != nullptr);
+        font.hash++;
+        CHECK(glyph_snapshot.Find(font, key) == nullptr);
+        font.hash--;
+
+        // A view uses the caller's bytes, entries with broken bitmaps are not
+        // found
+        CHECK(ImportGlyphSnapshotView(snapshot.data(), snapshot.size()) == (int)entries);
+        CHECK(glyph_snapshot.Pixels() > snapshot.data() && glyph_snapshot.Pixels() < snapshot.data() + snapshot.size());
+        GlyphSnapshotEntry *first = (GlyphSnapshotEntry *)(snapshot.data() + sizeof(GlyphSnapshotHeader));
+        for (size_t i = 0; i < entries; i++)
+        {
+            first[i].bitmap_width = first[i].pitch + 1;
+        }
+        CHECK(glyph_snapshot.Find(font, key) == nullptr);
+        for (size_t i = 0; i < entries; i++)
+        {
+            first[i].bitmap_width = 0;
+            first[i].pixel_mode = 99;
+        }
+        CHECK(glyph_snapshot.Find(font, key) == nullptr);
+        ClearGlyphSnapshot();
+    }
+
+    // SDF batches at a canonical size, the spread is restored after
+    {
+        const std::vector<FT_ULong> charcodes = {'A', 'V', 'o', 0x4e00};
+        const size_t size_count = GetFontByHandle(face)->sizes.size();
+        const SdfBatchInfo outline = RenderSdfBatchWithFace(face, charcodes, 48, 6, SDF_RENDERER_OUTLINE, FT_LOAD_NO_HINTING);
+        CHECK(outline.glyph_count == 3 && outline.outline_glyphs == 3);
+        CHECK(sdf_glyphs.size() == 3 * SDF_GLYPH_SIZE && sdf_glyphs[1] == (int32_t)views[0].glyph_index);
+        const int32_t *last = sdf_glyphs.data() + 2 * SDF_GLYPH_SIZE;
+        CHECK(sdf_pixels.size() == (size_t)(last[8] + last[3] * last[4]));
+        CHECK(sdf_pixels[0] < 128);
+
+        const SdfBatchInfo bitmap = RenderSdfBatchWithFace(face, charcodes, 48, 6, SDF_RENDERER_BITMAP, FT_LOAD_NO_HINTING);
+        CHECK(bitmap.glyph_count == 3 && bitmap.bitmap_glyphs == 3 && sdf_glyphs[2] == SDF_RENDERER_BITMAP);
+        const SdfBatchInfo automatic = RenderSdfBatchWithFace(face, charcodes, 48, 6, SDF_RENDERER_AUTO, FT_LOAD_NO_HINTING);
+        CHECK(automatic.glyph_count == 3 && automatic.outline_glyphs + automatic.bitmap_glyphs == 3);
+        CHECK(sdf_glyphs.size() == 3 * SDF_GLYPH_SIZE);
+        CHECK(RenderSdfBatchWithFace(face, charcodes, 48, 64, SDF_RENDERER_OUTLINE, 0).glyph_count == -1);
+        CHECK(GetFontByHandle(face)->sizes.size() == size_count);
+
+        FT_Int spread = 0;
+        FT_Property_Get(GetOrDeleteLibrary(), "sdf", "spread", &spread);
+        CHECK(spread == 8);
+    }
+
+    // Atlas of the size
+    const int atlas = CreateAtlasWithSize(size, 256, 256, 1, FT_LOAD_DEFAULT, 0);
+    const std::vector<int> *added = AddAtlasGlyphs(atlas, {'A', 'V', 'A'});
+    CHECK(added != nullptr && added->size() == 3 && (*added)[0] == (*added)[2]);
+
+    UnloadFont("Lato");
+    CHECK(GetSizeHandle(size) == nullptr);
+    CHECK(GetFontStorageStats().fonts == 0);
+}
+
+void TestCurrentFace()
+{
+    LoadFaces(StoreFont(ReadFont("fixture-sans-cff.otf")));
+    CHECK(SelectFont("Fixture Sans CFF", "Regular") != nullptr);
+    CHECK(current_face != nullptr);
+    CHECK(SetCurrentSize(std::make_tuple(0, (FT_F26Dot6)24, (FT_F26Dot6)24, 0u, 0u)) == 0);
+    CHECK(SelectCurrentCharmap(FT_ENCODING_UNICODE) == 0);
+    CHECK(SetCurrentCharmapByIndex(100) != 0);
+    // Missing glyphs load the .notdef glyph
+    CHECK(FillGlyphMetrics(current_face, {'a', 'b', 0x4e00}, FT_LOAD_RENDER, 0) == 3);
+    CHECK(glyph_metrics[GLYPH_METRICS_CHARCODE * glyph_metrics_count + 1] == 'b');
+    CHECK(glyph_metrics[GLYPH_METRICS_GLYPH_INDEX * glyph_metrics_count + 2] == 0);
+    CHECK(glyph_metrics[GLYPH_METRICS_ADVANCE_X * glyph_metrics_count] > 0);
+    CHECK(GetKerning(1, 2, FT_KERNING_DEFAULT).x == 0);
+}
+
+void TestWebFontAndCollection()
+{
+    auto faces = LoadFaces(StoreFont(ReadFont("open-sans-regular.woff2")));
+    CHECK(faces.size() == 1);
+    FontSourceInfo info;
+    CHECK(ReadFontSourceInfo(GetFaceHandle("Open Sans", "Regular"), info));
+    CHECK(info.format == FONT_FORMAT_WOFF2 && info.sfnt_size > info.size);
+
+    // Collection faces are opened on first use
+    auto infos = LoadFaceInfos(StoreFont(ReadFont("fixture-sans.ttc")));
+    CHECK(infos.size() == 2);
+    CHECK(!IsFaceOpen(infos[1].face_handle));
+    CoverageInfo coverage;
+    CHECK(ReadFaceCoverage(infos[0].face_handle, coverage) && coverage.codepoints > 0);
+    CHECK(IsFaceOpen(infos[0].face_handle));
+    CHECK(CreatePixelSize(infos[1].face_handle, 0, 16) > 0);
+    CHECK(IsFaceOpen(infos[1].face_handle));
+
+    // Bitmap-only faces render without outlines
+    LoadFaces(StoreFont(ReadFont("fixture-bitmap.bdf")));
+    int count = 0;
+    for (auto &it : face_handles)
+    {
+        FT_Face face = it.second->face;
+        if (face != nullptr && !FT_IS_SCALABLE(face))
+        {
+            FT_Select_Size(face, 0);
+            ForEachCharmapGlyph(face, 'a', 'z', FT_LOAD_RENDER | FT_LOAD_TARGET_MONO, 0, [&](FT_ULong, const FT_GlyphSlotRec *slot)
+                                { count += slot->bitmap.rows > 0; });
+        }
+    }
+    CHECK(count == 26);
+}
+
+void TestLayout()
+{
+    std::vector<FT_ULong> codepoints;
+    std::vector<uint32_t> clusters;
+    DecodeUtf8("a\xc3\xa9\xf0\x9f\x98\x80\xc0\xaf", codepoints, clusters);
+    CHECK(codepoints == std::vector<FT_ULong>({'a', 0xe9, 0x1f600, 0xfffd, 0xfffd}));
+    CHECK(clusters == std::vector<uint32_t>({0, 1, 3, 7, 8}));
+    DecodeUtf16(u"a\U0001f600\xd800", codepoints, clusters);
+    CHECK(codepoints == std::vector<FT_ULong>({'a', 0x1f600, 0xfffd}));
+    CHECK(clusters == std::vector<uint32_t>({0, 1, 3}));
+
+    LoadFaces(StoreFont(ReadFont("lato-regular.ttf")));
+    const int face = GetFaceHandle("Lato", "Regular");
+    SelectFaceCharmap(face, FT_ENCODING_UNICODE);
+    const int size = CreatePixelSize(face, 0, 32);
+
+    // Lato kerns AV
+    const TextMetrics plain = MeasureText(size, "AV", 0, 0);
+    CHECK(plain.line_count == 1 && plain.height == GetSizeHandle(size)->size->metrics.height);
+    CHECK(MeasureText(size, "AV", 0, TEXT_LAYOUT_KERNING).width < plain.width);
+
+    // Lines break at spaces, trailing spaces are not part of the width
+    CHECK(MeasureText(size, " ", 0, 0).width == 0);
+    const TextMetrics word = MeasureText(size, "word", 0, 0);
+    const FT_Pos space = MeasureText(size, "word word", 0, 0).width - word.width * 2;
+    const TextMetrics text = LayoutText(size, "word word  word", word.width * 2 + space, 0);
+    CHECK(space > 0 && text.line_count == 2 && text.width == word.width * 2 + space);
+    CHECK(layout_lines[TEXT_LINE_SIZE] == 11 && layout_lines[TEXT_LINE_SIZE + 2] == word.width);
+    CHECK(layout_lines[TEXT_LINE_SIZE + 3] - layout_lines[3] == GetSizeHandle(size)->size->metrics.height);
+    CHECK(layout_glyphs[11 * TEXT_GLYPH_SIZE + 1] == 0 && layout_glyphs[11 * TEXT_GLYPH_SIZE + 3] == 11);
+
+    // Rendered text is clipped to the buffer, wrapping breaks at its width
+    CHECK(RenderText(size, "word word", 100, 80, TEXT_LAYOUT_WRAP, BITMAP_FORMAT_ALPHA, 0));
+    CHECK(text_pixels.size() == 100 * 80 && layout_lines.size() == 2 * TEXT_LINE_SIZE);
+    const unsigned char *second_line = text_pixels.data() + 100 * ((layout_lines[TEXT_LINE_SIZE + 3] >> 6) - 16);
+    CHECK(*std::max_element(second_line, second_line + 100 * 16) > 0);
+    CHECK(RenderText(size, "word", 16, 8, TEXT_LAYOUT_HINTED, BITMAP_FORMAT_RGBA, 0xff0000));
+    CHECK(text_pixels.size() == 16 * 8 * 4 && text_pixels[0] == 0xff);
+    CHECK(!RenderText(size, "word", 0, 8, 0, BITMAP_FORMAT_ALPHA, 0));
+
+    // Shaped runs are cached
+    {
+        ScopedSize scoped_size(GetSizeHandle(size)->size);
+        FT_Face lato = GetSizeHandle(size)->font->face;
+        if (FT_WASM_HARFBUZZ)
+        {
+            CHECK(ShapeRun(lato, u"AV", "") == 2);
+            CHECK((*shaped_glyphs)[0] == (int32_t)FT_Get_Char_Index(lato, 'A'));
+            CHECK(ShapeRun(lato, u"AV", "") == 2 && GetShapeCacheStats().hits == 1);
+            CHECK(ShapeRun(lato, u"AV", "kern=0") == 2 && GetShapeCacheStats().entries == 2);
+            CHECK(ShapeRun(lato, u"AV", "?") == -1);
+            CHECK(ShapeRun(lato, u"AV", "") == 2);
+            SetShapeCacheBudget(0);
+            CHECK(shaped_glyphs->empty() && GetShapeCacheStats().entries == 0);
+            SetShapeCacheBudget(1 << 20);
+        }
+        else
+        {
+            CHECK(ShapeRun(lato, u"AV", "") == -1 && shaped_glyphs->empty());
+        }
+    }
+
+    // Words longer than the line break between glyphs
+    CHECK(MeasureText(size, "wordword", word.width, 0).line_count == 2);
+    CHECK(MeasureText(size, "a\r\nb\n", 0, 0).line_count == 3);
+
+    // Fallback picks the first face that covers each code point, the CFF
+    // fixture only has ASCII
+    LoadFaces(StoreFont(ReadFont("fixture-sans-cff.otf")));
+    const int cff = GetFaceHandle("Fixture Sans CFF", "Regular");
+    CoverageInfo coverage;
+    CHECK(ReadFaceCoverage(cff, coverage) && coverage.codepoints == 95 && coverage.ranges == 1);
+    CHECK(ResolveFallback({cff, face}, "a\xc3\xa9\xe4\xb8\x80") == 3);
+    CHECK(fallback_glyphs[0] == cff && fallback_glyphs[1] == (int32_t)FT_Get_Char_Index(GetFontByHandle(cff)->face, 'a'));
+    CHECK(fallback_glyphs[3] == face && fallback_glyphs[4] == (int32_t)FT_Get_Char_Index(GetSizeHandle(size)->font->face, 0xe9));
+    CHECK(fallback_glyphs[5] == 1);
+    CHECK(fallback_glyphs[6] == cff && fallback_glyphs[7] == 0 && fallback_glyphs[8] == 3);
+    CHECK(ResolveFallback({-1}, "a") == -1);
+    UnloadFont("Fixture Sans CFF");
+    UnloadFont("Lato");
+}
+
+// Width of the glyph's bitmap rendered with the size
+unsigned int RenderedWidth(int size_handle, FT_ULong charcode)
+{
+    SizeHandle *size = GetSizeHandle(size_handle);
+    ScopedSize scoped_size(size->size);
+    const FT_GlyphSlotRec *slot = LoadCachedGlyph(size->font->face, FT_Get_Char_Index(size->font->face, charcode), FT_LOAD_RENDER);
+    return slot != NULL ? slot->bitmap.width : 0;
+}
+
+void TestVariations()
+{
+    LoadFaces(StoreFont(ReadFont("fixture-sans-var.ttf")));
+    const int face = GetFaceHandle("Fixture Sans Variable", "Regular");
+    SelectFaceCharmap(face, FT_ENCODING_UNICODE);
+    VariationInfo info;
+    CHECK(ReadVariationInfo(face, info) && info.axes.size() == 1 && info.named_instances == 2);
+    CHECK(info.axes[0].tag == "wght" && info.axes[0].minimum == 400 && info.axes[0].maximum == 700);
+
+    // The default is the face, nearby coordinates snap to one instance
+    CHECK(GetVariationInstance(face, {400}) == face && GetVariationInstance(face, {}) == face);
+    const int bold = GetVariationInstance(face, {700});
+    CHECK(bold != face && GetVariationInstance(face, {699.8}) == bold && GetVariationInstance(bold, {800}) == bold);
+    CHECK(GetNamedInstance(face, 1) == bold && GetNamedInstance(face, 0) == face && GetNamedInstance(face, 2) == -1);
+    CHECK(ReadVariationInfo(bold, info) && info.coords[0] == 700 && info.instances == 1);
+    const int medium = GetVariationInstance(face, {550});
+    CHECK(ReadVariationInfo(medium, info) && info.coords[0] > 549 && info.coords[0] < 551 && info.instances == 2);
+
+    // Instances have their own sizes and cached glyphs
+    const int regular_size = CreatePixelSize(face, 0, 32);
+    const int bold_size = CreatePixelSize(bold, 0, 32);
+    ClearGlyphCache();
+    ResetGlyphCacheStats();
+    CHECK(bold_size != regular_size && RenderedWidth(bold_size, 'H') > RenderedWidth(regular_size, 'H'));
+    CHECK(GetGlyphCacheStats().entries == 2);
+    CHECK(MeasureText(bold_size, "H", 0, 0).width > MeasureText(regular_size, "H", 0, 0).width);
+    CHECK(RenderedWidth(bold_size, 'H') > RenderedWidth(regular_size, 'H') && GetGlyphCacheStats().hits == 2);
+
+    // Shaping uses the coordinates of the instance
+    if (FT_WASM_HARFBUZZ)
+    {
+        int32_t regular_advance = 0;
+        {
+            ScopedSize scoped_size(GetSizeHandle(regular_size)->size);
+            CHECK(ShapeRun(GetSizeHandle(regular_size)->font->face, u"H", "") == 1);
+            regular_advance = (*shaped_glyphs)[2];
+        }
+        ScopedSize scoped_size(GetSizeHandle(bold_size)->size);
+        CHECK(ShapeRun(GetSizeHandle(bold_size)->font->face, u"H", "") == 1 && (*shaped_glyphs)[2] > regular_advance);
+    }
+
+    // Workers open the instance with its coordinates
+    unsigned int parallel_width = 0;
+    ClearGlyphCache();
+    ForEachGlyphParallel(GetSizeHandle(bold_size), {'H'}, FT_LOAD_RENDER, 0, [&](FT_ULong, const FT_GlyphSlotRec *slot)
+                         { parallel_width = slot->bitmap.width; });
+    CHECK(parallel_width == RenderedWidth(bold_size, 'H'));
+
+    CHECK(ClearVariationInstances(bold) == 2 && GetSizeHandle(bold_size) == nullptr && !IsFaceOpen(bold));
+    CHECK(GetVariationInstance(face, {700}) != bold);
+
+    LoadFaces(StoreFont(ReadFont("lato-regular.ttf")));
+    CHECK(!ReadVariationInfo(GetFaceHandle("Lato", "Regular"), info) && GetVariationInstance(GetFaceHandle("Lato", "Regular"), {}) == -1);
+    UnloadFont("Lato");
+    UnloadFont("Fixture Sans Variable");
+}
+
+void TestConvert()
+{
+    // Rows flowing up start from the bottom row in memory, as FreeType has
+    // them, and are converted top-down
+    const unsigned char gray_pixels[] = {7, 8, 9, 0, 1, 2, 3, 0};
+    FT_Bitmap gray;
+    memset(&gray, 0, sizeof(gray));
+    gray.pixel_mode = FT_PIXEL_MODE_GRAY;
+    gray.num_grays = 256;
+    gray.width = 3;
+    gray.rows = 2;
+    gray.pitch = -4;
+    gray.buffer = (unsigned char *)gray_pixels;
+    std::vector<unsigned char> alpha(GetConvertedBytes(gray, BITMAP_FORMAT_ALPHA));
+    CHECK(ConvertBitmapScalar(gray, BITMAP_FORMAT_ALPHA, 0, alpha.data()));
+    CHECK(alpha == std::vector<unsigned char>({1, 2, 3, 7, 8, 9}));
+
+    const unsigned char mono_pixels[] = {0x80, 0x40, 0xff, 0x00};
+    FT_Bitmap mono = gray;
+    mono.pixel_mode = FT_PIXEL_MODE_MONO;
+    mono.num_grays = 2;
+    mono.width = 10;
+    mono.pitch = -2;
+    mono.buffer = (unsigned char *)mono_pixels;
+    alpha.resize(GetConvertedBytes(mono, BITMAP_FORMAT_ALPHA));
+    CHECK(ConvertBitmapScalar(mono, BITMAP_FORMAT_ALPHA, 0, alpha.data()));
+    CHECK(alpha == std::vector<unsigned char>({255, 255, 255, 255, 255, 255, 255, 255, 0, 0,
+                                               255, 0, 0, 0, 0, 0, 0, 0, 0, 255}));
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        fonts = argv[1];
+    }
+
+    TestFontsAndSizes();
+    TestCurrentFace();
+    TestWebFontAndCollection();
+    TestLayout();
+    TestVariations();
+    TestConvert();
+
+    Cleanup();
+    CHECK(GetMemoryStats().live_bytes == 0);
+
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All native tests passed\n");
+    return 0;
+}
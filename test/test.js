@@ -9,12 +9,30 @@ async function createFontFromUrl(url) {
     return face;
 }
 
-async function createGoogleFont(fontName) {
+async function createFontFromUrlToBuffer(url) {
+    const font = await fetch(url);
+    const bytes = new Uint8Array(await font.arrayBuffer());
+    const address = Freetype.AllocateFontBuffer(bytes.length);
+    if (!address) {
+        throw new Error("Font buffer not allocated");
+    }
+    Freetype.GetFontBufferView(address)?.set(bytes);
+    return Freetype.LoadFontFromBuffer(address);
+}
+
+async function getGoogleFontUrl(fontName) {
     const url = `https://fonts.googleapis.com/css?family=${fontName}&text=D`;
     const css = await fetch(url);
     const text = await css.text();
     const urls = [...text.matchAll(/url\(([^\(\)]+)\)/g)].map((m) => m[1]);
-    return await createFontFromUrl(urls[0]);
+    return urls[0];
+}
+
+async function createGoogleFont(fontName, toBuffer = false) {
+    const urls = [await getGoogleFontUrl(fontName)];
+    return toBuffer
+        ? await createFontFromUrlToBuffer(urls[0])
+        : await createFontFromUrl(urls[0]);
 }
 
 /**
@@ -50,7 +68,16 @@ function consoleDrawGlyph(glyph) {
 }
 
 const font = await createGoogleFont("Karla");
-const font2 = await createGoogleFont("Karla");
+const font2 = await createGoogleFont("Karla", true);
+const storage = Freetype.GetFontStorageStats();
+console.assert(
+    font2.length === font.length &&
+        storage.fonts === 1 &&
+        storage.shared_loads === 1 &&
+        storage.pending_bytes === 0,
+    "🔴 Identical fonts not shared",
+    storage
+);
 const setf = Freetype.SetFont("Karla", "Regular");
 const charm = Freetype.SetCharmap(Freetype.FT_ENCODING_UNICODE);
 const size = Freetype.SetPixelSize(16, 0);
@@ -62,6 +89,16 @@ const charsmono = Freetype.LoadGlyphsFromCharmap(
         Freetype.FT_LOAD_MONOCHROME |
         Freetype.FT_LOAD_TARGET_MONO
 );
+Freetype.ResetGlyphCacheStats();
+Freetype.LoadGlyphsFromCharmap(0, 9999, Freetype.FT_LOAD_RENDER);
+const cacheStats = Freetype.GetGlyphCacheStats();
+const sliced = new Map();
+for (let slice = null, next = 0; !slice?.done; next = slice.next_charcode) {
+    slice = Freetype.LoadGlyphsFromCharmapSliced(next, 9999, Freetype.FT_LOAD_RENDER, false, 1, 0);
+    slice.glyphs.forEach((glyph, charcode) => sliced.set(charcode, glyph));
+    console.assert(slice.glyphs.size <= 1, "🔴 Slice over the glyph limit");
+}
+console.assert(sliced.size === chars.size, "🔴 Sliced glyphs differ");
 const monod = charsmono.get(0x44); // 0x33 = letter D
 const chard = chars.get(0x44);
 if (!chard || !monod) {
@@ -84,6 +121,11 @@ console.assert(
     font2
 );
 console.assert(size.x_ppem === 16, "🔴 Font size not proper", size);
+console.assert(
+    cacheStats.hits === chars.size && cacheStats.misses === 0,
+    "🔴 Glyphs were not loaded from the glyph cache",
+    cacheStats
+);
 console.assert(chars.size > 1, "🔴 Antialized glyphs not loaded", chars.size);
 console.assert(
     charsmono.size > 1,
@@ -109,6 +151,341 @@ console.assert(
     monod.bitmap.pixel_mode
 );
 
+const views = Freetype.LoadGlyphViews([0x44], Freetype.FT_LOAD_RENDER, false);
+const viewd = views.get(0x44);
+const glyphBuffer = Freetype.GetGlyphBuffer();
+console.assert(viewd != null, "🔴 Glyph view not loaded");
+console.assert(
+    viewd.bitmap.offset + viewd.bitmap.length <= glyphBuffer.length &&
+        viewd.bitmap.length === viewd.bitmap.rows * viewd.bitmap.pitch,
+    "🔴 Glyph view is not in the glyph buffer",
+    viewd.bitmap
+);
+console.assert(
+    Freetype.GetGlyphImageData(viewd.bitmap)?.data.length ===
+        chard.bitmap.imagedata?.data.length,
+    "🔴 Glyph view image data differs"
+);
+const alpha = Freetype.ConvertGlyphBitmap(
+    viewd.bitmap,
+    Freetype.BITMAP_FORMAT_ALPHA,
+    0
+);
+console.assert(
+    alpha?.length === viewd.bitmap.rows * viewd.bitmap.width &&
+        alpha.every(
+            (a, i) => a === chard.bitmap.imagedata?.data[i * 4 + 3]
+        ),
+    "🔴 Alpha conversion differs from image data"
+);
+const metricsCount = Freetype.LoadGlyphMetrics(
+    new Uint32Array([0x44, 0x45]),
+    Freetype.FT_LOAD_RENDER,
+    false
+);
+const column = (c) => Freetype.GetGlyphMetricsColumn(c);
+console.assert(
+    metricsCount === 2 &&
+        column(Freetype.GLYPH_METRICS_CHARCODE)?.[0] === 0x44 &&
+        column(Freetype.GLYPH_METRICS_GLYPH_INDEX)?.[0] === chard.glyph_index &&
+        column(Freetype.GLYPH_METRICS_ADVANCE_X)?.[0] === chard.advance.x &&
+        column(Freetype.GLYPH_METRICS_BITMAP_ROWS)?.[0] === chard.bitmap.rows &&
+        column(Freetype.GLYPH_METRICS_BITMAP_LEFT)?.[0] === chard.bitmap_left,
+    "🔴 Glyph metrics columns differ from the glyph"
+);
+Freetype.ClearGlyphBuffer();
+console.assert(
+    Freetype.GetGlyphBuffer().length === 0,
+    "🔴 Glyph buffer not cleared"
+);
+
+const atlas = Freetype.CreateAtlas(256, 256, 1, Freetype.FT_LOAD_DEFAULT, false);
+const added = Freetype.AtlasAddGlyphs(atlas, [0x44, 0x45, 0x20, 0x44]);
+console.assert(
+    added != null && added[0] === 0 && added[1] === 1 && added[3] === 0,
+    "🔴 Atlas entries not added",
+    added
+);
+const entries = Freetype.AtlasGetEntries(atlas);
+const entryd = entries?.subarray(0, Freetype.ATLAS_ENTRY_SIZE);
+console.assert(
+    entryd?.[0] === chard.glyph_index &&
+        entryd?.[4] === chard.bitmap.width &&
+        entryd?.[5] === chard.bitmap.rows,
+    "🔴 Atlas entry differs from the glyph",
+    entryd
+);
+const dirty = Freetype.AtlasGetDirtyRects(atlas);
+console.assert(
+    dirty?.length === 5 && Freetype.AtlasGetPageCount(atlas) === 1,
+    "🔴 Atlas dirty rect not reported",
+    dirty
+);
+Freetype.AtlasClearDirtyRects(atlas);
+Freetype.AtlasAddGlyphs(atlas, [0x44]);
+console.assert(
+    Freetype.AtlasGetDirtyRects(atlas)?.length === 0,
+    "🔴 Atlas re-rendered an existing glyph"
+);
+Freetype.DestroyAtlas(atlas);
+
+const faceh = Freetype.GetFaceHandle("Karla", "Regular");
+const source = Freetype.GetFontSourceInfo(faceh);
+console.assert(
+    source !== null &&
+        source.size === storage.bytes &&
+        (source.format === Freetype.FONT_FORMAT_SFNT
+            ? source.sfnt_size === source.size
+            : source.sfnt_size > 0),
+    "🔴 Font source not reported",
+    source
+);
+const small = Freetype.CreatePixelSize(faceh, 12, 0);
+const large = Freetype.CreatePixelSize(faceh, 48, 0);
+console.assert(
+    small !== -1 &&
+        small === Freetype.CreatePixelSize(faceh, 12, 0) &&
+        Freetype.GetSizeMetrics(small)?.x_ppem === 12 &&
+        Freetype.GetSizeMetrics(large)?.x_ppem === 48,
+    "🔴 Size handles not created"
+);
+const smalld = Freetype.LoadGlyphsWithSize(small, [0x44], Freetype.FT_LOAD_RENDER, false).get(0x44);
+const larged = Freetype.LoadGlyphsWithSize(large, [0x44], Freetype.FT_LOAD_RENDER, false).get(0x44);
+console.assert(
+    smalld && larged && smalld.bitmap.rows < larged.bitmap.rows,
+    "🔴 Size handles render the same size"
+);
+console.assert(
+    Freetype.LoadGlyphs([0x44], Freetype.FT_LOAD_RENDER, false).get(0x44)?.bitmap.rows === chard.bitmap.rows,
+    "🔴 Size handles changed the current size"
+);
+const parallelViews = Freetype.LoadGlyphViewsParallel(large, [0x44, 0x44], Freetype.FT_LOAD_RENDER, false);
+console.assert(
+    Freetype.GetWorkerCount() === 1 &&
+        parallelViews.get(0x44)?.bitmap.rows === larged.bitmap.rows,
+    "🔴 Parallel glyph differs"
+);
+const measured = Freetype.MeasureText(small, "D", 0, 0);
+const measured3 = Freetype.MeasureText(small, "DDD", 0, Freetype.TEXT_LAYOUT_KERNING);
+console.assert(
+    measured.width > 0 &&
+        measured.line_count === 1 &&
+        measured3.width === 3 * measured.width &&
+        measured3.glyph_count === 3,
+    "🔴 Text not measured",
+    measured3
+);
+const laidOut = Freetype.LayoutText(small, "DDDD\nD", Math.floor(2.5 * measured.width), 0);
+const layoutGlyphs = Freetype.GetLayoutGlyphs();
+const layoutLines = Freetype.GetLayoutLines();
+console.assert(
+    laidOut.line_count === 3 &&
+        layoutLines.length === 3 * Freetype.TEXT_LINE_SIZE &&
+        layoutLines[1] === 2 &&
+        layoutGlyphs.length === 5 * Freetype.TEXT_GLYPH_SIZE &&
+        layoutGlyphs[2 * Freetype.TEXT_GLYPH_SIZE + 1] === 0 &&
+        layoutGlyphs[4 * Freetype.TEXT_GLYPH_SIZE + 3] === 5,
+    "🔴 Text not laid out",
+    laidOut
+);
+const textPixels = Freetype.RenderText(small, "DD D", 40, 20, 0, Freetype.BITMAP_FORMAT_RGBA, 0x00ff00);
+console.assert(
+    textPixels !== null && textPixels.length === 40 * 20 * 4 && textPixels.some((v, i) => i % 4 === 3 && v > 0),
+    "🔴 Text not rendered",
+    textPixels
+);
+// Lato kerns AV
+const [latoFace] = await createFontFromUrl(new URL("./fonts/lato-regular.ttf", import.meta.url));
+const latoSize = Freetype.CreatePixelSize(Freetype.GetFaceHandle(latoFace.family_name, latoFace.style_name), 32, 0);
+const latoGlyphs = Freetype.LoadGlyphsWithSize(latoSize, [0x41, 0x56], Freetype.FT_LOAD_RENDER, false);
+const latoA = latoGlyphs.get(0x41)?.glyph_index ?? 0;
+const latoV = latoGlyphs.get(0x56)?.glyph_index ?? 0;
+const kerningPairs = Freetype.GetKerningPairsWithSize(latoSize, [latoV, latoA], 0);
+const kerningAV = Array.from({ length: (kerningPairs?.length ?? 0) / Freetype.KERNING_PAIR_SIZE }, (_, i) =>
+    kerningPairs.subarray(i * Freetype.KERNING_PAIR_SIZE, (i + 1) * Freetype.KERNING_PAIR_SIZE)
+).find(([left, right]) => left === latoA && right === latoV);
+console.assert(
+    kerningPairs !== null &&
+        kerningPairs.length % Freetype.KERNING_PAIR_SIZE === 0 &&
+        kerningAV !== undefined &&
+        kerningAV[2] < 0 &&
+        kerningAV[2] === Freetype.GetKerningWithSize(latoSize, latoA, latoV, 0).x,
+    "🔴 Kerning pairs not exported",
+    kerningPairs
+);
+Freetype.DestroySize(latoSize);
+Freetype.UnloadFont(latoFace.family_name);
+if (Freetype.SHAPING_ENABLED) {
+    const shapedCount = Freetype.ShapeText(small, "DD", "");
+    const shaped = Freetype.GetShapedGlyphs();
+    Freetype.ShapeText(small, "DD", "");
+    console.assert(
+        shapedCount === 2 &&
+            shaped[0] === smalld.glyph_index &&
+            shaped[Freetype.SHAPED_GLYPH_SIZE + 1] === 1 &&
+            shaped[2] > 0 &&
+            Freetype.GetShapeCacheStats().hits === 1,
+        "🔴 Text not shaped",
+        shaped
+    );
+} else {
+    console.assert(Freetype.ShapeText(small, "DD", "") === -1, "🔴 Shaped without HarfBuzz");
+}
+Freetype.LoadGlyphViewsWithSize(large, [0x44], Freetype.FT_LOAD_RENDER, false);
+const glyphSnapshot = Freetype.ExportGlyphSnapshot().slice();
+const snapshotEntries = Freetype.ImportGlyphSnapshot(glyphSnapshot);
+const snapshotView = Freetype.LoadGlyphViewsWithSize(large, [0x44], Freetype.FT_LOAD_RENDER, false).get(0x44);
+console.assert(
+    snapshotEntries > 0 &&
+        Freetype.GetGlyphSnapshotEntries().length === snapshotEntries * Freetype.GLYPH_SNAPSHOT_ENTRY_SIZE &&
+        snapshotView.glyph_index === larged.glyph_index &&
+        snapshotView.bitmap.width === larged.bitmap.width &&
+        Freetype.ImportGlyphSnapshot(glyphSnapshot.subarray(1)) === -1,
+    "🔴 Glyph snapshot not imported",
+    snapshotView
+);
+const snapshotAddress = Freetype.AllocateGlyphSnapshotBuffer(glyphSnapshot.length);
+Freetype.GetGlyphSnapshotBufferView(snapshotAddress)?.set(glyphSnapshot);
+const snapshotPixels = Freetype.ImportGlyphSnapshotFromBuffer(snapshotAddress) === snapshotEntries
+    ? Freetype.GetGlyphSnapshotPixels()
+    : null;
+console.assert(
+    snapshotPixels !== null &&
+        snapshotPixels.byteOffset > snapshotAddress &&
+        snapshotPixels.byteOffset < snapshotAddress + glyphSnapshot.length,
+    "🔴 Glyph snapshot not imported in place",
+    snapshotPixels
+);
+Freetype.ClearGlyphSnapshot();
+const sdfBatch = Freetype.RenderSdf(faceh, [0x44, 0x4e00], 48, 6, Freetype.SDF_RENDERER_AUTO, Freetype.FT_LOAD_NO_HINTING);
+const sdfGlyphs = Freetype.GetSdfGlyphs();
+console.assert(
+    sdfBatch.glyph_count === 1 &&
+        sdfGlyphs[1] === larged.glyph_index &&
+        Freetype.GetSdfPixels().length === sdfGlyphs[3] * sdfGlyphs[4] &&
+        Freetype.RenderSdf(faceh, [0x44], 48, 1, Freetype.SDF_RENDERER_AUTO, 0).glyph_count === -1,
+    "🔴 SDF batch not rendered",
+    sdfBatch
+);
+const fallbackCount = Freetype.ResolveFallback([faceh], "D\u4e00");
+const fallback = Freetype.GetFallbackGlyphs();
+console.assert(
+    fallbackCount === 2 &&
+        fallback[0] === faceh &&
+        fallback[1] === larged.glyph_index &&
+        fallback[Freetype.FALLBACK_GLYPH_SIZE + 2] === 1 &&
+        Freetype.GetFaceCoverage(faceh).codepoints > 0,
+    "🔴 Fallback not resolved",
+    fallback
+);
+const subpixel = Freetype.LoadSubpixelGlyphViewsWithSize(large, [0x44], 4, Freetype.FT_LOAD_RENDER | Freetype.FT_LOAD_TARGET_LIGHT);
+const subpixelViews = subpixel.get(0x44);
+console.assert(
+    subpixelViews.length === 4 &&
+        subpixelViews.every((view) => view.advance.x === subpixelViews[0].advance.x) &&
+        Freetype.LoadSubpixelGlyphViewsWithSize(large, [0x44], 0, Freetype.FT_LOAD_RENDER) === null,
+    "🔴 Subpixel glyphs not loaded",
+    subpixelViews
+);
+const outlineCount = Freetype.LoadOutlinesWithSize(large, [larged.glyph_index], 0);
+const outlineGlyphs = Freetype.GetOutlineGlyphs();
+const outlineCommands = Freetype.GetOutlineCommands();
+console.assert(
+    outlineCount === 1 &&
+        outlineGlyphs[0] === larged.glyph_index &&
+        outlineGlyphs[2] === outlineCommands.length &&
+        outlineCommands[0] === Freetype.OUTLINE_MOVE &&
+        outlineCommands[outlineCommands.length - 1] === Freetype.OUTLINE_CLOSE &&
+        Freetype.GetOutlinePoints().length === 2 * outlineGlyphs[4],
+    "🔴 Outline not exported",
+    outlineGlyphs
+);
+const faceMemory = Freetype.GetFaceMemoryStats(faceh);
+const memory = Freetype.GetMemoryStats();
+console.assert(
+    faceMemory !== null &&
+        faceMemory.live_bytes > 0 &&
+        faceMemory.peak_bytes >= faceMemory.live_bytes &&
+        memory.live_bytes > faceMemory.live_bytes,
+    "🔴 Face memory not accounted",
+    faceMemory
+);
+Freetype.DestroySize(large);
+console.assert(Freetype.GetSizeMetrics(large) === null, "🔴 Size not destroyed");
+
+// Faces of the fixture collection are opened one by one on first use
+const lazyBytes = new Uint8Array(
+    await (await fetch(new URL("./fonts/fixture-sans.ttc", import.meta.url))).arrayBuffer()
+);
+const lazyFaces = Freetype.LoadFontCollection(lazyBytes);
+const [lazyFace, lazyMono] = lazyFaces;
+console.assert(
+    lazyFaces.length === 2 &&
+        lazyFace.family_name === "Fixture Sans" &&
+        lazyMono.family_name === "Fixture Sans Mono" &&
+        !Freetype.IsFaceOpen(lazyFace.face_handle) &&
+        !Freetype.IsFaceOpen(lazyMono.face_handle),
+    "🔴 Collection face opened on load",
+    lazyFaces
+);
+const lazySet = Freetype.SetFont(lazyFace.family_name, lazyFace.style_name);
+console.assert(
+    lazySet?.family_name === lazyFace.family_name &&
+        Freetype.IsFaceOpen(lazyFace.face_handle) &&
+        !Freetype.IsFaceOpen(lazyMono.face_handle),
+    "🔴 Collection face not opened by SetFont"
+);
+const lazyMonoSize = Freetype.CreatePixelSize(lazyMono.face_handle, 0, 16);
+console.assert(
+    lazyMonoSize > 0 && Freetype.IsFaceOpen(lazyMono.face_handle),
+    "🔴 Collection face not opened by a size"
+);
+Freetype.DestroySize(lazyMonoSize);
+Freetype.SetFaceIdleTimeout(1);
+Freetype.SetFont("Karla", "Regular");
+await new Promise((resolve) => setTimeout(resolve, 5));
+console.assert(
+    Freetype.EvictIdleFaces() === 2 &&
+        !Freetype.IsFaceOpen(lazyFace.face_handle) &&
+        !Freetype.IsFaceOpen(lazyMono.face_handle) &&
+        Freetype.IsFaceOpen(faceh),
+    "🔴 Idle collection faces not closed"
+);
+Freetype.SetFaceIdleTimeout(0);
+Freetype.UnloadFont(lazyFace.family_name);
+Freetype.UnloadFont(lazyMono.family_name);
+
+// Variation instances of the fixture, snapped coordinates share an instance
+const [varFace] = await createFontFromUrl(new URL("./fonts/fixture-sans-var.ttf", import.meta.url));
+const varHandle = Freetype.GetFaceHandle(varFace.family_name, varFace.style_name);
+const varInfo = Freetype.GetVariationInfo(varHandle);
+const boldHandle = Freetype.GetVariationInstance(varHandle, [700]);
+console.assert(
+    varInfo !== null &&
+        varInfo.axes[0].tag === "wght" &&
+        varInfo.named_instances === 2 &&
+        Freetype.GetVariationInstance(varHandle, [400]) === varHandle &&
+        boldHandle !== varHandle &&
+        Freetype.GetVariationInstance(varHandle, [699.9]) === boldHandle &&
+        Freetype.GetNamedInstance(varHandle, 1) === boldHandle &&
+        Freetype.GetVariationInfo(boldHandle)?.coords[0] === 700,
+    "🔴 Variation instance not shared",
+    varInfo
+);
+Freetype.UnloadFont(varFace.family_name);
+
+Freetype.ResetStats();
+Freetype.ClearGlyphCache();
+Freetype.LoadGlyphs([68, 69], Freetype.FT_LOAD_RENDER, 0);
+const hotStats = Freetype.GetStats();
+console.assert(
+    Freetype.STATS_ENABLED
+        ? hotStats.api_calls === 2 && hotStats.glyph_loads === 2 && hotStats.glyph_renders === 2
+        : hotStats.api_calls === 0 && hotStats.glyph_loads === 0,
+    "🔴 Stats not collected",
+    hotStats
+);
+
 console.log("You should see an antialiaised letter D in the console:");
 consoleDrawGlyph(chard);
 
@@ -0,0 +1,67 @@
+// @ts-check
+// Tests the pthreads build, run with `node test/threads.js`
+import { readFile } from "node:fs/promises";
+import FreetypeInit from "../dist/freetype-threads.js";
+const Freetype = await FreetypeInit();
+
+async function createFixtureFont(file) {
+    const bytes = await readFile(new URL(`./fonts/${file}`, import.meta.url));
+    return Freetype.LoadFontFromBytes(new Uint8Array(bytes));
+}
+
+/**
+ * Loads the charmap with `workers` threads, and returns the glyph views with
+ * copies of their bitmaps
+ * @param {number} size
+ * @param {number} workers
+ */
+function loadCharmap(size, workers) {
+    Freetype.SetWorkerCount(workers);
+    Freetype.ClearGlyphCache();
+    Freetype.ClearGlyphBuffer();
+    const views = Freetype.LoadGlyphViewsFromCharmapParallel(
+        size,
+        0,
+        0xffff,
+        Freetype.FT_LOAD_RENDER,
+        false
+    );
+    const buffer = Freetype.GetGlyphBuffer();
+    return [...views].map(([charcode, view]) => [
+        charcode,
+        view.glyph_index,
+        view.advance.x,
+        buffer.slice(
+            view.bitmap.offset,
+            view.bitmap.offset + view.bitmap.length
+        ),
+    ]);
+}
+
+const [font] = await createFixtureFont("lato-regular.ttf");
+const face = Freetype.GetFaceHandle(font.family_name, font.style_name);
+const size = Freetype.CreatePixelSize(face, 48, 0);
+
+const workers = navigator.hardwareConcurrency ?? 4;
+console.assert(
+    Freetype.SetWorkerCount(workers) >= 1,
+    "🔴 Worker count not set"
+);
+
+const serial = loadCharmap(size, 1);
+const parallel = loadCharmap(size, workers);
+console.assert(serial.length > 0, "🔴 No glyphs loaded");
+console.assert(
+    parallel.length === serial.length &&
+        parallel.every(
+            ([charcode, index, advance, pixels], i) =>
+                charcode === serial[i][0] &&
+                index === serial[i][1] &&
+                advance === serial[i][2] &&
+                pixels.every((p, j) => p === serial[i][3][j])
+        ),
+    "🔴 Parallel glyphs differ from serial glyphs"
+);
+
+Freetype.Cleanup();
+console.log("✅ Threads test finished");